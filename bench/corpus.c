@@ -0,0 +1,187 @@
+#include "./corpus.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const bench_shape__names[BenchShapeCount] = {
+  [BenchShapeTables] = "tables",
+  [BenchShapeDotted] = "dotted",
+  [BenchShapeNumbers] = "numbers",
+  [BenchShapeStrings] = "strings",
+  [BenchShapeComments] = "comments",
+};
+
+static const char *const bench__words[] = {
+  "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel",
+  "india", "juliett", "kilo", "lima", "mike", "november", "oscar", "papa",
+};
+
+#define BENCH_WORD_COUNT (sizeof(bench__words) / sizeof(bench__words[0]))
+
+const char *bench_shape_name(BenchShape shape) {
+  return shape < BenchShapeCount ? bench_shape__names[shape] : NULL;
+}
+
+BenchShape bench_shape_find(const char *name) {
+  for (unsigned i = 0; i < BenchShapeCount; i++) {
+    if (strcmp(bench_shape__names[i], name) == 0) return (BenchShape)i;
+  }
+  return BenchShapeCount;
+}
+
+void bench_buffer_delete(BenchBuffer *buffer) {
+  free(buffer->data);
+  buffer->data = NULL;
+  buffer->length = 0;
+  buffer->capacity = 0;
+}
+
+static bool bench_buffer__reserve(BenchBuffer *self, size_t additional) {
+  if (self->length + additional + 1 <= self->capacity) return true;
+
+  size_t capacity = self->capacity ? self->capacity : 4096;
+  while (capacity < self->length + additional + 1) capacity *= 2;
+  char *data = realloc(self->data, capacity);
+  if (!data) return false;
+
+  self->data = data;
+  self->capacity = capacity;
+  return true;
+}
+
+static bool bench_buffer__append(BenchBuffer *self, const char *text) {
+  size_t length = strlen(text);
+  if (!bench_buffer__reserve(self, length)) return false;
+  memcpy(self->data + self->length, text, length + 1);
+  self->length += length;
+  return true;
+}
+
+static bool bench_buffer__printf(BenchBuffer *self, const char *format, ...) {
+  char line[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  if (length < 0 || (size_t)length >= sizeof(line)) return false;
+  return bench_buffer__append(self, line);
+}
+
+// xorshift64*, good enough to vary the shapes and fully reproducible
+static uint64_t bench__next(uint64_t *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 0x2545f4914f6cdd1d;
+}
+
+static const char *bench__word(uint64_t *state) {
+  return bench__words[bench__next(state) % BENCH_WORD_COUNT];
+}
+
+static bool bench__tables(BenchBuffer *buffer, size_t size, uint64_t *state) {
+  for (uint64_t i = 0; buffer->length < size; i++) {
+    bool ok = bench_buffer__printf(buffer, "[%s_%llu]\n", bench__word(state), (unsigned long long)i)
+      && bench_buffer__printf(buffer, "name = \"%s %s\"\n", bench__word(state), bench__word(state))
+      && bench_buffer__printf(buffer, "count = %llu\n", (unsigned long long)(bench__next(state) % 100000))
+      && bench_buffer__printf(buffer, "enabled = %s\n\n", bench__next(state) & 1 ? "true" : "false");
+    if (!ok) return false;
+  }
+  return true;
+}
+
+static bool bench__dotted(BenchBuffer *buffer, size_t size, uint64_t *state) {
+  for (uint64_t i = 0; buffer->length < size; i++) {
+    // a fresh first segment for every line keeps the keys from being redefined
+    if (!bench_buffer__printf(buffer, "root_%llu", (unsigned long long)i)) return false;
+    unsigned depth = 4 + (unsigned)(bench__next(state) % 12);
+    for (unsigned j = 0; j < depth; j++) {
+      const char *format = bench__next(state) % 4 ? ".%s" : ".\"%s\"";
+      if (!bench_buffer__printf(buffer, format, bench__word(state))) return false;
+    }
+    if (!bench_buffer__printf(buffer, " = %llu\n", (unsigned long long)(bench__next(state) % 1000))) return false;
+  }
+  return true;
+}
+
+static bool bench__numbers(BenchBuffer *buffer, size_t size, uint64_t *state) {
+  if (!bench_buffer__append(buffer, "numbers = [\n")) return false;
+
+  // leave room for the closing bracket so the document stays close to `size`
+  while (buffer->length + 2 < size) {
+    if (!bench_buffer__append(buffer, " ")) return false;
+    for (unsigned i = 0; i < 16; i++) {
+      uint64_t value = bench__next(state);
+      bool ok;
+      switch (value % 6) {
+        case 0: ok = bench_buffer__printf(buffer, " %lld,", (long long)(value >> 8) % 1000000 - 500000); break;
+        case 1: ok = bench_buffer__printf(buffer, " 0x%llx,", (unsigned long long)(value >> 40)); break;
+        case 2: ok = bench_buffer__printf(buffer, " 1_%03llu_%03llu,", (unsigned long long)(value >> 8) % 1000, (unsigned long long)(value >> 20) % 1000); break;
+        case 3: ok = bench_buffer__printf(buffer, " %.6f,", (double)(value >> 11) / 9007199254740992.0 * 1000); break;
+        case 4: ok = bench_buffer__printf(buffer, " %.3e,", (double)(value >> 11) / 9007199254740992.0 * 1e300); break;
+        default: ok = bench_buffer__printf(buffer, " %llu.5,", (unsigned long long)(value >> 8) % 100); break;
+      }
+      if (!ok) return false;
+    }
+    if (!bench_buffer__append(buffer, "\n")) return false;
+  }
+
+  return bench_buffer__append(buffer, "]\n");
+}
+
+static bool bench__strings(BenchBuffer *buffer, size_t size, uint64_t *state) {
+  // four strings, alternating basic and literal, each about a quarter of the document
+  size_t string_size = size / 4 > 1024 ? size / 4 : 1024;
+
+  for (unsigned i = 0; buffer->length < size; i++) {
+    bool basic = i % 2 == 0;
+    if (!bench_buffer__printf(buffer, "text_%u = %s\n", i, basic ? "\"\"\"" : "'''")) return false;
+
+    size_t end = buffer->length + string_size;
+    while (buffer->length < end) {
+      for (unsigned j = 0; j < 10; j++) {
+        if (!bench_buffer__printf(buffer, "%s ", bench__word(state))) return false;
+      }
+      uint64_t extra = bench__next(state) % 8;
+      const char *tail = extra == 0 ? (basic ? "\\t\"quoted\" \\u00e9\n" : "'quoted' \\raw\n")
+        : extra == 1 ? (basic ? "two quotes \"\" here\n" : "two quotes '' here\n")
+        : extra == 2 && basic ? "continued \\\n    "
+        : "\n";
+      if (!bench_buffer__append(buffer, tail)) return false;
+    }
+
+    if (!bench_buffer__append(buffer, basic ? "\"\"\"\n\n" : "'''\n\n")) return false;
+  }
+  return true;
+}
+
+static bool bench__comments(BenchBuffer *buffer, size_t size, uint64_t *state) {
+  for (uint64_t i = 0; buffer->length < size; i++) {
+    unsigned lines = 16 + (unsigned)(bench__next(state) % 48);
+    for (unsigned j = 0; j < lines; j++) {
+      bool ok = bench_buffer__printf(buffer, "# %s %s %s %s %s %s %s %s\n",
+        bench__word(state), bench__word(state), bench__word(state), bench__word(state),
+        bench__word(state), bench__word(state), bench__word(state), bench__word(state));
+      if (!ok) return false;
+    }
+    if (!bench_buffer__printf(buffer, "key_%llu = \"%s\"  # trailing\n", (unsigned long long)i, bench__word(state))) return false;
+  }
+  return true;
+}
+
+bool bench_generate(BenchShape shape, size_t size, uint64_t seed, BenchBuffer *buffer) {
+  uint64_t state = seed ? seed : 0x9e3779b97f4a7c15;
+  buffer->length = 0;
+  if (!bench_buffer__reserve(buffer, size + 4096)) return false;
+  buffer->data[0] = '\0';
+
+  switch (shape) {
+    case BenchShapeTables: return bench__tables(buffer, size, &state);
+    case BenchShapeDotted: return bench__dotted(buffer, size, &state);
+    case BenchShapeNumbers: return bench__numbers(buffer, size, &state);
+    case BenchShapeStrings: return bench__strings(buffer, size, &state);
+    case BenchShapeComments: return bench__comments(buffer, size, &state);
+    default: return false;
+  }
+}
@@ -0,0 +1,47 @@
+#ifndef TREE_SITTER_TOML_BENCH_CORPUS_H_
+#define TREE_SITTER_TOML_BENCH_CORPUS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ *  Synthetic TOML documents for the benchmarks.
+ *
+ *  Each shape stresses one part of the grammar or the external scanner and
+ *  is generated deterministically from a seed, so two runs of the same build
+ *  parse byte-for-byte identical input.
+ */
+
+typedef enum {
+  BenchShapeTables,     // many small `[table]` sections with a few pairs each
+  BenchShapeDotted,     // deep dotted keys, `a.b.c.d... = value`
+  BenchShapeNumbers,    // one huge array of integers and floats
+  BenchShapeStrings,    // giant multiline basic and literal strings
+  BenchShapeComments,   // long comment blocks with the odd pair in between
+  BenchShapeCount,
+} BenchShape;
+
+typedef struct {
+  char *data;
+  size_t length;
+  size_t capacity;
+} BenchBuffer;
+
+const char *bench_shape_name(BenchShape shape);
+
+/**
+ * Find a shape by the name `bench_shape_name` gives it, or return
+ * `BenchShapeCount` if there is none.
+ */
+BenchShape bench_shape_find(const char *name);
+
+/**
+ * Fill `buffer` with a document of the given shape that is at least `size`
+ * bytes long and ends after a complete line. Returns false if out of memory.
+ */
+bool bench_generate(BenchShape shape, size_t size, uint64_t seed, BenchBuffer *buffer);
+
+void bench_buffer_delete(BenchBuffer *buffer);
+
+#endif  // TREE_SITTER_TOML_BENCH_CORPUS_H_
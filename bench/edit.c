@@ -0,0 +1,674 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "./corpus.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <tree_sitter/api.h>
+
+/*
+ *  Reparse latency of `tree_sitter_toml()` under editor-style edits.
+ *
+ *  Each edit is applied to the text, described to the old tree with
+ *  `ts_tree_edit` and followed by a `ts_parser_parse` that reuses it, the way
+ *  an editor does on every keystroke. Only the edit and the reparse are
+ *  timed.
+ *
+ *  The parser reads its input through a callback that hands out small
+ *  chunks and records which of them were asked for. Tree-sitter only reads
+ *  text when it lexes, so the bytes in those chunks are the bytes that were
+ *  re-lexed and everything else came from reused subtrees.
+ */
+
+const TSLanguage *tree_sitter_toml(void);
+
+#define BENCH_CHUNK_SIZE 64
+
+typedef struct {
+  uint32_t offset;
+  uint32_t deleted;
+  const char *text;
+  uint32_t length;
+} BenchEdit;
+
+typedef struct {
+  BenchEdit *edits;
+  uint32_t count;
+  uint32_t capacity;
+  BenchBuffer text;  // inserted text of every edit, back to back
+} BenchScript;
+
+typedef struct {
+  const BenchBuffer *document;
+  uint8_t *touched;       // one flag per chunk
+  uint32_t *touched_list;
+  uint32_t touched_count;
+} BenchInput;
+
+typedef struct {
+  uint32_t offset;
+  TSPoint point;
+} BenchPointCache;
+
+typedef enum {
+  BenchScenarioKeys,
+  BenchScenarioStrings,
+  BenchScenarioHeaders,
+  BenchScenarioCount,
+} BenchScenario;
+
+static const char *const bench_scenario__names[BenchScenarioCount] = {
+  [BenchScenarioKeys] = "keys",
+  [BenchScenarioStrings] = "strings",
+  [BenchScenarioHeaders] = "headers",
+};
+
+static const char bench__usage[] =
+  "usage: edit [options] [scenario...]\n"
+  "\n"
+  "Scenarios: keys, strings, headers (default: all)\n"
+  "\n"
+  "  --size BYTES       size of the generated document, k/m/g suffixes allowed (default: 4m)\n"
+  "  --edits N          keystrokes per scenario (default: 500)\n"
+  "  --seed N           seed of the generated document (default: 1)\n"
+  "  --file PATH        edit PATH instead of a generated document, needs --script\n"
+  "  --script PATH      replay the edits recorded in PATH, on --file or a generated tables document\n"
+  "  --dump-script      write the edits of each scenario to stdout instead of replaying them\n"
+  "\n"
+  "A script has one edit per line, `OFFSET DELETED TEXT`: delete DELETED bytes at\n"
+  "OFFSET, then insert TEXT, which runs to the end of the line and may use the\n"
+  "escapes \\n, \\r, \\t and \\\\.\n";
+
+static double bench__now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static bool bench__parse_size(const char *text, size_t *result) {
+  char *end;
+  errno = 0;
+  unsigned long long value = strtoull(text, &end, 10);
+  if (errno || end == text) return false;
+
+  switch (*end) {
+    case 'g': case 'G': value *= 1024;  // fall through
+    case 'm': case 'M': value *= 1024;  // fall through
+    case 'k': case 'K': value *= 1024; end++; break;
+    default: break;
+  }
+
+  if (*end || value == 0 || value > UINT32_MAX / 2) return false;
+  *result = (size_t)value;
+  return true;
+}
+
+/*
+ *  Scripts
+ */
+
+static void bench_script__delete(BenchScript *self) {
+  free(self->edits);
+  bench_buffer_delete(&self->text);
+}
+
+static bool bench_script__push(BenchScript *self, uint32_t offset, uint32_t deleted, const char *text, uint32_t length) {
+  if (self->count == self->capacity) {
+    uint32_t capacity = self->capacity ? self->capacity * 2 : 256;
+    BenchEdit *edits = realloc(self->edits, capacity * sizeof(BenchEdit));
+    if (!edits) return false;
+    self->edits = edits;
+    self->capacity = capacity;
+  }
+
+  // edits point into `text` by offset until the script is complete, since it may still move
+  if (self->text.length + length + 1 > self->text.capacity) {
+    size_t capacity = self->text.capacity ? self->text.capacity : 4096;
+    while (capacity < self->text.length + length + 1) capacity *= 2;
+    char *data = realloc(self->text.data, capacity);
+    if (!data) return false;
+    self->text.data = data;
+    self->text.capacity = capacity;
+  }
+  if (length) memcpy(self->text.data + self->text.length, text, length);
+
+  self->edits[self->count++] = (BenchEdit) {
+    .offset = offset,
+    .deleted = deleted,
+    .text = (const char *)(uintptr_t)self->text.length,
+    .length = length,
+  };
+  self->text.length += length;
+  return true;
+}
+
+static void bench_script__finish(BenchScript *self) {
+  for (uint32_t i = 0; i < self->count; i++) {
+    self->edits[i].text = self->text.data + (uintptr_t)self->edits[i].text;
+  }
+}
+
+static bool bench_script__type(BenchScript *self, uint32_t *cursor, const char *text) {
+  for (const char *c = text; *c; c++) {
+    if (!bench_script__push(self, (*cursor)++, 0, c, 1)) return false;
+  }
+  return true;
+}
+
+static bool bench_script__backspace(BenchScript *self, uint32_t *cursor, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    if (!bench_script__push(self, --*cursor, 1, NULL, 0)) return false;
+  }
+  return true;
+}
+
+static bool bench_script__read(BenchScript *self, const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    fprintf(stderr, "edit: cannot open %s: %s\n", path, strerror(errno));
+    return false;
+  }
+
+  char line[4096];
+  char text[4096];
+  bool ok = true;
+  for (unsigned number = 1; ok && fgets(line, sizeof(line), file); number++) {
+    char *end;
+    unsigned long offset = strtoul(line, &end, 10);
+    unsigned long deleted = strtoul(end, &end, 10);
+    if (*end == ' ') end++;
+
+    uint32_t length = 0;
+    for (; *end && *end != '\n'; end++) {
+      char c = *end;
+      if (c == '\\') {
+        switch (*++end) {
+          case 'n': c = '\n'; break;
+          case 'r': c = '\r'; break;
+          case 't': c = '\t'; break;
+          case '\\': c = '\\'; break;
+          default:
+            fprintf(stderr, "edit: %s:%u: unknown escape\n", path, number);
+            ok = false;
+            break;
+        }
+        if (!ok) break;
+      }
+      text[length++] = c;
+    }
+
+    if (ok && !bench_script__push(self, (uint32_t)offset, (uint32_t)deleted, text, length)) {
+      fprintf(stderr, "edit: out of memory\n");
+      ok = false;
+    }
+  }
+
+  fclose(file);
+  bench_script__finish(self);
+  return ok;
+}
+
+static void bench_script__write(const BenchScript *self, FILE *file) {
+  for (uint32_t i = 0; i < self->count; i++) {
+    const BenchEdit *edit = &self->edits[i];
+    fprintf(file, "%u %u ", edit->offset, edit->deleted);
+    for (uint32_t j = 0; j < edit->length; j++) {
+      char c = edit->text[j];
+      switch (c) {
+        case '\n': fputs("\\n", file); break;
+        case '\r': fputs("\\r", file); break;
+        case '\t': fputs("\\t", file); break;
+        case '\\': fputs("\\\\", file); break;
+        default: fputc(c, file); break;
+      }
+    }
+    fputc('\n', file);
+  }
+}
+
+// Byte offset just after the first occurrence of `pattern` at or after the middle of the document.
+static uint32_t bench__find_from_middle(const BenchBuffer *document, const char *pattern) {
+  size_t length = strlen(pattern);
+  for (size_t i = document->length / 2; i + length <= document->length; i++) {
+    if (memcmp(document->data + i, pattern, length) == 0) return (uint32_t)(i + length);
+  }
+  return (uint32_t)document->length;
+}
+
+static bool bench__scenario(BenchScenario scenario, const BenchBuffer *document, uint32_t count, BenchScript *script) {
+  char text[64];
+  bool ok = true;
+
+  switch (scenario) {
+    case BenchScenarioKeys: {
+      // new pairs at the end of a table in the middle of the document
+      uint32_t cursor = bench__find_from_middle(document, "\n\n") - 1;
+      for (unsigned i = 0; ok && script->count < count; i++) {
+        snprintf(text, sizeof(text), "new_key_%u = %u\n", i, i * 7);
+        ok = bench_script__type(script, &cursor, text);
+      }
+      break;
+    }
+
+    case BenchScenarioStrings: {
+      // prose typed into the middle of a multiline basic string, quotes included
+      uint32_t cursor = bench__find_from_middle(document, "= \"\"\"\n");
+      static const char *const phrases[] = {"typing some words ", "a \"quoted\" word ", "an escaped \\t tab ", "\n"};
+      for (unsigned i = 0; ok && script->count < count; i++) {
+        ok = bench_script__type(script, &cursor, phrases[i % 4]);
+      }
+      break;
+    }
+
+    case BenchScenarioHeaders: {
+      // a `[table]` header typed in between two tables and then deleted again, over and over
+      uint32_t cursor = bench__find_from_middle(document, "\n\n");
+      for (unsigned i = 0; ok && script->count < count; i++) {
+        uint32_t length = (uint32_t)snprintf(text, sizeof(text), "[inserted_%u]\n", i);
+        ok = bench_script__type(script, &cursor, text)
+          && bench_script__backspace(script, &cursor, length);
+      }
+      break;
+    }
+
+    default:
+      return false;
+  }
+
+  if (script->count > count) script->count = count;
+  bench_script__finish(script);
+  return ok;
+}
+
+/*
+ *  Replay
+ */
+
+static const char *bench_input__read(void *payload, uint32_t byte_index, TSPoint position, uint32_t *bytes_read) {
+  (void)position;
+  BenchInput *self = (BenchInput *)payload;
+  if (byte_index >= self->document->length) {
+    *bytes_read = 0;
+    return "";
+  }
+
+  uint32_t chunk = byte_index / BENCH_CHUNK_SIZE;
+  if (!self->touched[chunk]) {
+    self->touched[chunk] = 1;
+    self->touched_list[self->touched_count++] = chunk;
+  }
+
+  uint32_t end = (chunk + 1) * BENCH_CHUNK_SIZE;
+  if (end > self->document->length) end = (uint32_t)self->document->length;
+  *bytes_read = end - byte_index;
+  return self->document->data + byte_index;
+}
+
+static void bench_input__reset(BenchInput *self) {
+  for (uint32_t i = 0; i < self->touched_count; i++) {
+    self->touched[self->touched_list[i]] = 0;
+  }
+  self->touched_count = 0;
+}
+
+static TSPoint bench__advance_point(TSPoint point, const char *text, uint32_t length) {
+  for (uint32_t i = 0; i < length; i++) {
+    if (text[i] == '\n') {
+      point.row++;
+      point.column = 0;
+    } else {
+      point.column++;
+    }
+  }
+  return point;
+}
+
+// Edits stay close together, so points are found by walking from the last one.
+static TSPoint bench__point_at(BenchPointCache *cache, const BenchBuffer *document, uint32_t offset) {
+  if (offset < cache->offset) {
+    const char *newline = memchr(document->data + offset, '\n', cache->offset - offset);
+    if (newline) {
+      cache->offset = 0;
+      cache->point = (TSPoint) {0, 0};
+    } else {
+      cache->point.column -= cache->offset - offset;
+      cache->offset = offset;
+    }
+  }
+
+  cache->point = bench__advance_point(cache->point, document->data + cache->offset, offset - cache->offset);
+  cache->offset = offset;
+  return cache->point;
+}
+
+static bool bench__apply(BenchBuffer *document, const BenchEdit *edit) {
+  size_t length = document->length - edit->deleted + edit->length;
+  if (length + 1 > document->capacity) {
+    size_t capacity = document->capacity * 2 > length + 1 ? document->capacity * 2 : length + 1;
+    char *data = realloc(document->data, capacity);
+    if (!data) return false;
+    document->data = data;
+    document->capacity = capacity;
+  }
+
+  char *start = document->data + edit->offset;
+  memmove(start + edit->length, start + edit->deleted, document->length - edit->offset - edit->deleted);
+  memcpy(start, edit->text, edit->length);
+  document->length = length;
+  document->data[length] = '\0';
+  return true;
+}
+
+static bool bench__same_tree(TSNode a, TSNode b) {
+  TSTreeCursor left = ts_tree_cursor_new(a);
+  TSTreeCursor right = ts_tree_cursor_new(b);
+  bool same = true;
+
+  for (;;) {
+    TSNode x = ts_tree_cursor_current_node(&left);
+    TSNode y = ts_tree_cursor_current_node(&right);
+    if (
+      ts_node_symbol(x) != ts_node_symbol(y)
+      || ts_node_start_byte(x) != ts_node_start_byte(y)
+      || ts_node_end_byte(x) != ts_node_end_byte(y)
+    ) {
+      same = false;
+      break;
+    }
+
+    bool down = ts_tree_cursor_goto_first_child(&left);
+    if (down != ts_tree_cursor_goto_first_child(&right)) {
+      same = false;
+      break;
+    }
+    if (down) continue;
+
+    bool done = false;
+    for (;;) {
+      bool next = ts_tree_cursor_goto_next_sibling(&left);
+      if (next != ts_tree_cursor_goto_next_sibling(&right)) {
+        same = false;
+        done = true;
+        break;
+      }
+      if (next) break;
+      if (!ts_tree_cursor_goto_parent(&left)) {
+        done = true;
+        break;
+      }
+      ts_tree_cursor_goto_parent(&right);
+    }
+    if (done) break;
+  }
+
+  ts_tree_cursor_delete(&left);
+  ts_tree_cursor_delete(&right);
+  return same;
+}
+
+static int bench__compare_durations(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static double bench__percentile(const double *sorted, uint32_t count, double percentile) {
+  uint32_t index = (uint32_t)(percentile * (count - 1) + 0.5);
+  return sorted[index];
+}
+
+static int bench__replay(const char *name, BenchBuffer *document, const BenchScript *script) {
+  if (script->count == 0) {
+    fprintf(stderr, "edit: %s has no edits\n", name);
+    return 1;
+  }
+
+  uint32_t chunk_capacity = (uint32_t)(document->capacity / BENCH_CHUNK_SIZE + 2);
+  for (uint32_t i = 0; i < script->count; i++) {
+    chunk_capacity += (script->edits[i].length + BENCH_CHUNK_SIZE - 1) / BENCH_CHUNK_SIZE;
+  }
+
+  BenchInput input_state = {
+    .document = document,
+    .touched = calloc(chunk_capacity, 1),
+    .touched_list = malloc(chunk_capacity * sizeof(uint32_t)),
+  };
+  double *durations = malloc(script->count * sizeof(double));
+  if (!input_state.touched || !input_state.touched_list || !durations) {
+    free(input_state.touched);
+    free(input_state.touched_list);
+    free(durations);
+    fprintf(stderr, "edit: out of memory\n");
+    return 1;
+  }
+
+  TSInput input = {&input_state, bench_input__read, TSInputEncodingUTF8};
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_toml());
+  TSTree *tree = ts_parser_parse(parser, NULL, input);
+  bench_input__reset(&input_state);
+
+  BenchPointCache cache = {0, {0, 0}};
+  uint64_t relexed = 0;
+  uint64_t total = 0;
+  uint64_t changed_ranges = 0;
+  int status = 0;
+
+  for (uint32_t i = 0; i < script->count; i++) {
+    const BenchEdit *edit = &script->edits[i];
+    if ((size_t)edit->offset + edit->deleted > document->length) {
+      fprintf(stderr, "edit: %s: edit %u is past the end of the document\n", name, i + 1);
+      status = 1;
+      break;
+    }
+
+    TSPoint start_point = bench__point_at(&cache, document, edit->offset);
+    TSInputEdit tree_edit = {
+      .start_byte = edit->offset,
+      .old_end_byte = edit->offset + edit->deleted,
+      .new_end_byte = edit->offset + edit->length,
+      .start_point = start_point,
+      .old_end_point = bench__advance_point(start_point, document->data + edit->offset, edit->deleted),
+      .new_end_point = bench__advance_point(start_point, edit->text, edit->length),
+    };
+    if (!bench__apply(document, edit)) {
+      fprintf(stderr, "edit: out of memory\n");
+      status = 1;
+      break;
+    }
+
+    double start = bench__now();
+    ts_tree_edit(tree, &tree_edit);
+    TSTree *new_tree = ts_parser_parse(parser, tree, input);
+    durations[i] = bench__now() - start;
+
+    uint32_t range_count;
+    free(ts_tree_get_changed_ranges(tree, new_tree, &range_count));
+    changed_ranges += range_count;
+
+    ts_tree_delete(tree);
+    tree = new_tree;
+
+    uint64_t lexed = (uint64_t)input_state.touched_count * BENCH_CHUNK_SIZE;
+    relexed += lexed < document->length ? lexed : document->length;
+    total += document->length;
+    bench_input__reset(&input_state);
+  }
+
+  uint32_t count = status ? 0 : script->count;
+  bool same = true;
+  if (count) {
+    // the incrementally maintained tree has to match a parse from scratch
+    TSTree *fresh = ts_parser_parse_string(parser, NULL, document->data, (uint32_t)document->length);
+    same = bench__same_tree(ts_tree_root_node(tree), ts_tree_root_node(fresh));
+    ts_tree_delete(fresh);
+
+    double sum = 0;
+    for (uint32_t i = 0; i < count; i++) sum += durations[i];
+    qsort(durations, count, sizeof(double), bench__compare_durations);
+
+    printf(
+      "%-10s %8u %10.3f %10.3f %10.3f %10.3f %12.0f %9.3f%% %8.2f%s\n",
+      name,
+      count,
+      sum / count * 1e3,
+      bench__percentile(durations, count, 0.5) * 1e3,
+      bench__percentile(durations, count, 0.99) * 1e3,
+      durations[count - 1] * 1e3,
+      (double)relexed / count,
+      total ? (1 - (double)relexed / (double)total) * 100 : 0,
+      (double)changed_ranges / count,
+      same ? "" : "  (differs from a fresh parse)"
+    );
+  }
+
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+  free(input_state.touched);
+  free(input_state.touched_list);
+  free(durations);
+  return status || !same;
+}
+
+static bool bench__read_file(const char *path, BenchBuffer *buffer) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "edit: cannot open %s: %s\n", path, strerror(errno));
+    return false;
+  }
+
+  char chunk[65536];
+  size_t read;
+  while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    if (buffer->length + read + 1 > buffer->capacity) {
+      size_t capacity = buffer->capacity ? buffer->capacity * 2 : sizeof(chunk);
+      while (capacity < buffer->length + read + 1) capacity *= 2;
+      char *data = realloc(buffer->data, capacity);
+      if (!data) {
+        fclose(file);
+        fprintf(stderr, "edit: out of memory reading %s\n", path);
+        return false;
+      }
+      buffer->data = data;
+      buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->length, chunk, read);
+    buffer->length += read;
+  }
+  fclose(file);
+
+  if (!buffer->data) return false;
+  buffer->data[buffer->length] = '\0';
+  return true;
+}
+
+int main(int argc, char **argv) {
+  size_t size = 4 * 1024 * 1024;
+  uint32_t edit_count = 500;
+  uint64_t seed = 1;
+  const char *file = NULL;
+  const char *script_path = NULL;
+  bool dump_script = false;
+  bool selected[BenchScenarioCount] = {false};
+  bool any_selected = false;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (strcmp(arg, "--size") == 0 && value) {
+      if (!bench__parse_size(value, &size)) {
+        fprintf(stderr, "edit: invalid size %s\n", value);
+        return 2;
+      }
+      i++;
+    } else if (strcmp(arg, "--edits") == 0 && value) {
+      edit_count = (uint32_t)strtoul(value, NULL, 10);
+      if (edit_count == 0) edit_count = 1;
+      i++;
+    } else if (strcmp(arg, "--seed") == 0 && value) {
+      seed = strtoull(value, NULL, 10);
+      i++;
+    } else if (strcmp(arg, "--file") == 0 && value) {
+      file = value;
+      i++;
+    } else if (strcmp(arg, "--script") == 0 && value) {
+      script_path = value;
+      i++;
+    } else if (strcmp(arg, "--dump-script") == 0) {
+      dump_script = true;
+    } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      fputs(bench__usage, stdout);
+      return 0;
+    } else {
+      unsigned scenario = 0;
+      while (scenario < BenchScenarioCount && strcmp(bench_scenario__names[scenario], arg) != 0) scenario++;
+      if (scenario == BenchScenarioCount) {
+        fputs(bench__usage, stderr);
+        return 2;
+      }
+      selected[scenario] = true;
+      any_selected = true;
+    }
+  }
+
+  if (file && !script_path) {
+    fputs(bench__usage, stderr);
+    return 2;
+  }
+
+  if (!dump_script) {
+    printf(
+      "%-10s %8s %10s %10s %10s %10s %12s %10s %8s\n",
+      "edits", "count", "mean ms", "p50 ms", "p99 ms", "max ms", "relexed B", "reused", "ranges"
+    );
+  }
+
+  if (script_path) {
+    BenchBuffer document = {0};
+    BenchScript script = {0};
+    bool ok = file
+      ? bench__read_file(file, &document)
+      : bench_generate(BenchShapeTables, size, seed, &document);
+    ok = ok && bench_script__read(&script, script_path);
+
+    int status = 1;
+    if (ok) {
+      const char *name = strrchr(script_path, '/');
+      status = bench__replay(name ? name + 1 : script_path, &document, &script);
+    }
+    bench_script__delete(&script);
+    bench_buffer_delete(&document);
+    return status;
+  }
+
+  // the document each scenario edits
+  static const BenchShape shapes[BenchScenarioCount] = {
+    [BenchScenarioKeys] = BenchShapeTables,
+    [BenchScenarioStrings] = BenchShapeStrings,
+    [BenchScenarioHeaders] = BenchShapeTables,
+  };
+
+  int status = 0;
+  for (unsigned i = 0; i < BenchScenarioCount; i++) {
+    if (any_selected && !selected[i]) continue;
+
+    BenchBuffer document = {0};
+    BenchScript script = {0};
+    if (!bench_generate(shapes[i], size, seed, &document) || !bench__scenario((BenchScenario)i, &document, edit_count, &script)) {
+      fprintf(stderr, "edit: out of memory generating %s\n", bench_scenario__names[i]);
+      status = 1;
+    } else if (dump_script) {
+      bench_script__write(&script, stdout);
+    } else {
+      status |= bench__replay(bench_scenario__names[i], &document, &script);
+    }
+
+    bench_script__delete(&script);
+    bench_buffer_delete(&document);
+  }
+
+  return status;
+}
@@ -0,0 +1,287 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "./corpus.h"
+#include "parallel.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <tree_sitter/api.h>
+#include <unistd.h>
+
+/*
+ *  Parse throughput of `tree_sitter_toml()`.
+ *
+ *  Every shape runs in its own child process so that the peak resident set
+ *  size reported for it is not inflated by the shapes that ran before.
+ */
+
+const TSLanguage *tree_sitter_toml(void);
+
+typedef struct {
+  size_t size;
+  unsigned iterations;
+  uint64_t seed;
+  uint32_t jobs;
+  const char *file;
+  bool dump;
+} BenchOptions;
+
+static const char bench__usage[] =
+  "usage: parse [options] [shape...]\n"
+  "\n"
+  "Shapes: tables, dotted, numbers, strings, comments (default: all)\n"
+  "\n"
+  "  --size BYTES       size of each generated document, k/m/g suffixes allowed (default: 8m)\n"
+  "  --iterations N     timed parses of each document (default: 10)\n"
+  "  --seed N           seed of the generated documents (default: 1)\n"
+  "  --jobs N           parse on N threads with toml_parallel_parse (default: 1)\n"
+  "  --file PATH        parse PATH instead of generated documents\n"
+  "  --dump             write the generated document to stdout instead of parsing it\n";
+
+static double bench__now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static double bench__peak_rss_mib(void) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return (double)usage.ru_maxrss / (1024 * 1024);
+#else
+  return (double)usage.ru_maxrss / 1024;
+#endif
+}
+
+static bool bench__parse_size(const char *text, size_t *result) {
+  char *end;
+  errno = 0;
+  unsigned long long value = strtoull(text, &end, 10);
+  if (errno || end == text) return false;
+
+  switch (*end) {
+    case 'g': case 'G': value *= 1024;  // fall through
+    case 'm': case 'M': value *= 1024;  // fall through
+    case 'k': case 'K': value *= 1024; end++; break;
+    default: break;
+  }
+
+  if (*end || value == 0 || value > UINT32_MAX) return false;
+  *result = (size_t)value;
+  return true;
+}
+
+static uint64_t bench__count_nodes(TSNode root) {
+  TSTreeCursor cursor = ts_tree_cursor_new(root);
+  uint64_t count = 1;
+
+  for (;;) {
+    if (ts_tree_cursor_goto_first_child(&cursor) || ts_tree_cursor_goto_next_sibling(&cursor)) {
+      count++;
+      continue;
+    }
+    for (;;) {
+      if (!ts_tree_cursor_goto_parent(&cursor)) {
+        ts_tree_cursor_delete(&cursor);
+        return count;
+      }
+      if (ts_tree_cursor_goto_next_sibling(&cursor)) {
+        count++;
+        break;
+      }
+    }
+  }
+}
+
+static void bench__parse_jobs(const char *source, size_t length, const BenchOptions *options, TomlParallelTrees *trees) {
+  if (!toml_parallel_parse(tree_sitter_toml(), source, (uint32_t)length, options->jobs, trees)) {
+    fputs("parse: out of memory\n", stderr);
+    exit(1);
+  }
+}
+
+static int bench__run(const char *name, const char *source, size_t length, const BenchOptions *options) {
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_toml());
+
+  // one untimed parse warms the caches and gives the tree to count
+  uint64_t nodes = 0;
+  bool has_error = false;
+  if (options->jobs > 1) {
+    TomlParallelTrees trees;
+    bench__parse_jobs(source, length, options, &trees);
+    for (uint32_t i = 0; i < trees.count; i++) {
+      TSNode root = ts_tree_root_node(trees.trees[i]);
+      nodes += bench__count_nodes(root);
+      has_error |= ts_node_has_error(root);
+    }
+    toml_parallel_trees_delete(&trees);
+  } else {
+    TSTree *tree = ts_parser_parse_string(parser, NULL, source, (uint32_t)length);
+    TSNode root = ts_tree_root_node(tree);
+    nodes = bench__count_nodes(root);
+    has_error = ts_node_has_error(root);
+    ts_tree_delete(tree);
+  }
+
+  double start = bench__now();
+  for (unsigned i = 0; i < options->iterations; i++) {
+    if (options->jobs > 1) {
+      TomlParallelTrees trees;
+      bench__parse_jobs(source, length, options, &trees);
+      toml_parallel_trees_delete(&trees);
+    } else {
+      ts_tree_delete(ts_parser_parse_string(parser, NULL, source, (uint32_t)length));
+    }
+  }
+  double elapsed = bench__now() - start;
+  ts_parser_delete(parser);
+
+  double per_parse = elapsed / options->iterations;
+  printf(
+    "%-10s %10.2f %10llu %10.2f %12.0f %10.3f %10.1f%s\n",
+    name,
+    (double)length / (1024 * 1024),
+    (unsigned long long)nodes,
+    (double)length / per_parse / 1e6,
+    (double)nodes / per_parse,
+    per_parse * 1e3,
+    bench__peak_rss_mib(),
+    has_error ? "  (has errors)" : ""
+  );
+  return has_error ? 1 : 0;
+}
+
+static int bench__run_shape(BenchShape shape, const BenchOptions *options) {
+  BenchBuffer buffer = {0};
+  if (!bench_generate(shape, options->size, options->seed, &buffer)) {
+    fprintf(stderr, "parse: out of memory generating %s\n", bench_shape_name(shape));
+    return 1;
+  }
+
+  int status;
+  if (options->dump) {
+    status = fwrite(buffer.data, 1, buffer.length, stdout) == buffer.length ? 0 : 1;
+  } else {
+    status = bench__run(bench_shape_name(shape), buffer.data, buffer.length, options);
+  }
+
+  bench_buffer_delete(&buffer);
+  return status;
+}
+
+static int bench__run_file(const BenchOptions *options) {
+  FILE *file = fopen(options->file, "rb");
+  if (!file) {
+    fprintf(stderr, "parse: cannot open %s: %s\n", options->file, strerror(errno));
+    return 1;
+  }
+
+  BenchBuffer buffer = {0};
+  char chunk[65536];
+  size_t read;
+  while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    char *data = realloc(buffer.data, buffer.length + read);
+    if (!data) {
+      fclose(file);
+      bench_buffer_delete(&buffer);
+      fprintf(stderr, "parse: out of memory reading %s\n", options->file);
+      return 1;
+    }
+    memcpy(data + buffer.length, chunk, read);
+    buffer.data = data;
+    buffer.length += read;
+  }
+  fclose(file);
+
+  const char *name = strrchr(options->file, '/');
+  int status = bench__run(name ? name + 1 : options->file, buffer.data, buffer.length, options);
+  bench_buffer_delete(&buffer);
+  return status;
+}
+
+int main(int argc, char **argv) {
+  BenchOptions options = {.size = 8 * 1024 * 1024, .iterations = 10, .seed = 1, .jobs = 1};
+  bool selected[BenchShapeCount] = {false};
+  bool any_selected = false;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (strcmp(arg, "--size") == 0 && value) {
+      if (!bench__parse_size(value, &options.size)) {
+        fprintf(stderr, "parse: invalid size %s\n", value);
+        return 2;
+      }
+      i++;
+    } else if (strcmp(arg, "--iterations") == 0 && value) {
+      options.iterations = (unsigned)strtoul(value, NULL, 10);
+      if (options.iterations == 0) options.iterations = 1;
+      i++;
+    } else if (strcmp(arg, "--seed") == 0 && value) {
+      options.seed = strtoull(value, NULL, 10);
+      i++;
+    } else if (strcmp(arg, "--jobs") == 0 && value) {
+      options.jobs = (uint32_t)strtoul(value, NULL, 10);
+      if (options.jobs == 0) options.jobs = 1;
+      i++;
+    } else if (strcmp(arg, "--file") == 0 && value) {
+      options.file = value;
+      i++;
+    } else if (strcmp(arg, "--dump") == 0) {
+      options.dump = true;
+    } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      fputs(bench__usage, stdout);
+      return 0;
+    } else {
+      BenchShape shape = bench_shape_find(arg);
+      if (shape == BenchShapeCount) {
+        fputs(bench__usage, stderr);
+        return 2;
+      }
+      selected[shape] = true;
+      any_selected = true;
+    }
+  }
+
+  if (!options.dump) {
+    printf(
+      "%-10s %10s %10s %10s %12s %10s %10s\n",
+      "input", "MiB", "nodes", "MB/s", "nodes/s", "ms/parse", "peak MiB"
+    );
+  }
+
+  if (options.file) return bench__run_file(&options);
+
+  int status = 0;
+  for (unsigned i = 0; i < BenchShapeCount; i++) {
+    if (any_selected && !selected[i]) continue;
+    if (options.dump) {
+      status |= bench__run_shape((BenchShape)i, &options);
+      continue;
+    }
+
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0) {
+      perror("parse: fork");
+      return 1;
+    }
+    if (child == 0) {
+      exit(bench__run_shape((BenchShape)i, &options));
+    }
+
+    int child_status;
+    if (waitpid(child, &child_status, 0) < 0 || !WIFEXITED(child_status) || WEXITSTATUS(child_status)) {
+      status = 1;
+    }
+  }
+
+  return status;
+}
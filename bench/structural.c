@@ -0,0 +1,109 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "./corpus.h"
+#include "structural.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ *  Throughput of the structural index with each kernel the CPU supports.
+ */
+
+#define BENCH_POSITIONS 65536
+
+static const char bench__usage[] =
+  "usage: structural [options] [shape...]\n"
+  "\n"
+  "Shapes: tables, dotted, numbers, strings, comments (default: all)\n"
+  "\n"
+  "  --size BYTES       size of each generated document in MiB (default: 64)\n"
+  "  --iterations N     timed scans of each document per kernel (default: 10)\n";
+
+static double bench__now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static uint64_t bench__scan(const BenchBuffer *buffer, TomlStructuralKernel kernel, uint32_t *positions) {
+  TomlStructuralScanner scanner;
+  uint64_t total = 0;
+  uint32_t count;
+  toml_structural_scanner_init(&scanner, buffer->data, (uint32_t)buffer->length, kernel);
+  while ((count = toml_structural_next(&scanner, positions, BENCH_POSITIONS))) total += count;
+  return total;
+}
+
+int main(int argc, char **argv) {
+  size_t size = 64 * 1024 * 1024;
+  unsigned iterations = 10;
+  bool selected[BenchShapeCount] = {false};
+  bool any_selected = false;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (strcmp(arg, "--size") == 0 && value) {
+      size = strtoul(value, NULL, 10) * 1024 * 1024;
+      if (size == 0 || size > UINT32_MAX) {
+        fprintf(stderr, "structural: invalid size %s\n", value);
+        return 2;
+      }
+      i++;
+    } else if (strcmp(arg, "--iterations") == 0 && value) {
+      iterations = (unsigned)strtoul(value, NULL, 10);
+      if (iterations == 0) iterations = 1;
+      i++;
+    } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      fputs(bench__usage, stdout);
+      return 0;
+    } else {
+      BenchShape shape = bench_shape_find(arg);
+      if (shape == BenchShapeCount) {
+        fputs(bench__usage, stderr);
+        return 2;
+      }
+      selected[shape] = true;
+      any_selected = true;
+    }
+  }
+
+  uint32_t *positions = malloc(BENCH_POSITIONS * sizeof(uint32_t));
+  if (!positions) return 1;
+
+  printf("%-10s %-8s %10s %12s\n", "input", "kernel", "MB/s", "structural");
+  for (unsigned i = 0; i < BenchShapeCount; i++) {
+    if (any_selected && !selected[i]) continue;
+
+    BenchBuffer buffer = {0};
+    if (!bench_generate((BenchShape)i, size, 1, &buffer)) {
+      fprintf(stderr, "structural: out of memory generating %s\n", bench_shape_name((BenchShape)i));
+      return 1;
+    }
+
+    for (unsigned kernel = 0; kernel < TomlStructuralKernelCount; kernel++) {
+      if (!toml_structural_kernel_supported((TomlStructuralKernel)kernel)) continue;
+
+      // one untimed scan warms the caches and gives the count
+      uint64_t count = bench__scan(&buffer, (TomlStructuralKernel)kernel, positions);
+      double start = bench__now();
+      for (unsigned j = 0; j < iterations; j++) bench__scan(&buffer, (TomlStructuralKernel)kernel, positions);
+      double elapsed = bench__now() - start;
+
+      printf(
+        "%-10s %-8s %10.0f %12llu\n",
+        bench_shape_name((BenchShape)i),
+        toml_structural_kernel_name((TomlStructuralKernel)kernel),
+        (double)buffer.length * iterations / elapsed / 1e6,
+        (unsigned long long)count
+      );
+    }
+    bench_buffer_delete(&buffer);
+  }
+
+  free(positions);
+  return 0;
+}
@@ -1,4 +1,9 @@
 {
+  "variables": {
+    # the N-API addon links its own copy of the runtime from the tree-sitter
+    # submodule, so it is only built on request: --toml_napi=true
+    "toml_napi%": "false"
+  },
   "targets": [
     {
       "target_name": "tree_sitter_toml_binding",
@@ -15,5 +20,39 @@
         "-std=c99",
       ]
     }
+  ],
+  "conditions": [
+    ["toml_napi=='true'", {
+      "targets": [
+        {
+          "target_name": "tree_sitter_toml_napi",
+          "include_dirs": [
+            "src",
+            "tree-sitter/lib/include",
+            "tree-sitter/lib/src"
+          ],
+          "sources": [
+            "src/parser.c",
+            "src/scanner.c",
+            "src/arena.c",
+            "src/decode_datetime.c",
+            "src/decode_number.c",
+            "src/decode_string.c",
+            "src/fold.c",
+            "src/highlight.c",
+            "src/validate.c",
+            "src/value.c",
+            "tree-sitter/lib/src/lib.c",
+            "bindings/node/napi.c"
+          ],
+          "defines": [
+            "NAPI_VERSION=6"
+          ],
+          "cflags_c": [
+            "-std=c99",
+          ]
+        }
+      ]
+    }]
   ]
 }
@@ -14,6 +14,26 @@ try {
   }
 }
 
+// native entry points, only built with --toml_napi=true since they link the runtime from the submodule
+for (const build of ["Release", "Debug"]) {
+  try {
+    const napi = require(`../../build/${build}/tree_sitter_toml_napi`);
+    module.exports.parseBatch = napi.parseBatch;
+    module.exports.parseBatchAsync = napi.parseBatchAsync;
+    module.exports.toObject = napi.toObject;
+    module.exports.validate = napi.validate;
+    module.exports.highlight = napi.highlight;
+    module.exports.highlightNames = napi.highlightNames;
+    module.exports.folds = napi.folds;
+    module.exports.nodeTypes = napi.nodeTypes;
+    break;
+  } catch (error) {
+    if (error.code !== 'MODULE_NOT_FOUND') {
+      throw error;
+    }
+  }
+}
+
 try {
   module.exports.nodeTypeInfo = require("../../src/node-types.json");
 } catch (_) {}
@@ -0,0 +1,898 @@
+#include <node_api.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tree_sitter/api.h>
+#include "fold.h"
+#include "highlight.h"
+#include "validate.h"
+#include "value.h"
+
+/*
+ *  N-API entry points that parse many inputs per call.
+ *
+ *  Going through node-tree-sitter costs a JS-to-native round trip and a
+ *  wrapper object per parse and per node, which dominates for small files.
+ *  `parseBatch` instead parses every buffer of an array with one parser
+ *  that lives as long as the addon, and hands each tree back as a flat
+ *  `Uint32Array` that JS can walk without calling back into native code.
+ *
+ *  Every node takes `TOML_NODE_STRIDE` words, in pre-order:
+ *
+ *    [0]  symbol in the low 16 bits, `TomlNodeFlag`s above them
+ *    [1]  start byte
+ *    [2]  end byte
+ *    [3]  index of the next node outside this one's subtree, so that
+ *         `[3] == i + 1` for a leaf and `i = nodes[i * 4 + 3]` skips a subtree
+ *
+ *  Symbols index into the `nodeTypes` array exported next to `parseBatch`.
+ *  `parseBatchAsync` returns the same results through a promise, parsing on
+ *  the libuv thread pool instead of the main thread, `toObject` skips the
+ *  tree altogether and returns the decoded document, `validate` returns
+ *  the semantic errors of a document, `highlight` its highlight spans and
+ *  `folds` its fold ranges.
+ */
+
+const TSLanguage *tree_sitter_toml(void);
+
+#define TOML_NODE_STRIDE 4
+
+typedef enum {
+  TomlNodeFlagNamed = 1 << 16,
+  TomlNodeFlagMissing = 1 << 17,
+  TomlNodeFlagExtra = 1 << 18,
+} TomlNodeFlag;
+
+typedef struct {
+  uint32_t *contents;
+  uint32_t size;
+  uint32_t capacity;
+} TomlWordArray;
+
+typedef struct {
+  const char *data;
+  uint32_t length;
+} TomlInput;
+
+typedef struct {
+  TSParser *parser;
+  TomlWordArray nodes;
+  TomlWordArray stack;  // indices of the nodes whose subtree is still open
+  TomlValidator *validator;
+  TomlHighlightSpan *spans;
+  uint32_t span_capacity;
+  TomlFold *folds;
+  uint32_t fold_capacity;
+} TomlBinding;
+
+#define TOML_NAPI_CALL(env, call)                               \
+  do {                                                          \
+    if ((call) != napi_ok) {                                    \
+      toml_binding__throw_last_error(env);                      \
+      return NULL;                                              \
+    }                                                           \
+  } while (0)
+
+static void toml_binding__throw_last_error(napi_env env) {
+  const napi_extended_error_info *info = NULL;
+  bool is_pending = false;
+  napi_get_last_error_info(env, &info);
+  napi_is_exception_pending(env, &is_pending);
+  if (!is_pending) {
+    const char *message = info && info->error_message ? info->error_message : "N-API call failed";
+    napi_throw_error(env, NULL, message);
+  }
+}
+
+static bool toml_word_array__grow(TomlWordArray *self, uint32_t additional) {
+  if (self->size + additional <= self->capacity) return true;
+
+  uint32_t capacity = self->capacity ? self->capacity : 1024;
+  while (capacity < self->size + additional) capacity *= 2;
+  uint32_t *contents = realloc(self->contents, capacity * sizeof(uint32_t));
+  if (!contents) return false;
+
+  self->contents = contents;
+  self->capacity = capacity;
+  return true;
+}
+
+static void toml_binding__finalize(napi_env env, void *data, void *hint) {
+  (void)env;
+  (void)hint;
+  TomlBinding *self = (TomlBinding *)data;
+  ts_parser_delete(self->parser);
+  toml_validator_delete(self->validator);
+  free(self->spans);
+  free(self->folds);
+  free(self->nodes.contents);
+  free(self->stack.contents);
+  free(self);
+}
+
+// Flattens the tree into `nodes`, see the layout above. `stack` is scratch space.
+static bool toml_binding__flatten(TomlWordArray *nodes, TomlWordArray *stack, TSNode root) {
+  TSTreeCursor cursor = ts_tree_cursor_new(root);
+  nodes->size = 0;
+  stack->size = 0;
+
+  for (;;) {
+    TSNode node = ts_tree_cursor_current_node(&cursor);
+    if (!toml_word_array__grow(nodes, TOML_NODE_STRIDE) || !toml_word_array__grow(stack, 1)) {
+      ts_tree_cursor_delete(&cursor);
+      return false;
+    }
+
+    uint32_t index = nodes->size / TOML_NODE_STRIDE;
+    uint32_t *words = nodes->contents + nodes->size;
+    words[0] = ts_node_symbol(node)
+      | (ts_node_is_named(node) ? TomlNodeFlagNamed : 0)
+      | (ts_node_is_missing(node) ? TomlNodeFlagMissing : 0)
+      | (ts_node_is_extra(node) ? TomlNodeFlagExtra : 0);
+    words[1] = ts_node_start_byte(node);
+    words[2] = ts_node_end_byte(node);
+    words[3] = index + 1;
+    nodes->size += TOML_NODE_STRIDE;
+
+    if (ts_tree_cursor_goto_first_child(&cursor)) {
+      stack->contents[stack->size++] = index;
+      continue;
+    }
+
+    while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+      if (!ts_tree_cursor_goto_parent(&cursor)) {
+        ts_tree_cursor_delete(&cursor);
+        return true;
+      }
+      uint32_t parent = stack->contents[--stack->size];
+      nodes->contents[parent * TOML_NODE_STRIDE + 3] = nodes->size / TOML_NODE_STRIDE;
+    }
+  }
+}
+
+static napi_value toml_binding__result(napi_env env, const TomlWordArray *nodes, bool has_error) {
+  void *data;
+  napi_value buffer, array, error_flag, result;
+  size_t byte_length = nodes->size * sizeof(uint32_t);
+  TOML_NAPI_CALL(env, napi_create_arraybuffer(env, byte_length, &data, &buffer));
+  if (byte_length) memcpy(data, nodes->contents, byte_length);
+  TOML_NAPI_CALL(env, napi_create_typedarray(env, napi_uint32_array, nodes->size, buffer, 0, &array));
+  TOML_NAPI_CALL(env, napi_get_boolean(env, has_error, &error_flag));
+
+  TOML_NAPI_CALL(env, napi_create_object(env, &result));
+  TOML_NAPI_CALL(env, napi_set_named_property(env, result, "nodes", array));
+  TOML_NAPI_CALL(env, napi_set_named_property(env, result, "hasError", error_flag));
+  return result;
+}
+
+// Checks that the only argument is an array and returns its length, or throws.
+static bool toml_binding__inputs(napi_env env, size_t argc, napi_value inputs, uint32_t *count) {
+  bool is_array = false;
+  if (argc == 1 && napi_is_array(env, inputs, &is_array) != napi_ok) {
+    toml_binding__throw_last_error(env);
+    return false;
+  }
+  if (!is_array) {
+    napi_throw_type_error(env, NULL, "Expected an array of Buffers");
+    return false;
+  }
+  if (napi_get_array_length(env, inputs, count) != napi_ok) {
+    toml_binding__throw_last_error(env);
+    return false;
+  }
+  return true;
+}
+
+// Reads the Buffer at `index` of `inputs`, or throws if it is not one.
+static bool toml_binding__input(napi_env env, napi_value inputs, uint32_t index, napi_value *input, TomlInput *result) {
+  bool is_buffer = false;
+  void *data;
+  size_t length;
+
+  if (napi_get_element(env, inputs, index, input) != napi_ok || napi_is_buffer(env, *input, &is_buffer) != napi_ok) {
+    toml_binding__throw_last_error(env);
+    return false;
+  }
+  if (!is_buffer) {
+    napi_throw_type_error(env, NULL, "Expected an array of Buffers");
+    return false;
+  }
+  if (napi_get_buffer_info(env, *input, &data, &length) != napi_ok) {
+    toml_binding__throw_last_error(env);
+    return false;
+  }
+  if (length > UINT32_MAX) {
+    napi_throw_range_error(env, NULL, "Input is larger than 4 GiB");
+    return false;
+  }
+
+  result->data = (const char *)data;
+  result->length = (uint32_t)length;
+  return true;
+}
+
+static napi_value toml_binding__parse_batch(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value inputs;
+  TomlBinding *self;
+  uint32_t count;
+  TOML_NAPI_CALL(env, napi_get_cb_info(env, info, &argc, &inputs, NULL, (void **)&self));
+  if (!toml_binding__inputs(env, argc, inputs, &count)) return NULL;
+
+  napi_value results;
+  TOML_NAPI_CALL(env, napi_create_array_with_length(env, count, &results));
+
+  for (uint32_t i = 0; i < count; i++) {
+    napi_value input;
+    TomlInput source;
+    if (!toml_binding__input(env, inputs, i, &input, &source)) return NULL;
+
+    TSTree *tree = ts_parser_parse_string(self->parser, NULL, source.data, source.length);
+    if (!tree) {
+      napi_throw_error(env, NULL, "Parse failed");
+      return NULL;
+    }
+    TSNode root = ts_tree_root_node(tree);
+    bool ok = toml_binding__flatten(&self->nodes, &self->stack, root);
+    bool has_error = ts_node_has_error(root);
+    ts_tree_delete(tree);
+    if (!ok) {
+      napi_throw_error(env, NULL, "Out of memory");
+      return NULL;
+    }
+
+    napi_value result = toml_binding__result(env, &self->nodes, has_error);
+    if (!result) return NULL;
+    TOML_NAPI_CALL(env, napi_set_element(env, results, i, result));
+  }
+
+  return results;
+}
+
+/*
+ *  Parsing on the libuv thread pool
+ *
+ *  `parseBatchAsync` splits the inputs into one slice per pool thread, with
+ *  about the same number of bytes in each, and queues an async work item per
+ *  slice. Every item creates its own parser, since a `TSParser` must not be
+ *  shared between threads, and flattens its trees into buffers of its own.
+ *  The last item to complete turns all of them into results on the main
+ *  thread and settles the promise. The inputs stay referenced until then.
+ */
+
+#define TOML_DEFAULT_THREADPOOL_SIZE 4
+#define TOML_MAX_THREADPOOL_SIZE 1024
+
+typedef struct {
+  uint32_t *words;
+  uint32_t size;
+  bool has_error;
+} TomlBatchResult;
+
+typedef struct TomlBatchJob TomlBatchJob;
+
+typedef struct {
+  TomlBatchJob *job;
+  napi_async_work work;
+  uint32_t begin;
+  uint32_t end;
+  bool failed;  // written by the worker, read once the item has completed
+} TomlBatchSlice;
+
+struct TomlBatchJob {
+  napi_deferred deferred;
+  napi_ref inputs;  // copy of the input array, keeps every Buffer alive
+  TomlInput *sources;
+  TomlBatchResult *results;
+  TomlBatchSlice *slices;
+  uint32_t count;
+  uint32_t slice_count;
+  uint32_t pending;
+  bool failed;
+};
+
+static uint32_t toml_batch__threadpool_size(void) {
+  const char *value = getenv("UV_THREADPOOL_SIZE");
+  long size = value ? strtol(value, NULL, 10) : TOML_DEFAULT_THREADPOOL_SIZE;
+  if (size < 1) size = TOML_DEFAULT_THREADPOOL_SIZE;
+  if (size > TOML_MAX_THREADPOOL_SIZE) size = TOML_MAX_THREADPOOL_SIZE;
+  return (uint32_t)size;
+}
+
+static void toml_batch__delete(napi_env env, TomlBatchJob *self) {
+  if (self->inputs) napi_delete_reference(env, self->inputs);
+  if (self->results) {
+    for (uint32_t i = 0; i < self->count; i++) free(self->results[i].words);
+  }
+  free(self->results);
+  free(self->sources);
+  free(self->slices);
+  free(self);
+}
+
+static void toml_batch__execute(napi_env env, void *data) {
+  (void)env;
+  TomlBatchSlice *slice = (TomlBatchSlice *)data;
+  TomlBatchJob *job = slice->job;
+  TomlWordArray nodes = {0};
+  TomlWordArray stack = {0};
+
+  TSParser *parser = ts_parser_new();
+  if (!parser || !ts_parser_set_language(parser, tree_sitter_toml())) {
+    slice->failed = true;
+  }
+
+  for (uint32_t i = slice->begin; i < slice->end && !slice->failed; i++) {
+    TSTree *tree = ts_parser_parse_string(parser, NULL, job->sources[i].data, job->sources[i].length);
+    if (!tree) {
+      slice->failed = true;
+      break;
+    }
+
+    TSNode root = ts_tree_root_node(tree);
+    slice->failed = !toml_binding__flatten(&nodes, &stack, root);
+    job->results[i].has_error = ts_node_has_error(root);
+    ts_tree_delete(tree);
+
+    // each result keeps the array it was flattened into, the next one starts a new one
+    job->results[i].words = nodes.contents;
+    job->results[i].size = nodes.size;
+    nodes = (TomlWordArray) {0};
+  }
+
+  if (parser) ts_parser_delete(parser);
+  free(stack.contents);
+}
+
+static napi_value toml_batch__results(napi_env env, TomlBatchJob *self) {
+  napi_value results;
+  TOML_NAPI_CALL(env, napi_create_array_with_length(env, self->count, &results));
+
+  for (uint32_t i = 0; i < self->count; i++) {
+    TomlWordArray nodes = {self->results[i].words, self->results[i].size, self->results[i].size};
+    napi_value result = toml_binding__result(env, &nodes, self->results[i].has_error);
+    if (!result) return NULL;
+    TOML_NAPI_CALL(env, napi_set_element(env, results, i, result));
+  }
+
+  return results;
+}
+
+static void toml_batch__settle(napi_env env, TomlBatchJob *self) {
+  napi_value value = NULL;
+  if (self->failed) {
+    napi_value message;
+    napi_create_string_utf8(env, "Out of memory", NAPI_AUTO_LENGTH, &message);
+    napi_create_error(env, NULL, message, &value);
+    napi_reject_deferred(env, self->deferred, value);
+    return;
+  }
+
+  value = toml_batch__results(env, self);
+  if (value) {
+    napi_resolve_deferred(env, self->deferred, value);
+  } else {
+    napi_get_and_clear_last_exception(env, &value);
+    napi_reject_deferred(env, self->deferred, value);
+  }
+}
+
+static void toml_batch__complete(napi_env env, napi_status status, void *data) {
+  TomlBatchSlice *slice = (TomlBatchSlice *)data;
+  TomlBatchJob *job = slice->job;
+  if (status != napi_ok || slice->failed) job->failed = true;
+  napi_delete_async_work(env, slice->work);
+  slice->work = NULL;
+
+  if (--job->pending > 0) return;
+  toml_batch__settle(env, job);
+  toml_batch__delete(env, job);
+}
+
+// Splits the inputs into contiguous slices of roughly equal byte size.
+static void toml_batch__split(TomlBatchJob *self, uint32_t slice_count) {
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < self->count; i++) total += self->sources[i].length + 1;
+
+  uint64_t seen = 0;
+  uint32_t begin = 0;
+  self->slice_count = 0;
+  for (uint32_t i = 0; i < self->count; i++) {
+    seen += self->sources[i].length + 1;
+    bool last = i + 1 == self->count;
+    if (last || seen * slice_count >= total * (self->slice_count + 1)) {
+      TomlBatchSlice *slice = &self->slices[self->slice_count++];
+      slice->job = self;
+      slice->begin = begin;
+      slice->end = i + 1;
+      begin = i + 1;
+    }
+  }
+}
+
+static napi_value toml_binding__parse_batch_async(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value inputs;
+  uint32_t count;
+  TOML_NAPI_CALL(env, napi_get_cb_info(env, info, &argc, &inputs, NULL, NULL));
+  if (!toml_binding__inputs(env, argc, inputs, &count)) return NULL;
+
+  napi_value promise, kept;
+  TomlBatchJob *job = calloc(1, sizeof(TomlBatchJob));
+  uint32_t slice_count = toml_batch__threadpool_size();
+  if (slice_count > count) slice_count = count;
+  if (job) {
+    job->count = count;
+    job->sources = calloc(count ? count : 1, sizeof(TomlInput));
+    job->results = calloc(count ? count : 1, sizeof(TomlBatchResult));
+    job->slices = calloc(slice_count ? slice_count : 1, sizeof(TomlBatchSlice));
+  }
+  if (!job || !job->sources || !job->results || !job->slices) {
+    if (job) toml_batch__delete(env, job);
+    napi_throw_error(env, NULL, "Out of memory");
+    return NULL;
+  }
+
+  // the Buffers are copied into an array of our own so that changes to the caller's cannot free them
+  if (napi_create_array_with_length(env, count, &kept) != napi_ok) goto fail;
+  for (uint32_t i = 0; i < count; i++) {
+    napi_value input;
+    if (!toml_binding__input(env, inputs, i, &input, &job->sources[i])) goto fail_thrown;
+    if (napi_set_element(env, kept, i, input) != napi_ok) goto fail;
+  }
+  if (napi_create_reference(env, kept, 1, &job->inputs) != napi_ok) goto fail;
+
+  toml_batch__split(job, slice_count);
+  napi_value resource_name;
+  if (napi_create_string_utf8(env, "tree-sitter-toml.parseBatchAsync", NAPI_AUTO_LENGTH, &resource_name) != napi_ok) goto fail;
+  for (uint32_t i = 0; i < job->slice_count; i++) {
+    TomlBatchSlice *slice = &job->slices[i];
+    if (napi_create_async_work(env, NULL, resource_name, toml_batch__execute, toml_batch__complete, slice, &slice->work) != napi_ok) goto fail;
+  }
+  if (napi_create_promise(env, &job->deferred, &promise) != napi_ok) goto fail;
+
+  if (job->slice_count == 0) {
+    toml_batch__settle(env, job);
+    toml_batch__delete(env, job);
+    return promise;
+  }
+
+  job->pending = job->slice_count;
+  for (uint32_t i = 0; i < job->slice_count; i++) {
+    if (napi_queue_async_work(env, job->slices[i].work) != napi_ok) {
+      // never runs, so it completes here as a failed slice
+      toml_batch__complete(env, napi_generic_failure, &job->slices[i]);
+    }
+  }
+  return promise;
+
+fail:
+  toml_binding__throw_last_error(env);
+fail_thrown:
+  for (uint32_t i = 0; i < job->slice_count; i++) {
+    if (job->slices[i].work) napi_delete_async_work(env, job->slices[i].work);
+  }
+  toml_batch__delete(env, job);
+  return NULL;
+}
+
+/*
+ *  Conversion to plain JS values
+ *
+ *  `toObject` parses a buffer, decodes it with `toml_document_new` and builds
+ *  the JS object graph from the decoded values in the same native call:
+ *
+ *    string                 string
+ *    integer                number, or a BigInt outside of +/-(2^53 - 1)
+ *    float, boolean         number, boolean
+ *    offset date-time       Date
+ *    local date-time, date
+ *    and time               string, as written in the document
+ *    array                  Array
+ *    table, inline table    Object, with keys defined as own properties so
+ *                           that a `__proto__` key is just a key
+ */
+
+#define TOML_MAX_SAFE_INTEGER 9007199254740991LL
+
+static napi_value toml_object__value(napi_env env, const TomlValue *value, const char *source);
+
+static napi_value toml_object__table(napi_env env, const TomlValue *table, const char *source) {
+  napi_value object;
+  TOML_NAPI_CALL(env, napi_create_object(env, &object));
+  uint32_t count = table->as.table.count;
+  if (count == 0) return object;
+
+  napi_property_descriptor *properties = calloc(count, sizeof(napi_property_descriptor));
+  if (!properties) {
+    napi_throw_error(env, NULL, "Out of memory");
+    return NULL;
+  }
+
+  napi_value result = object;
+  for (uint32_t i = 0; i < count; i++) {
+    const TomlEntry *entry = &table->as.table.entries[i];
+    properties[i].attributes = napi_writable | napi_enumerable | napi_configurable;
+    properties[i].value = toml_object__value(env, entry->value, source);
+    if (
+      !properties[i].value
+      || napi_create_string_utf8(env, entry->key.data, entry->key.length, &properties[i].name) != napi_ok
+    ) {
+      result = NULL;
+      break;
+    }
+  }
+
+  if (result && napi_define_properties(env, object, count, properties) != napi_ok) result = NULL;
+  free(properties);
+  if (!result) toml_binding__throw_last_error(env);
+  return result;
+}
+
+static napi_value toml_object__array(napi_env env, const TomlValue *array, const char *source) {
+  napi_value result;
+  uint32_t count = array->as.array.count;
+  TOML_NAPI_CALL(env, napi_create_array_with_length(env, count, &result));
+
+  for (uint32_t i = 0; i < count; i++) {
+    napi_value item = toml_object__value(env, array->as.array.items[i], source);
+    if (!item) return NULL;
+    TOML_NAPI_CALL(env, napi_set_element(env, result, i, item));
+  }
+
+  return result;
+}
+
+static napi_value toml_object__value(napi_env env, const TomlValue *value, const char *source) {
+  napi_value result = NULL;
+
+  switch (value->type) {
+    case TomlValueTypeString:
+      TOML_NAPI_CALL(env, napi_create_string_utf8(env, value->as.string.data, value->as.string.length, &result));
+      break;
+    case TomlValueTypeInteger:
+      if (value->as.integer >= -TOML_MAX_SAFE_INTEGER && value->as.integer <= TOML_MAX_SAFE_INTEGER) {
+        TOML_NAPI_CALL(env, napi_create_double(env, (double)value->as.integer, &result));
+      } else {
+        TOML_NAPI_CALL(env, napi_create_bigint_int64(env, value->as.integer, &result));
+      }
+      break;
+    case TomlValueTypeFloat:
+      TOML_NAPI_CALL(env, napi_create_double(env, value->as.floating, &result));
+      break;
+    case TomlValueTypeBoolean:
+      TOML_NAPI_CALL(env, napi_get_boolean(env, value->as.boolean, &result));
+      break;
+    case TomlValueTypeOffsetDateTime: {
+      int64_t micros;
+      if (!toml_datetime_epoch_micros(&value->as.datetime, &micros)) {
+        napi_throw_range_error(env, NULL, "Date-time out of range");
+        return NULL;
+      }
+      // floor division, so that times before 1970 keep their millisecond
+      int64_t millis = micros / 1000 - (micros % 1000 < 0);
+      TOML_NAPI_CALL(env, napi_create_date(env, (double)millis, &result));
+      break;
+    }
+    case TomlValueTypeLocalDateTime:
+    case TomlValueTypeLocalDate:
+    case TomlValueTypeLocalTime:
+      TOML_NAPI_CALL(env, napi_create_string_utf8(env, source + value->start_byte, value->end_byte - value->start_byte, &result));
+      break;
+    case TomlValueTypeArray:
+      result = toml_object__array(env, value, source);
+      break;
+    case TomlValueTypeTable:
+      result = toml_object__table(env, value, source);
+      break;
+  }
+
+  return result;
+}
+
+static void toml_object__throw(napi_env env, const TomlError *error) {
+  napi_value message, exception, start_byte, end_byte;
+  if (
+    napi_create_string_utf8(env, error->message ? error->message : "invalid document", NAPI_AUTO_LENGTH, &message) != napi_ok
+    || napi_create_error(env, NULL, message, &exception) != napi_ok
+    || napi_create_uint32(env, error->start_byte, &start_byte) != napi_ok
+    || napi_create_uint32(env, error->end_byte, &end_byte) != napi_ok
+    || napi_set_named_property(env, exception, "startByte", start_byte) != napi_ok
+    || napi_set_named_property(env, exception, "endByte", end_byte) != napi_ok
+  ) {
+    toml_binding__throw_last_error(env);
+    return;
+  }
+  napi_throw(env, exception);
+}
+
+// Reads the Buffer that `toObject`, `validate`, `highlight` and `folds` take as their only argument.
+static bool toml_binding__buffer_argument(napi_env env, napi_callback_info info, TomlBinding **self, TomlInput *input) {
+  size_t argc = 1;
+  napi_value argument;
+  bool is_buffer = false;
+  if (napi_get_cb_info(env, info, &argc, &argument, NULL, (void **)self) != napi_ok) {
+    toml_binding__throw_last_error(env);
+    return false;
+  }
+  if (argc == 1 && napi_is_buffer(env, argument, &is_buffer) != napi_ok) {
+    toml_binding__throw_last_error(env);
+    return false;
+  }
+  if (!is_buffer) {
+    napi_throw_type_error(env, NULL, "Expected a Buffer");
+    return false;
+  }
+
+  void *data;
+  size_t length;
+  if (napi_get_buffer_info(env, argument, &data, &length) != napi_ok) {
+    toml_binding__throw_last_error(env);
+    return false;
+  }
+  if (length > UINT32_MAX) {
+    napi_throw_range_error(env, NULL, "Input is larger than 4 GiB");
+    return false;
+  }
+
+  input->data = (const char *)data;
+  input->length = (uint32_t)length;
+  return true;
+}
+
+static napi_value toml_binding__to_object(napi_env env, napi_callback_info info) {
+  TomlBinding *self;
+  TomlInput source;
+  if (!toml_binding__buffer_argument(env, info, &self, &source)) return NULL;
+
+  TSTree *tree = ts_parser_parse_string(self->parser, NULL, source.data, source.length);
+  if (!tree) {
+    napi_throw_error(env, NULL, "Parse failed");
+    return NULL;
+  }
+
+  TomlError error = {0};
+  TomlDocument *document = toml_document_new(tree, source.data, &error);
+  ts_tree_delete(tree);
+  if (!document) {
+    toml_object__throw(env, &error);
+    return NULL;
+  }
+
+  napi_value result = toml_object__value(env, toml_document_root(document), source.data);
+  toml_document_delete(document);
+  return result;
+}
+
+/*
+ *  Validation
+ *
+ *  `validate` runs a `TomlValidator` over a buffer and returns every error
+ *  it finds as `{message, startByte, endByte}`, an empty array for a valid
+ *  document.
+ */
+
+#define TOML_VALIDATE_ERRORS 32
+
+static napi_value toml_validate__errors(napi_env env, const TomlError *errors, uint32_t count) {
+  napi_value result;
+  TOML_NAPI_CALL(env, napi_create_array_with_length(env, count, &result));
+
+  for (uint32_t i = 0; i < count; i++) {
+    napi_value error, message, start_byte, end_byte;
+    TOML_NAPI_CALL(env, napi_create_object(env, &error));
+    TOML_NAPI_CALL(env, napi_create_string_utf8(env, errors[i].message, NAPI_AUTO_LENGTH, &message));
+    TOML_NAPI_CALL(env, napi_create_uint32(env, errors[i].start_byte, &start_byte));
+    TOML_NAPI_CALL(env, napi_create_uint32(env, errors[i].end_byte, &end_byte));
+    TOML_NAPI_CALL(env, napi_set_named_property(env, error, "message", message));
+    TOML_NAPI_CALL(env, napi_set_named_property(env, error, "startByte", start_byte));
+    TOML_NAPI_CALL(env, napi_set_named_property(env, error, "endByte", end_byte));
+    TOML_NAPI_CALL(env, napi_set_element(env, result, i, error));
+  }
+
+  return result;
+}
+
+static napi_value toml_binding__validate(napi_env env, napi_callback_info info) {
+  TomlBinding *self;
+  TomlInput source;
+  if (!toml_binding__buffer_argument(env, info, &self, &source)) return NULL;
+
+  if (!self->validator) self->validator = toml_validator_new();
+  TSTree *tree = self->validator ? ts_parser_parse_string(self->parser, NULL, source.data, source.length) : NULL;
+  if (!tree) {
+    napi_throw_error(env, NULL, self->validator ? "Parse failed" : "Out of memory");
+    return NULL;
+  }
+
+  // documents with more errors than fit on the stack are checked again into a big enough array
+  TomlError stack_errors[TOML_VALIDATE_ERRORS];
+  TomlError *errors = stack_errors;
+  uint32_t count = toml_validator_check(self->validator, tree, source.data, errors, TOML_VALIDATE_ERRORS);
+  if (count > TOML_VALIDATE_ERRORS) {
+    errors = malloc(count * sizeof(TomlError));
+    if (errors) {
+      count = toml_validator_check(self->validator, tree, source.data, errors, count);
+    } else {
+      errors = stack_errors;
+      count = TOML_VALIDATE_ERRORS;
+    }
+  }
+  ts_tree_delete(tree);
+
+  napi_value result = toml_validate__errors(env, errors, count);
+  if (errors != stack_errors) free(errors);
+  return result;
+}
+
+/*
+ *  Highlighting
+ *
+ *  `highlight` returns the spans of `toml_highlight_tree` as a `Uint32Array`
+ *  of `TOML_SPAN_STRIDE` words each: the start byte, the end byte, and the
+ *  capture as an index into `highlightNames`.
+ */
+
+#define TOML_SPAN_STRIDE 3
+
+static napi_value toml_highlight__spans(napi_env env, const TomlHighlightSpan *spans, uint32_t count) {
+  void *data;
+  napi_value buffer, array;
+  size_t length = (size_t)count * TOML_SPAN_STRIDE;
+  TOML_NAPI_CALL(env, napi_create_arraybuffer(env, length * sizeof(uint32_t), &data, &buffer));
+
+  uint32_t *words = data;
+  for (uint32_t i = 0; i < count; i++) {
+    words[i * TOML_SPAN_STRIDE] = spans[i].start_byte;
+    words[i * TOML_SPAN_STRIDE + 1] = spans[i].end_byte;
+    words[i * TOML_SPAN_STRIDE + 2] = spans[i].highlight - 1;
+  }
+
+  TOML_NAPI_CALL(env, napi_create_typedarray(env, napi_uint32_array, length, buffer, 0, &array));
+  return array;
+}
+
+static napi_value toml_binding__highlight(napi_env env, napi_callback_info info) {
+  TomlBinding *self;
+  TomlInput source;
+  if (!toml_binding__buffer_argument(env, info, &self, &source)) return NULL;
+
+  TSTree *tree = ts_parser_parse_string(self->parser, NULL, source.data, source.length);
+  if (!tree) {
+    napi_throw_error(env, NULL, "Parse failed");
+    return NULL;
+  }
+
+  // the span buffer is kept between calls, and a tree with more spans is walked again once it has grown
+  uint32_t count = toml_highlight_tree(tree, self->spans, self->span_capacity);
+  if (count > self->span_capacity) {
+    TomlHighlightSpan *spans = realloc(self->spans, count * sizeof(TomlHighlightSpan));
+    if (!spans) {
+      ts_tree_delete(tree);
+      napi_throw_error(env, NULL, "Out of memory");
+      return NULL;
+    }
+    self->spans = spans;
+    self->span_capacity = count;
+    toml_highlight_tree(tree, self->spans, self->span_capacity);
+  }
+  ts_tree_delete(tree);
+
+  return toml_highlight__spans(env, self->spans, count);
+}
+
+static napi_value toml_binding__highlight_names(napi_env env) {
+  napi_value names;
+  TOML_NAPI_CALL(env, napi_create_array_with_length(env, TomlHighlightCount - 1, &names));
+
+  for (uint32_t i = 1; i < TomlHighlightCount; i++) {
+    napi_value name;
+    TOML_NAPI_CALL(env, napi_create_string_utf8(env, toml_highlight_name((TomlHighlight)i), NAPI_AUTO_LENGTH, &name));
+    TOML_NAPI_CALL(env, napi_set_element(env, names, i - 1, name));
+  }
+
+  return names;
+}
+
+/*
+ *  Folding
+ *
+ *  `folds` returns the folds of `toml_fold_tree` as a `Uint32Array` of
+ *  `TOML_FOLD_STRIDE` words each: the start and end bytes, then the first
+ *  and last rows.
+ */
+
+#define TOML_FOLD_STRIDE 4
+
+static napi_value toml_fold__folds(napi_env env, const TomlFold *folds, uint32_t count) {
+  void *data;
+  napi_value buffer, array;
+  size_t length = (size_t)count * TOML_FOLD_STRIDE;
+  TOML_NAPI_CALL(env, napi_create_arraybuffer(env, length * sizeof(uint32_t), &data, &buffer));
+
+  uint32_t *words = data;
+  for (uint32_t i = 0; i < count; i++) {
+    words[i * TOML_FOLD_STRIDE] = folds[i].start_byte;
+    words[i * TOML_FOLD_STRIDE + 1] = folds[i].end_byte;
+    words[i * TOML_FOLD_STRIDE + 2] = folds[i].start_row;
+    words[i * TOML_FOLD_STRIDE + 3] = folds[i].end_row;
+  }
+
+  TOML_NAPI_CALL(env, napi_create_typedarray(env, napi_uint32_array, length, buffer, 0, &array));
+  return array;
+}
+
+static napi_value toml_binding__folds(napi_env env, napi_callback_info info) {
+  TomlBinding *self;
+  TomlInput source;
+  if (!toml_binding__buffer_argument(env, info, &self, &source)) return NULL;
+
+  TSTree *tree = ts_parser_parse_string(self->parser, NULL, source.data, source.length);
+  if (!tree) {
+    napi_throw_error(env, NULL, "Parse failed");
+    return NULL;
+  }
+
+  // kept between calls like the highlight spans
+  uint32_t count = toml_fold_tree(tree, self->folds, self->fold_capacity);
+  if (count > self->fold_capacity) {
+    TomlFold *folds = realloc(self->folds, count * sizeof(TomlFold));
+    if (!folds) {
+      ts_tree_delete(tree);
+      napi_throw_error(env, NULL, "Out of memory");
+      return NULL;
+    }
+    self->folds = folds;
+    self->fold_capacity = count;
+    toml_fold_tree(tree, self->folds, self->fold_capacity);
+  }
+  ts_tree_delete(tree);
+
+  return toml_fold__folds(env, self->folds, count);
+}
+
+static napi_value toml_binding__node_types(napi_env env, const TSLanguage *language) {
+  uint32_t count = ts_language_symbol_count(language);
+  napi_value node_types;
+  TOML_NAPI_CALL(env, napi_create_array_with_length(env, count, &node_types));
+
+  for (uint32_t i = 0; i < count; i++) {
+    napi_value name;
+    TOML_NAPI_CALL(env, napi_create_string_utf8(env, ts_language_symbol_name(language, (TSSymbol)i), NAPI_AUTO_LENGTH, &name));
+    TOML_NAPI_CALL(env, napi_set_element(env, node_types, i, name));
+  }
+
+  return node_types;
+}
+
+NAPI_MODULE_INIT() {
+  TomlBinding *self = calloc(1, sizeof(TomlBinding));
+  if (!self) {
+    napi_throw_error(env, NULL, "Out of memory");
+    return NULL;
+  }
+  self->parser = ts_parser_new();
+  ts_parser_set_language(self->parser, tree_sitter_toml());
+  TOML_NAPI_CALL(env, napi_set_instance_data(env, self, toml_binding__finalize, NULL));
+
+  napi_value parse_batch, parse_batch_async, to_object, validate, highlight, highlight_names, folds, node_types;
+  TOML_NAPI_CALL(env, napi_create_function(env, "parseBatch", NAPI_AUTO_LENGTH, toml_binding__parse_batch, self, &parse_batch));
+  TOML_NAPI_CALL(env, napi_create_function(env, "parseBatchAsync", NAPI_AUTO_LENGTH, toml_binding__parse_batch_async, NULL, &parse_batch_async));
+  TOML_NAPI_CALL(env, napi_create_function(env, "toObject", NAPI_AUTO_LENGTH, toml_binding__to_object, self, &to_object));
+  TOML_NAPI_CALL(env, napi_create_function(env, "validate", NAPI_AUTO_LENGTH, toml_binding__validate, self, &validate));
+  TOML_NAPI_CALL(env, napi_create_function(env, "highlight", NAPI_AUTO_LENGTH, toml_binding__highlight, self, &highlight));
+  TOML_NAPI_CALL(env, napi_create_function(env, "folds", NAPI_AUTO_LENGTH, toml_binding__folds, self, &folds));
+  highlight_names = toml_binding__highlight_names(env);
+  if (!highlight_names) return NULL;
+  node_types = toml_binding__node_types(env, tree_sitter_toml());
+  if (!node_types) return NULL;
+
+  TOML_NAPI_CALL(env, napi_set_named_property(env, exports, "parseBatch", parse_batch));
+  TOML_NAPI_CALL(env, napi_set_named_property(env, exports, "parseBatchAsync", parse_batch_async));
+  TOML_NAPI_CALL(env, napi_set_named_property(env, exports, "toObject", to_object));
+  TOML_NAPI_CALL(env, napi_set_named_property(env, exports, "validate", validate));
+  TOML_NAPI_CALL(env, napi_set_named_property(env, exports, "highlight", highlight));
+  TOML_NAPI_CALL(env, napi_set_named_property(env, exports, "highlightNames", highlight_names));
+  TOML_NAPI_CALL(env, napi_set_named_property(env, exports, "folds", folds));
+  TOML_NAPI_CALL(env, napi_set_named_property(env, exports, "nodeTypes", node_types));
+  return exports;
+}
@@ -0,0 +1,178 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "input.h"
+#include "json.h"
+#include "parallel.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tree_sitter/api.h>
+#include <unistd.h>
+
+/*
+ *  Transcodes TOML documents to JSON, one line per document.
+ */
+
+const TSLanguage *tree_sitter_toml(void);
+
+static const char cli__usage[] =
+  "usage: toml2json [options] [file...]\n"
+  "\n"
+  "Writes each TOML file (default: stdin) as one line of JSON.\n"
+  "\n"
+  "  -o PATH            write to PATH instead of stdout\n"
+  "  --buffer BYTES     size of the output buffer (default: 64k)\n"
+  "  --jobs N           parse each file on N threads, split at its headers (default: 1)\n";
+
+static bool cli__parse_size(const char *text, size_t *result) {
+  char *end;
+  errno = 0;
+  unsigned long long value = strtoull(text, &end, 10);
+  if (errno || end == text) return false;
+
+  switch (*end) {
+    case 'm': case 'M': value *= 1024;  // fall through
+    case 'k': case 'K': value *= 1024; end++; break;
+    default: break;
+  }
+
+  if (*end || value == 0 || value > UINT32_MAX) return false;
+  *result = (size_t)value;
+  return true;
+}
+
+static void cli__report(const char *name, const char *source, size_t length, const TomlError *error) {
+  unsigned line = 1, column = 1;
+  for (uint32_t i = 0; i < error->start_byte && i < length; i++) {
+    if (source[i] == '\n') {
+      line++;
+      column = 1;
+    } else {
+      column++;
+    }
+  }
+  fprintf(stderr, "toml2json: %s:%u:%u: %s\n", name, line, column, error->message);
+}
+
+static int cli__convert(TSParser *parser, TomlJsonWriter *writer, uint32_t jobs, const char *path) {
+  const char *name = path ? path : "stdin";
+  int fd = path ? open(path, O_RDONLY) : STDIN_FILENO;
+  TomlFileInput *input = fd < 0 ? NULL : toml_file_input_new(fd);
+  if (!input) {
+    fprintf(stderr, "toml2json: cannot read %s: %s\n", name, strerror(errno));
+    if (fd > STDIN_FILENO) close(fd);
+    return 1;
+  }
+
+  // files are parsed straight from their mapping, nothing is copied
+  TomlParallelTrees trees = {0};
+  TSTree *tree = NULL;
+  const char *source = NULL;
+  if (jobs > 1) {
+    source = toml_file_input_source(input);
+    uint32_t length = (uint32_t)toml_file_input_length(input);
+    if (source && !toml_parallel_parse(tree_sitter_toml(), source, length, jobs, &trees)) {
+      errno = ENOMEM;
+      source = NULL;
+    }
+  } else {
+    tree = ts_parser_parse(parser, NULL, toml_file_input(input));
+    source = toml_file_input_source(input);
+  }
+
+  int status = 1;
+  if (!source) {
+    fprintf(stderr, "toml2json: cannot read %s: %s\n", name, strerror(errno));
+  } else {
+    TomlError error;
+    bool ok = tree
+      ? toml_json_writer_write(writer, tree, source, &error)
+      : toml_json_writer_write_trees(writer, (const TSTree *const *)trees.trees, trees.count, source, &error);
+    if (ok) {
+      status = 0;
+    } else {
+      cli__report(name, source, toml_file_input_length(input), &error);
+    }
+  }
+
+  if (tree) ts_tree_delete(tree);
+  toml_parallel_trees_delete(&trees);
+  toml_file_input_delete(input);
+  if (fd != STDIN_FILENO) close(fd);
+  return status;
+}
+
+int main(int argc, char **argv) {
+  const char *output = NULL;
+  size_t buffer_size = 0;
+  uint32_t jobs = 1;
+  int first_path = argc;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (strcmp(arg, "-o") == 0 && value) {
+      output = value;
+      i++;
+    } else if (strcmp(arg, "--buffer") == 0 && value) {
+      if (!cli__parse_size(value, &buffer_size)) {
+        fprintf(stderr, "toml2json: invalid buffer size %s\n", value);
+        return 2;
+      }
+      i++;
+    } else if (strcmp(arg, "--jobs") == 0 && value) {
+      jobs = (uint32_t)strtoul(value, NULL, 10);
+      if (jobs == 0) jobs = 1;
+      i++;
+    } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      fputs(cli__usage, stdout);
+      return 0;
+    } else if (strcmp(arg, "--") == 0) {
+      first_path = i + 1;
+      break;
+    } else if (arg[0] == '-' && arg[1]) {
+      fputs(cli__usage, stderr);
+      return 2;
+    } else {
+      first_path = i;
+      break;
+    }
+  }
+
+  int fd = STDOUT_FILENO;
+  if (output) {
+    fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+      fprintf(stderr, "toml2json: cannot open %s: %s\n", output, strerror(errno));
+      return 1;
+    }
+  }
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_toml());
+  TomlJsonWriter *writer = toml_json_writer_new(fd, buffer_size);
+  if (!writer) {
+    fputs("toml2json: out of memory\n", stderr);
+    return 1;
+  }
+
+  // the parser and the output buffer are reused across files
+  int status = 0;
+  if (first_path == argc) {
+    status = cli__convert(parser, writer, jobs, NULL);
+  }
+  for (int i = first_path; i < argc; i++) {
+    status |= cli__convert(parser, writer, jobs, strcmp(argv[i], "-") == 0 ? NULL : argv[i]);
+  }
+
+  if (!toml_json_writer_delete(writer)) {
+    fprintf(stderr, "toml2json: cannot write %s: %s\n", output ? output : "stdout", strerror(errno));
+    status = 1;
+  }
+  if (output && close(fd) != 0) status = 1;
+  ts_parser_delete(parser);
+  return status;
+}
@@ -0,0 +1,15 @@
+; Sections
+;---------
+
+(table) @fold
+(table_array_element) @fold
+
+; Values
+;-------
+
+(array) @fold
+(inline_table) @fold
+
+; Only multiline strings span more than one line, and editors ignore folds
+; that do not.
+(string) @fold
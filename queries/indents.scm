@@ -0,0 +1,15 @@
+; Values
+;-------
+
+[
+  (array)
+  (inline_table)
+] @indent.begin
+
+; Punctuation
+;------------
+
+[
+  "]"
+  "}"
+] @indent.branch @indent.end
@@ -0,0 +1,22 @@
+# Builds the benchmarks in bench/ against the tree-sitter runtime from the
+# submodule (see setup-tree-sitter.sh) into build/bench/.
+set -e
+cd "$(dirname "$0")/.."
+
+CC="${CC:-cc}"
+CFLAGS="${CFLAGS:--O2 -g}"
+RUNTIME=tree-sitter/lib
+
+mkdir -p build/bench
+"$CC" $CFLAGS -std=c99 -I"$RUNTIME/include" -I"$RUNTIME/src" -c "$RUNTIME/src/lib.c" -o build/bench/lib.o
+"$CC" $CFLAGS -std=c99 -Isrc -c src/parser.c -o build/bench/parser.o
+"$CC" $CFLAGS -std=c99 -Isrc -c src/scanner.c -o build/bench/scanner.o
+
+"$CC" $CFLAGS -std=c99 -I"$RUNTIME/include" -Isrc -c src/parallel.c -o build/bench/parallel.o
+"$CC" $CFLAGS -std=c99 -Isrc -c src/structural.c -o build/bench/structural.o
+
+for bench in parse edit structural; do
+  "$CC" $CFLAGS -std=c99 -Wall -Wextra -I"$RUNTIME/include" -Isrc \
+    bench/$bench.c bench/corpus.c build/bench/lib.o build/bench/parser.o build/bench/scanner.o \
+    build/bench/parallel.o build/bench/structural.o -pthread -o build/bench/$bench
+done
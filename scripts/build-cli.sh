@@ -0,0 +1,14 @@
+# Builds the command line tools in cli/ against the tree-sitter runtime from
+# the submodule (see setup-tree-sitter.sh) into build/bin/.
+set -e
+cd "$(dirname "$0")/.."
+
+CC="${CC:-cc}"
+CFLAGS="${CFLAGS:--O2 -g}"
+RUNTIME=tree-sitter/lib
+
+mkdir -p build/bin
+"$CC" $CFLAGS -std=c99 -Wall -Wextra -I"$RUNTIME/include" -I"$RUNTIME/src" -Isrc \
+  cli/toml2json.c src/input.c src/json.c src/parallel.c src/structural.c src/arena.c src/decode_number.c src/decode_string.c \
+  "$RUNTIME/src/lib.c" src/parser.c src/scanner.c \
+  -lm -pthread -o build/bin/toml2json
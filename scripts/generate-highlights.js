@@ -0,0 +1,88 @@
+// Writes src/highlight_symbols.h, the capture of every symbol of src/parser.c
+// under queries/highlights.scm, for the highlighter in src/highlight.c. Run it
+// again after `tree-sitter generate` or after editing the query. With --check
+// it writes nothing and fails if the header is out of date, as
+// scripts/run-tests.sh does.
+
+const fs = require("fs");
+const path = require("path");
+
+const parser = fs.readFileSync(path.resolve(__dirname, "../src/parser.c"), "utf8");
+const query = fs.readFileSync(path.resolve(__dirname, "../queries/highlights.scm"), "utf8");
+
+const unescape = text => JSON.parse(`"${text}"`);
+const section = (start) => parser.slice(parser.indexOf(start), parser.indexOf("};", parser.indexOf(start)));
+
+const symbolCount = Number(/#define SYMBOL_COUNT (\d+)/.exec(parser)[1]);
+
+const ids = new Map([["ts_builtin_sym_end", 0]]);
+for (const [, name, id] of section("enum {").matchAll(/^  (\w+) = (\d+),$/gm)) {
+  ids.set(name, Number(id));
+}
+
+const symbols = [];
+for (const [, name, type] of section("ts_symbol_names[]").matchAll(/^  \[(\w+)\] = "((?:[^"\\]|\\.)*)",$/gm)) {
+  symbols.push({ id: ids.get(name), name, type: unescape(type) });
+}
+
+// nodes only ever carry the public symbol of their type
+const publicSymbols = new Set();
+for (const [, name, target] of section("ts_symbol_map[]").matchAll(/^  \[(\w+)\] = (\w+),$/gm)) {
+  if (name === target) publicSymbols.add(name);
+}
+
+const captures = new Array(symbolCount).fill(null);
+const patterns = /^(?:\((\w+)\)|"((?:[^"\\]|\\.)*)")\s+@([\w.]+)\s*$/;
+for (const line of query.split("\n")) {
+  if (!line.trim() || line.startsWith(";")) continue;
+  const match = patterns.exec(line);
+  if (!match) throw new Error(`cannot compile pattern: ${line}`);
+
+  const [, named, anonymous, capture] = match;
+  const type = named !== undefined ? named : unescape(anonymous);
+  const matches = symbols.filter(symbol =>
+    publicSymbols.has(symbol.name)
+    && symbol.type === type
+    && symbol.name.startsWith(named !== undefined ? "sym_" : "anon_sym_")
+  );
+  if (!matches.length) throw new Error(`no symbol for pattern: ${line}`);
+
+  // as with the query engine, the first pattern for a node wins
+  for (const symbol of matches) {
+    if (captures[symbol.id] === null) captures[symbol.id] = { capture, type };
+  }
+}
+
+const enumName = capture => "TomlHighlight" + capture.split(".").map(part => part[0].toUpperCase() + part.slice(1)).join("");
+
+const entries = [];
+captures.forEach((entry, id) => {
+  if (entry) entries.push(`  [${id}] = ${enumName(entry.capture)},  // ${JSON.stringify(entry.type)}`);
+});
+
+const header = `// Generated by scripts/generate-highlights.js, do not edit.
+
+#ifndef TREE_SITTER_TOML_HIGHLIGHT_SYMBOLS_H_
+#define TREE_SITTER_TOML_HIGHLIGHT_SYMBOLS_H_
+
+#include "./highlight.h"
+
+#define TOML_HIGHLIGHT_SYMBOL_COUNT ${symbolCount}
+
+// the capture of each public symbol of src/parser.c in queries/highlights.scm
+static const uint8_t toml_highlight_symbols[TOML_HIGHLIGHT_SYMBOL_COUNT] = {
+${entries.join("\n")}
+};
+
+#endif  // TREE_SITTER_TOML_HIGHLIGHT_SYMBOLS_H_
+`;
+
+const output = path.resolve(__dirname, "../src/highlight_symbols.h");
+if (process.argv.includes("--check")) {
+  if (fs.readFileSync(output, "utf8") !== header) {
+    console.error("src/highlight_symbols.h is out of date, run scripts/generate-highlights.js");
+    process.exit(1);
+  }
+} else {
+  fs.writeFileSync(output, header);
+}
@@ -0,0 +1,53 @@
+// Writes src/power_of_five.h, the 128-bit approximations of 5^q used by the
+// Eisel-Lemire float decoder in src/decode_number.c.
+
+const fs = require("fs");
+const path = require("path");
+
+const SMALLEST_POWER = -342;
+const LARGEST_POWER = 308;
+
+const one = 1n;
+const bitLength = n => n.toString(2).length;
+
+const entries = [];
+
+for (let q = SMALLEST_POWER; q <= LARGEST_POWER; q++) {
+  let value;
+  if (q < 0) {
+    const power = 5n ** BigInt(-q);
+    let z = 0;
+    while ((one << BigInt(z)) < power) z++;
+    const b = q >= -27 ? z + 127 : 2 * z + 128;
+    value = (one << BigInt(b)) / power + one;
+    while (value >= one << 128n) value >>= 1n;
+  } else {
+    value = 5n ** BigInt(q);
+    while (value < one << 127n) value <<= 1n;
+    while (value >= one << 128n) value >>= 1n;
+  }
+  if (bitLength(value) !== 128) throw new Error(`bad entry for 5^${q}`);
+  const hex = n => `0x${n.toString(16).padStart(16, "0")}`;
+  entries.push(`  ${hex(value >> 64n)}, ${hex(value & ((one << 64n) - one))},  // 5^${q}`);
+}
+
+const header = `// Generated by scripts/generate-power-of-five.js, do not edit.
+
+#ifndef TREE_SITTER_TOML_POWER_OF_FIVE_H_
+#define TREE_SITTER_TOML_POWER_OF_FIVE_H_
+
+#include <stdint.h>
+
+#define TOML_SMALLEST_POWER_OF_FIVE (${SMALLEST_POWER})
+#define TOML_LARGEST_POWER_OF_FIVE ${LARGEST_POWER}
+
+// 5^q normalized to 128 bits, high word first: truncated for q >= 0,
+// rounded up for q < 0
+static const uint64_t toml_power_of_five_128[] = {
+${entries.join("\n")}
+};
+
+#endif  // TREE_SITTER_TOML_POWER_OF_FIVE_H_
+`;
+
+fs.writeFileSync(path.resolve(__dirname, "../src/power_of_five.h"), header);
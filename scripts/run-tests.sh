@@ -0,0 +1,55 @@
+# Builds the C tests in test/ against the tree-sitter runtime from the
+# submodule (see setup-tree-sitter.sh) into build/test/, then runs them,
+# after checking that src/highlight_symbols.h matches the query.
+set -e
+cd "$(dirname "$0")/.."
+
+CC="${CC:-cc}"
+CFLAGS="${CFLAGS:--O2 -g}"
+RUNTIME=tree-sitter/lib
+
+node scripts/generate-highlights.js --check
+
+mkdir -p build/test
+"$CC" $CFLAGS -std=c99 -I"$RUNTIME/include" -I"$RUNTIME/src" -c "$RUNTIME/src/lib.c" -o build/test/lib.o
+"$CC" $CFLAGS -std=c99 -Isrc -c src/parser.c -o build/test/parser.o
+"$CC" $CFLAGS -std=c99 -Isrc -c src/scanner.c -o build/test/scanner.o
+
+DECODE="src/arena.c src/decode_datetime.c src/decode_number.c src/decode_string.c"
+
+build_test() {
+  build_test_as "$1" "$@"
+}
+
+# Builds test/$2.c into build/test/$1, with the flags in TEST_FLAGS.
+build_test_as() {
+  output="$1"
+  name="$2"
+  shift 2
+  "$CC" $CFLAGS $TEST_FLAGS -std=c99 -Wall -Wextra -I"$RUNTIME/include" -Isrc \
+    "test/$name.c" "$@" build/test/lib.o build/test/parser.o build/test/scanner.o \
+    -lm -pthread -o "build/test/$output"
+  TESTS="$TESTS $output"
+}
+
+TESTS=""
+TEST_FLAGS=""
+build_test decode $DECODE
+build_test fold src/fold.c
+build_test highlight src/highlight.c
+build_test index src/index.c src/value.c $DECODE
+build_test input src/input.c
+TEST_FLAGS=-DTOML_FILE_INPUT_NO_MMAP
+build_test_as input-chunked input src/input.c
+TEST_FLAGS=""
+build_test json src/json.c $DECODE
+build_test lazy src/lazy.c src/index.c src/value.c $DECODE
+build_test model src/model.c src/value.c $DECODE
+build_test parallel src/parallel.c src/structural.c src/json.c $DECODE
+build_test structural src/structural.c bench/corpus.c
+build_test validate src/validate.c src/value.c $DECODE
+build_test value src/value.c $DECODE
+
+for name in $TESTS; do
+  "./build/test/$name"
+done
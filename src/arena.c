@@ -0,0 +1,127 @@
+#include "./arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TOML_ARENA_ALIGNMENT 8
+#define TOML_ARENA_MIN_BLOCK_SIZE 1024
+
+typedef struct TomlArenaBlock {
+  struct TomlArenaBlock *previous;
+  size_t size;
+  size_t used;
+} TomlArenaBlock;
+
+struct TomlArena {
+  TomlArenaBlock *block;
+  void *last;
+  size_t reserved;
+};
+
+static inline size_t toml_arena__align(size_t size) {
+  return (size + TOML_ARENA_ALIGNMENT - 1) & ~(size_t)(TOML_ARENA_ALIGNMENT - 1);
+}
+
+static inline char *toml_arena__data(TomlArenaBlock *block) {
+  return (char *)block + toml_arena__align(sizeof(TomlArenaBlock));
+}
+
+static TomlArenaBlock *toml_arena__push_block(TomlArena *self, size_t size) {
+  TomlArenaBlock *block = malloc(toml_arena__align(sizeof(TomlArenaBlock)) + size);
+  if (!block) return NULL;
+  block->previous = self->block;
+  block->size = size;
+  block->used = 0;
+  self->block = block;
+  self->reserved += size;
+  return block;
+}
+
+TomlArena *toml_arena_new(size_t capacity) {
+  TomlArena *self = malloc(sizeof(TomlArena));
+  if (!self) return NULL;
+  self->block = NULL;
+  self->last = NULL;
+  self->reserved = 0;
+
+  size_t size = toml_arena__align(capacity);
+  if (size < TOML_ARENA_MIN_BLOCK_SIZE) size = TOML_ARENA_MIN_BLOCK_SIZE;
+  if (!toml_arena__push_block(self, size)) {
+    free(self);
+    return NULL;
+  }
+  return self;
+}
+
+size_t toml_arena_capacity_for_source(size_t length) {
+  // decoded values take a few times the bytes of the text they come from,
+  // dense arrays of small numbers being the worst case
+  return length * 4 + TOML_ARENA_MIN_BLOCK_SIZE;
+}
+
+void toml_arena_delete(TomlArena *self) {
+  if (!self) return;
+  TomlArenaBlock *block = self->block;
+  while (block) {
+    TomlArenaBlock *previous = block->previous;
+    free(block);
+    block = previous;
+  }
+  free(self);
+}
+
+void toml_arena_reset(TomlArena *self) {
+  // blocks only grow, so the newest one is the largest
+  TomlArenaBlock *block = self->block->previous;
+  while (block) {
+    TomlArenaBlock *previous = block->previous;
+    free(block);
+    block = previous;
+  }
+  self->block->previous = NULL;
+  self->block->used = 0;
+  self->last = NULL;
+  self->reserved = self->block->size;
+}
+
+void *toml_arena_alloc(TomlArena *self, size_t size) {
+  TomlArenaBlock *block = self->block;
+  size = toml_arena__align(size);
+
+  if (block->size - block->used < size) {
+    size_t block_size = block->size * 2;
+    if (block_size < size) block_size = size;
+    block = toml_arena__push_block(self, block_size);
+    if (!block) return NULL;
+  }
+
+  void *result = toml_arena__data(block) + block->used;
+  block->used += size;
+  self->last = result;
+  return result;
+}
+
+void *toml_arena_realloc(TomlArena *self, void *pointer, size_t old_size, size_t new_size) {
+  if (!pointer) return toml_arena_alloc(self, new_size);
+
+  TomlArenaBlock *block = self->block;
+  if (pointer == self->last) {
+    size_t offset = (size_t)((char *)pointer - toml_arena__data(block));
+    size_t size = toml_arena__align(new_size);
+    if (block->size - offset >= size) {
+      block->used = offset + size;
+      return pointer;
+    }
+  }
+
+  if (new_size <= old_size) return pointer;
+
+  void *result = toml_arena_alloc(self, new_size);
+  if (!result) return NULL;
+  memcpy(result, pointer, old_size);
+  return result;
+}
+
+size_t toml_arena_reserved(const TomlArena *self) {
+  return self->reserved;
+}
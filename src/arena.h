@@ -0,0 +1,61 @@
+#ifndef TREE_SITTER_TOML_ARENA_H_
+#define TREE_SITTER_TOML_ARENA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/*
+ *  Bump allocator for decoded documents.
+ *
+ *  Allocations are carved out of a few large blocks and are only released
+ *  all at once, by `toml_arena_delete` or `toml_arena_reset`. The first
+ *  block is sized by the caller, every further block is at least twice as
+ *  large as the last one.
+ */
+
+typedef struct TomlArena TomlArena;
+
+/**
+ * Create an arena whose first block can hold `capacity` bytes.
+ */
+TomlArena *toml_arena_new(size_t capacity);
+
+/**
+ * Estimate the capacity needed to decode a document of `length` source bytes,
+ * so that most documents fit in the first block.
+ */
+size_t toml_arena_capacity_for_source(size_t length);
+
+void toml_arena_delete(TomlArena *self);
+
+/**
+ * Release every allocation at once but keep the largest block, so that an
+ * arena reused for documents of about the same size stops allocating.
+ */
+void toml_arena_reset(TomlArena *self);
+
+/**
+ * Allocate `size` bytes aligned for any scalar type, or NULL when out of memory.
+ */
+void *toml_arena_alloc(TomlArena *self, size_t size);
+
+/**
+ * Resize an allocation of `old_size` bytes. The most recent allocation grows
+ * and shrinks in place; anything else is copied and its old space is left
+ * unused until the arena is deleted.
+ */
+void *toml_arena_realloc(TomlArena *self, void *pointer, size_t old_size, size_t new_size);
+
+/**
+ * Total number of bytes reserved by the arena's blocks.
+ */
+size_t toml_arena_reserved(const TomlArena *self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_ARENA_H_
@@ -0,0 +1,106 @@
+#include "./value.h"
+#include <string.h>
+
+#define TOML_DATETIME_MAX_FRACTION_LENGTH 9
+
+static const uint8_t toml_datetime__days_in_month[13] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+// multiplier that turns the first `n` fractional digits into nanoseconds
+static const uint32_t toml_datetime__fraction_scale[TOML_DATETIME_MAX_FRACTION_LENGTH + 1] = {
+  0, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1,
+};
+
+static inline uint32_t toml_datetime__two_digits(const char *text) {
+  return (uint32_t)(text[0] - '0') * 10 + (uint32_t)(text[1] - '0');
+}
+
+static inline uint32_t toml_datetime__digits(const char *text, uint32_t count) {
+  uint32_t value = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    value = value * 10 + (uint32_t)(text[i] - '0');
+  }
+  return value;
+}
+
+static inline bool toml_datetime__is_leap_year(int64_t year) {
+  return (year % 4 == 0) & ((year % 100 != 0) | (year % 400 == 0));
+}
+
+// Days from 1970-01-01 to a proleptic Gregorian date, see
+// http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+static inline int64_t toml_datetime__days_from_civil(int64_t year, uint32_t month, uint32_t day) {
+  year -= month <= 2;
+  int64_t era = (year >= 0 ? year : year - 399) / 400;
+  int64_t year_of_era = year - era * 400;
+  int64_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  return era * 146097 + day_of_era - 719468;
+}
+
+bool toml_decode_datetime(const char *text, uint32_t length, TomlValueType type, TomlDatetime *result) {
+  memset(result, 0, sizeof(TomlDatetime));
+  uint32_t i = 0;
+
+  if (type != TomlValueTypeLocalTime) {
+    // the grammar takes any number of year digits, RFC 3339 only four
+    if (length < 10 || text[4] != '-') return false;
+
+    uint32_t year = toml_datetime__two_digits(text) * 100 + toml_datetime__two_digits(text + 2);
+    uint32_t month = toml_datetime__two_digits(text + 5);
+    uint32_t day = toml_datetime__two_digits(text + 8);
+
+    uint32_t days_in_month = toml_datetime__days_in_month[month]
+      + (uint32_t)((month == 2) & toml_datetime__is_leap_year(year));
+    if (day > days_in_month) return false;
+
+    result->year = (int32_t)year;
+    result->month = (uint8_t)month;
+    result->day = (uint8_t)day;
+    if (type == TomlValueTypeLocalDate) return true;
+    i = 11;
+  }
+
+  if (length < i + 8) return false;
+  result->hour = (uint8_t)toml_datetime__two_digits(text + i);
+  result->minute = (uint8_t)toml_datetime__two_digits(text + i + 3);
+  result->second = (uint8_t)toml_datetime__two_digits(text + i + 6);
+  i += 8;
+
+  if (i < length && text[i] == '.') {
+    uint32_t start = ++i;
+    while (i < length && text[i] >= '0' && text[i] <= '9') i++;
+
+    // digits past nanoseconds are truncated, however many there are
+    uint32_t count = i - start;
+    if (count > TOML_DATETIME_MAX_FRACTION_LENGTH) count = TOML_DATETIME_MAX_FRACTION_LENGTH;
+    result->nanosecond = toml_datetime__digits(text + start, count) * toml_datetime__fraction_scale[count];
+  }
+
+  if (type == TomlValueTypeOffsetDateTime) {
+    if (i >= length) return false;
+    if (text[i] != 'z' && text[i] != 'Z') {
+      if (length < i + 6) return false;
+      int16_t minutes = (int16_t)(toml_datetime__two_digits(text + i + 1) * 60 + toml_datetime__two_digits(text + i + 4));
+      result->offset_minutes = text[i] == '-' ? -minutes : minutes;
+    }
+  }
+
+  return true;
+}
+
+bool toml_datetime_epoch_micros(const TomlDatetime *self, int64_t *result) {
+  int64_t days = 0;
+  if (self->month != 0) {
+    days = toml_datetime__days_from_civil(self->year, self->month, self->day);
+    // one day short of where `days * 86400000000` would overflow, leaving room for the time of day
+    if (days >= INT64_MAX / 86400000000 - 1) return false;
+  }
+
+  int64_t seconds = days * 86400
+    + (int64_t)self->hour * 3600
+    + (int64_t)self->minute * 60
+    + (int64_t)self->second
+    - (int64_t)self->offset_minutes * 60;
+  *result = seconds * 1000000 + (int64_t)(self->nanosecond / 1000);
+  return true;
+}
@@ -0,0 +1,538 @@
+#include "./value.h"
+#include "./power_of_five.h"
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define TOML_NUMBER_SWAR 1
+#endif
+
+// value of a hex digit plus one, 0 for any other byte
+static const uint8_t toml_number__hex[256] = {
+  ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5, ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+  ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+  ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+#ifdef TOML_NUMBER_SWAR
+
+static inline uint64_t toml_number__load8(const char *text) {
+  uint64_t value;
+  memcpy(&value, text, sizeof(value));
+  return value;
+}
+
+static inline bool toml_number__is_eight_digits(uint64_t value) {
+  return !(((value + 0x4646464646464646) | (value - 0x3030303030303030)) & 0x8080808080808080);
+}
+
+// Converts eight ASCII digits, first digit in the lowest byte, with three multiplications.
+static inline uint32_t toml_number__parse_eight_digits(uint64_t value) {
+  const uint64_t mask = 0x000000ff000000ff;
+  const uint64_t mul1 = 0x000f424000000064;  // 100 + (1000000 << 32)
+  const uint64_t mul2 = 0x0000271000000001;  // 1 + (10000 << 32)
+  value -= 0x3030303030303030;
+  value = (value * 10) + (value >> 8);
+  value = (((value & mask) * mul1) + (((value >> 16) & mask) * mul2)) >> 32;
+  return (uint32_t)value;
+}
+
+#endif
+
+// Reads decimal digits and underscores into `value`, failing past 19 digits,
+// which is more than any int64 has and still cannot overflow a uint64.
+static inline bool toml_number__decimal(const char *text, uint32_t length, uint64_t *result) {
+  uint64_t value = 0;
+  uint32_t digits = 0;
+  uint32_t i = 0;
+
+  while (i < length) {
+#ifdef TOML_NUMBER_SWAR
+    if (length - i >= 8) {
+      uint64_t block = toml_number__load8(text + i);
+      if (toml_number__is_eight_digits(block)) {
+        digits += 8;
+        if (digits > 19) return false;
+        value = value * 100000000 + toml_number__parse_eight_digits(block);
+        i += 8;
+        continue;
+      }
+    }
+#endif
+
+    char c = text[i++];
+    if (c == '_') continue;
+    if (++digits > 19) return false;
+    value = value * 10 + (uint64_t)(c - '0');
+  }
+
+  *result = value;
+  return true;
+}
+
+bool toml_decode_integer(const char *text, uint32_t length, int64_t *result) {
+  uint32_t i = 0;
+  bool negative = false;
+  if (text[0] == '+' || text[0] == '-') {
+    negative = text[0] == '-';
+    i++;
+  }
+
+  unsigned shift = 0;
+  if (length - i > 2 && text[i] == '0') {
+    switch (text[i + 1]) {
+      case 'x': shift = 4; break;
+      case 'o': shift = 3; break;
+      case 'b': shift = 1; break;
+    }
+  }
+
+  if (shift == 0) {
+    uint64_t value;
+    uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+    if (!toml_number__decimal(text + i, length - i, &value) || value > limit) return false;
+    *result = negative ? (int64_t)(0 - value) : (int64_t)value;
+    return true;
+  }
+
+  // prefixed integers are never signed, but may have leading zeros
+  uint64_t value = 0;
+  for (i += 2; i < length; i++) {
+    if (text[i] == '_') continue;
+    if (value > ((uint64_t)INT64_MAX >> shift)) return false;
+    value = (value << shift) | (uint64_t)(toml_number__hex[(unsigned char)text[i]] - 1);
+  }
+
+  *result = (int64_t)value;
+  return true;
+}
+
+/*
+ *  Floats
+ */
+
+#define TOML_FLOAT_MANTISSA_BITS 52
+#define TOML_FLOAT_MINIMUM_EXPONENT (-1023)
+#define TOML_FLOAT_INFINITE_POWER 0x7ff
+#define TOML_DECIMAL_MAX_DIGITS 800
+#define TOML_DECIMAL_MAX_SHIFT 60
+
+typedef struct {
+  uint64_t high;
+  uint64_t low;
+} TomlUint128;
+
+static inline TomlUint128 toml_number__multiply(uint64_t a, uint64_t b) {
+  TomlUint128 result;
+#if defined(__SIZEOF_INT128__)
+  __extension__ unsigned __int128 product = (unsigned __int128)a * b;
+  result.high = (uint64_t)(product >> 64);
+  result.low = (uint64_t)product;
+#else
+  uint64_t a_low = (uint32_t)a, a_high = a >> 32;
+  uint64_t b_low = (uint32_t)b, b_high = b >> 32;
+  uint64_t low_low = a_low * b_low;
+  uint64_t high_low = a_high * b_low;
+  uint64_t low_high = a_low * b_high;
+  uint64_t high_high = a_high * b_high;
+  uint64_t middle = high_low + (low_low >> 32) + (uint32_t)low_high;
+  result.high = high_high + (middle >> 32) + (low_high >> 32);
+  result.low = (middle << 32) | (uint32_t)low_low;
+#endif
+  return result;
+}
+
+static inline int toml_number__leading_zeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_clzll(value);
+#else
+  int count = 0;
+  while (!(value & 0x8000000000000000)) {
+    value <<= 1;
+    count++;
+  }
+  return count;
+#endif
+}
+
+static inline double toml_number__from_bits(uint64_t mantissa, int32_t power2, bool negative) {
+  uint64_t bits = mantissa | ((uint64_t)power2 << TOML_FLOAT_MANTISSA_BITS);
+  if (negative) bits |= (uint64_t)1 << 63;
+  double result;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+// Eisel-Lemire: the correctly rounded double nearest to w * 10^q, as an
+// explicit mantissa and biased exponent. Returns false when even the 128-bit
+// product with the precomputed power of five leaves the rounding open, which
+// only a power of ten that is not exact in the table can do.
+static bool toml_number__eisel_lemire(int64_t q, uint64_t w, uint64_t *mantissa, int32_t *power2) {
+  if (w == 0 || q < TOML_SMALLEST_POWER_OF_FIVE) {
+    *mantissa = 0;
+    *power2 = 0;
+    return true;
+  }
+  if (q > TOML_LARGEST_POWER_OF_FIVE) {
+    *mantissa = 0;
+    *power2 = TOML_FLOAT_INFINITE_POWER;
+    return true;
+  }
+
+  int lz = toml_number__leading_zeros(w);
+  w <<= lz;
+
+  const uint64_t *power = &toml_power_of_five_128[2 * (q - TOML_SMALLEST_POWER_OF_FIVE)];
+  TomlUint128 product = toml_number__multiply(w, power[0]);
+  const uint64_t precision_mask = UINT64_MAX >> (TOML_FLOAT_MANTISSA_BITS + 3);
+  if ((product.high & precision_mask) == precision_mask) {
+    TomlUint128 second = toml_number__multiply(w, power[1]);
+    product.low += second.high;
+    if (second.high > product.low) product.high++;
+    // outside [-27, 55] the bits of the power of five that the table cuts off
+    // could still carry into a product that is all ones
+    if (product.low == UINT64_MAX && (q < -27 || q > 55)) return false;
+  }
+
+  int upper_bit = (int)(product.high >> 63);
+  int shift = upper_bit + 64 - TOML_FLOAT_MANTISSA_BITS - 3;
+  uint64_t m = product.high >> shift;
+  // floor(log2(10^q)) + 63, valid for the whole table
+  int32_t p = (int32_t)((((152170 + 65536) * q) >> 16) + 63) + upper_bit - lz - TOML_FLOAT_MINIMUM_EXPONENT;
+
+  if (p <= 0) {
+    // subnormal, or zero if even the rounding bit is shifted out
+    if (-p + 1 >= 64) {
+      *mantissa = 0;
+      *power2 = 0;
+      return true;
+    }
+    m >>= -p + 1;
+    m += m & 1;
+    m >>= 1;
+    *mantissa = m & ~((uint64_t)1 << TOML_FLOAT_MANTISSA_BITS);
+    *power2 = m < ((uint64_t)1 << TOML_FLOAT_MANTISSA_BITS) ? 0 : 1;
+    return true;
+  }
+
+  // exactly halfway between two doubles, round to even instead of up
+  if (product.low <= 1 && q >= -4 && q <= 23 && (m & 3) == 1 && (m << shift) == product.high) {
+    m &= ~(uint64_t)1;
+  }
+
+  m += m & 1;
+  m >>= 1;
+  if (m >= ((uint64_t)2 << TOML_FLOAT_MANTISSA_BITS)) {
+    m = (uint64_t)1 << TOML_FLOAT_MANTISSA_BITS;
+    p++;
+  }
+
+  if (p >= TOML_FLOAT_INFINITE_POWER) {
+    *mantissa = 0;
+    *power2 = TOML_FLOAT_INFINITE_POWER;
+    return true;
+  }
+
+  *mantissa = m & ~((uint64_t)1 << TOML_FLOAT_MANTISSA_BITS);
+  *power2 = p;
+  return true;
+}
+
+/*
+ *  Simple decimal conversion, the exact fallback for inputs with more than
+ *  19 significant digits whose truncation makes Eisel-Lemire ambiguous, and
+ *  for the products Eisel-Lemire cannot round. It shifts a fixed-size decimal
+ *  by powers of two, as Go's strconv does.
+ */
+
+typedef struct {
+  uint8_t digits[TOML_DECIMAL_MAX_DIGITS + TOML_DECIMAL_MAX_SHIFT];
+  int32_t count;
+  int32_t decimal_point;
+  bool truncated;
+} TomlDecimal;
+
+static void toml_decimal__trim(TomlDecimal *self) {
+  while (self->count > 0 && self->digits[self->count - 1] == 0) self->count--;
+  if (self->count == 0) self->decimal_point = 0;
+}
+
+static void toml_decimal__shift_left(TomlDecimal *self, unsigned shift) {
+  // multiplying by 2^shift adds at most floor(shift * log10(2)) + 1 digits
+  int32_t delta = (int32_t)((shift * 1233) >> 12) + 1;
+  int32_t read = self->count;
+  int32_t write = self->count + delta;
+  uint64_t n = 0;
+
+  while (read > 0 || n > 0) {
+    if (read > 0) n += (uint64_t)self->digits[--read] << shift;
+    uint64_t quotient = n / 10;
+    self->digits[--write] = (uint8_t)(n - 10 * quotient);
+    n = quotient;
+  }
+
+  // the estimate may be one digit too many
+  if (write > 0) {
+    memmove(self->digits, self->digits + write, (size_t)(self->count + delta - write));
+    delta -= write;
+  }
+
+  self->count += delta;
+  self->decimal_point += delta;
+  if (self->count > TOML_DECIMAL_MAX_DIGITS) {
+    for (int32_t i = TOML_DECIMAL_MAX_DIGITS; i < self->count; i++) {
+      if (self->digits[i]) self->truncated = true;
+    }
+    self->count = TOML_DECIMAL_MAX_DIGITS;
+  }
+  toml_decimal__trim(self);
+}
+
+static void toml_decimal__shift_right(TomlDecimal *self, unsigned shift) {
+  int32_t read = 0;
+  int32_t write = 0;
+  uint64_t n = 0;
+
+  for (; (n >> shift) == 0; read++) {
+    if (read >= self->count) {
+      if (n == 0) {
+        self->count = 0;
+        return;
+      }
+      while ((n >> shift) == 0) {
+        n *= 10;
+        read++;
+      }
+      break;
+    }
+    n = n * 10 + self->digits[read];
+  }
+  self->decimal_point -= read - 1;
+
+  uint64_t mask = ((uint64_t)1 << shift) - 1;
+  for (; read < self->count; read++) {
+    self->digits[write++] = (uint8_t)(n >> shift);
+    n = (n & mask) * 10 + self->digits[read];
+  }
+  while (n > 0) {
+    uint8_t digit = (uint8_t)(n >> shift);
+    n = (n & mask) * 10;
+    if (write < TOML_DECIMAL_MAX_DIGITS) {
+      self->digits[write++] = digit;
+    } else if (digit > 0) {
+      self->truncated = true;
+    }
+  }
+
+  self->count = write;
+  toml_decimal__trim(self);
+}
+
+static void toml_decimal__shift(TomlDecimal *self, int shift) {
+  if (self->count == 0) return;
+  for (; shift > TOML_DECIMAL_MAX_SHIFT; shift -= TOML_DECIMAL_MAX_SHIFT) {
+    toml_decimal__shift_left(self, TOML_DECIMAL_MAX_SHIFT);
+  }
+  for (; shift < -TOML_DECIMAL_MAX_SHIFT; shift += TOML_DECIMAL_MAX_SHIFT) {
+    toml_decimal__shift_right(self, TOML_DECIMAL_MAX_SHIFT);
+  }
+  if (shift > 0) toml_decimal__shift_left(self, (unsigned)shift);
+  if (shift < 0) toml_decimal__shift_right(self, (unsigned)-shift);
+}
+
+static uint64_t toml_decimal__rounded_integer(const TomlDecimal *self) {
+  if (self->decimal_point > 20) return UINT64_MAX;
+
+  int32_t i = 0;
+  uint64_t n = 0;
+  for (; i < self->decimal_point && i < self->count; i++) n = n * 10 + self->digits[i];
+  for (; i < self->decimal_point; i++) n *= 10;
+
+  int32_t next = self->decimal_point;
+  if (next >= 0 && next < self->count) {
+    uint8_t digit = self->digits[next];
+    bool halfway = digit == 5 && next + 1 == self->count;
+    if (halfway ? self->truncated || (next > 0 && (self->digits[next - 1] & 1)) : digit >= 5) n++;
+  }
+  return n;
+}
+
+static void toml_decimal__to_double(TomlDecimal *self, uint64_t *mantissa, int32_t *power2) {
+  static const int powers[] = {1, 3, 6, 9, 13, 16, 19, 23, 26};
+  const int power_count = sizeof(powers) / sizeof(powers[0]);
+
+  if (self->count == 0 || self->decimal_point < -330) {
+    *mantissa = 0;
+    *power2 = 0;
+    return;
+  }
+  if (self->decimal_point > 310) {
+    *mantissa = 0;
+    *power2 = TOML_FLOAT_INFINITE_POWER;
+    return;
+  }
+
+  // scale to [0.5, 1) while counting the binary exponent
+  int32_t exponent = 0;
+  while (self->decimal_point > 0) {
+    int n = self->decimal_point >= power_count ? 27 : powers[self->decimal_point];
+    toml_decimal__shift(self, -n);
+    exponent += n;
+  }
+  while (self->decimal_point < 0 || (self->decimal_point == 0 && self->digits[0] < 5)) {
+    int n = -self->decimal_point >= power_count ? 27 : powers[-self->decimal_point];
+    toml_decimal__shift(self, n);
+    exponent -= n;
+  }
+
+  exponent--;
+  if (exponent < TOML_FLOAT_MINIMUM_EXPONENT + 1) {
+    int n = TOML_FLOAT_MINIMUM_EXPONENT + 1 - exponent;
+    toml_decimal__shift(self, -n);
+    exponent += n;
+  }
+  if (exponent - TOML_FLOAT_MINIMUM_EXPONENT >= TOML_FLOAT_INFINITE_POWER) {
+    *mantissa = 0;
+    *power2 = TOML_FLOAT_INFINITE_POWER;
+    return;
+  }
+
+  toml_decimal__shift(self, 1 + TOML_FLOAT_MANTISSA_BITS);
+  uint64_t m = toml_decimal__rounded_integer(self);
+  if (m == ((uint64_t)2 << TOML_FLOAT_MANTISSA_BITS)) {
+    m >>= 1;
+    exponent++;
+    if (exponent - TOML_FLOAT_MINIMUM_EXPONENT >= TOML_FLOAT_INFINITE_POWER) {
+      *mantissa = 0;
+      *power2 = TOML_FLOAT_INFINITE_POWER;
+      return;
+    }
+  }
+  if (!(m & ((uint64_t)1 << TOML_FLOAT_MANTISSA_BITS))) exponent = TOML_FLOAT_MINIMUM_EXPONENT;
+
+  *mantissa = m & (((uint64_t)1 << TOML_FLOAT_MANTISSA_BITS) - 1);
+  *power2 = exponent - TOML_FLOAT_MINIMUM_EXPONENT;
+}
+
+static void toml_decimal__init(TomlDecimal *self, const char *text, uint32_t length, int64_t exponent) {
+  self->count = 0;
+  self->decimal_point = 0;
+  self->truncated = false;
+  bool saw_point = false;
+
+  for (uint32_t i = 0; i < length; i++) {
+    char c = text[i];
+    if (c == '_' || c == '+' || c == '-') continue;
+    if (c == '.') {
+      saw_point = true;
+      self->decimal_point = self->count;
+      continue;
+    }
+    if (c == 'e' || c == 'E') break;
+    if (c == '0' && self->count == 0) {
+      self->decimal_point--;
+      continue;
+    }
+    if (self->count < TOML_DECIMAL_MAX_DIGITS) {
+      self->digits[self->count++] = (uint8_t)(c - '0');
+    } else if (c != '0') {
+      self->truncated = true;
+    }
+  }
+
+  if (!saw_point) self->decimal_point = self->count;
+  self->decimal_point += (int32_t)exponent;
+  toml_decimal__trim(self);
+}
+
+bool toml_decode_float(const char *text, uint32_t length, double *result) {
+  static const double powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+  };
+
+  uint32_t i = 0;
+  bool negative = false;
+  if (text[0] == '+' || text[0] == '-') {
+    negative = text[0] == '-';
+    i++;
+  }
+
+  if (i < length && (text[i] == 'i' || text[i] == 'n')) {
+    uint64_t mantissa = text[i] == 'n' ? (uint64_t)1 << (TOML_FLOAT_MANTISSA_BITS - 1) : 0;
+    *result = toml_number__from_bits(mantissa, TOML_FLOAT_INFINITE_POWER, negative);
+    return true;
+  }
+
+  // up to 19 significant digits fit in w, the rest only move the exponent
+  uint64_t w = 0;
+  int64_t exponent = 0;
+  uint32_t digits = 0;
+  bool truncated = false;
+  bool in_fraction = false;
+  uint32_t mantissa_end = length;
+
+  for (; i < length; i++) {
+    char c = text[i];
+    if (c == '_') continue;
+    if (c == '.') {
+      in_fraction = true;
+      continue;
+    }
+    if (c == 'e' || c == 'E') {
+      mantissa_end = i;
+      break;
+    }
+    if (c < '0' || c > '9') return false;
+
+    if (digits < 19) {
+      w = w * 10 + (uint64_t)(c - '0');
+      if (w) digits++;
+      if (in_fraction) exponent--;
+    } else {
+      truncated |= c != '0';
+      if (!in_fraction) exponent++;
+    }
+  }
+
+  int64_t explicit_exponent = 0;
+  if (mantissa_end < length) {
+    bool negative_exponent = false;
+    for (i = mantissa_end + 1; i < length; i++) {
+      char c = text[i];
+      if (c == '-') negative_exponent = true;
+      if (c < '0' || c > '9') continue;
+      if (explicit_exponent < 100000) explicit_exponent = explicit_exponent * 10 + (c - '0');
+    }
+    if (negative_exponent) explicit_exponent = -explicit_exponent;
+    exponent += explicit_exponent;
+  }
+
+  // Clinger's fast path: both operands are exact doubles, so is the result
+  if (!truncated && w <= ((uint64_t)1 << 53) && exponent >= -22 && exponent <= 22) {
+    double value = (double)w;
+    value = exponent < 0 ? value / powers_of_ten[-exponent] : value * powers_of_ten[exponent];
+    *result = negative ? -value : value;
+    return true;
+  }
+
+  uint64_t mantissa;
+  int32_t power2;
+  bool decided = toml_number__eisel_lemire(exponent, w, &mantissa, &power2);
+
+  if (decided && truncated) {
+    // the exact value lies between w and w + 1, both have to round the same way
+    uint64_t upper_mantissa;
+    int32_t upper_power2;
+    decided = toml_number__eisel_lemire(exponent, w + 1, &upper_mantissa, &upper_power2)
+      && upper_mantissa == mantissa && upper_power2 == power2;
+  }
+
+  if (!decided) {
+    TomlDecimal decimal;
+    toml_decimal__init(&decimal, text, mantissa_end, explicit_exponent);
+    toml_decimal__to_double(&decimal, &mantissa, &power2);
+  }
+
+  *result = toml_number__from_bits(mantissa, power2, negative);
+  return true;
+}
@@ -0,0 +1,176 @@
+#include "./value.h"
+#include <string.h>
+
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define TOML_STRING_SSE2 1
+#endif
+
+// value of a hex digit plus one, 0 for any other byte
+static const uint8_t toml_string__hex[256] = {
+  ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5, ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+  ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+  ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+// byte produced by a single character escape, or 0
+static const char toml_string__escape[256] = {
+  ['b'] = '\b', ['t'] = '\t', ['n'] = '\n', ['f'] = '\f', ['r'] = '\r', ['"'] = '"', ['\\'] = '\\',
+};
+
+static inline bool toml_string__is_whitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline uint32_t toml_string__encode_utf8(uint32_t code_point, char *output) {
+  if (code_point < 0x80) {
+    output[0] = (char)code_point;
+    return 1;
+  }
+  if (code_point < 0x800) {
+    output[0] = (char)(0xc0 | (code_point >> 6));
+    output[1] = (char)(0x80 | (code_point & 0x3f));
+    return 2;
+  }
+  if (code_point < 0x10000) {
+    output[0] = (char)(0xe0 | (code_point >> 12));
+    output[1] = (char)(0x80 | ((code_point >> 6) & 0x3f));
+    output[2] = (char)(0x80 | (code_point & 0x3f));
+    return 3;
+  }
+  output[0] = (char)(0xf0 | (code_point >> 18));
+  output[1] = (char)(0x80 | ((code_point >> 12) & 0x3f));
+  output[2] = (char)(0x80 | ((code_point >> 6) & 0x3f));
+  output[3] = (char)(0x80 | (code_point & 0x3f));
+  return 4;
+}
+
+// Reads `count` hex digits, or returns a value above U+10FFFF if one is invalid.
+static inline uint32_t toml_string__hex_digits(const char *input, uint32_t count) {
+  uint32_t code_point = 0;
+  int invalid = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    int digit = (int)toml_string__hex[(unsigned char)input[i]] - 1;
+    invalid |= digit;
+    code_point = (code_point << 4) | (uint32_t)(digit & 0xf);
+  }
+  return invalid < 0 ? UINT32_MAX : code_point;
+}
+
+// Copies the bytes before the next backslash and returns their count. Only
+// blocks without a backslash are stored whole: `output` never runs ahead of
+// `input`, so such a store only overwrites input that has already been read,
+// while a whole block stored past a backslash could clobber the escape when
+// decoding in place.
+static inline uint32_t toml_string__copy_plain(const char *input, uint32_t length, char *output) {
+  uint32_t i = 0;
+
+#ifdef TOML_STRING_SSE2
+  const __m128i backslash = _mm_set1_epi8('\\');
+  for (; i + 16 <= length; i += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i *)(input + i));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, backslash));
+    if (mask) {
+      uint32_t end = i + (uint32_t)__builtin_ctz((unsigned)mask);
+      memmove(output + i, input + i, end - i);
+      return end;
+    }
+    _mm_storeu_si128((__m128i *)(output + i), block);
+  }
+#endif
+
+  const char *found = memchr(input + i, '\\', length - i);
+  uint32_t end = found ? (uint32_t)(found - input) : length;
+  memmove(output + i, input + i, end - i);
+  return end;
+}
+
+bool toml_decode_string_body(const char *input, uint32_t length, char *output, uint32_t *output_length) {
+  uint32_t i = 0;
+  uint32_t j = 0;
+
+  for (;;) {
+    uint32_t plain = toml_string__copy_plain(input + i, length - i, output + j);
+    i += plain;
+    j += plain;
+    if (i == length) break;
+
+    // input[i] is a backslash
+    if (i + 1 == length) return false;
+    char c = input[i + 1];
+    i += 2;
+
+    char escaped = toml_string__escape[(unsigned char)c];
+    if (escaped) {
+      output[j++] = escaped;
+      continue;
+    }
+
+    if (c == 'u' || c == 'U') {
+      uint32_t digits = c == 'u' ? 4 : 8;
+      if (length - i < digits) return false;
+      uint32_t code_point = toml_string__hex_digits(input + i, digits);
+      if (code_point > 0x10ffff || (code_point >= 0xd800 && code_point <= 0xdfff)) return false;
+      j += toml_string__encode_utf8(code_point, output + j);
+      i += digits;
+      continue;
+    }
+
+    // line ending backslash, trims all whitespace up to the next non-whitespace character
+    uint32_t k = i - 1;
+    while (k < length && (input[k] == ' ' || input[k] == '\t')) k++;
+    if (k < length && input[k] == '\r') k++;
+    if (k == length || input[k] != '\n') return false;
+    while (k < length && toml_string__is_whitespace(input[k])) k++;
+    i = k;
+  }
+
+  *output_length = j;
+  return true;
+}
+
+// Strips the delimiters, and the newline that may follow an opening triple
+// quote, and returns whether the string is a basic one.
+static inline bool toml_string__body(const char *text, uint32_t length, const char **body, uint32_t *body_length) {
+  uint32_t delimiter_length = length >= 6 && text[1] == text[0] && text[2] == text[0] ? 3 : 1;
+  *body = text + delimiter_length;
+  *body_length = length - 2 * delimiter_length;
+
+  if (delimiter_length == 3) {
+    if (*body_length > 0 && (*body)[0] == '\n') {
+      *body += 1;
+      *body_length -= 1;
+    } else if (*body_length > 1 && (*body)[0] == '\r' && (*body)[1] == '\n') {
+      *body += 2;
+      *body_length -= 2;
+    }
+  }
+
+  return text[0] == '"';
+}
+
+bool toml_decode_string(const char *text, uint32_t length, char *output, uint32_t *output_length) {
+  const char *body;
+  uint32_t body_length;
+
+  if (toml_string__body(text, length, &body, &body_length)) {
+    return toml_decode_string_body(body, body_length, output, output_length);
+  }
+
+  memcpy(output, body, body_length);
+  *output_length = body_length;
+  return true;
+}
+
+bool toml_decode_string_view(const char *text, uint32_t length, TomlString *result) {
+  const char *body;
+  uint32_t body_length;
+
+  if (toml_string__body(text, length, &body, &body_length) && memchr(body, '\\', body_length)) {
+    return false;
+  }
+
+  result->data = body;
+  result->length = body_length;
+  return true;
+}
@@ -0,0 +1,49 @@
+#include "./fold.h"
+#include "./syntax.h"
+
+static bool toml_fold__is_fold(const TomlSyntaxSymbols *symbols, TSSymbol symbol) {
+  return symbol == symbols->table
+    || symbol == symbols->table_array_element
+    || symbol == symbols->array
+    || symbol == symbols->inline_table
+    || symbol == symbols->string;
+}
+
+uint32_t toml_fold_tree(const TSTree *tree, TomlFold *folds, uint32_t capacity) {
+  TomlSyntaxSymbols symbols;
+  toml_syntax_init_symbols(&symbols, ts_tree_language(tree));
+
+  TSTreeCursor cursor = ts_tree_cursor_new(ts_tree_root_node(tree));
+  uint32_t count = 0;
+
+  for (;;) {
+    TSNode node = ts_tree_cursor_current_node(&cursor);
+    TSPoint start = ts_node_start_point(node);
+    TSPoint end = ts_node_end_point(node);
+
+    // a node that ends at the start of a row, after its line ending, ends on the row before
+    uint32_t end_row = end.column == 0 && end.row > start.row ? end.row - 1 : end.row;
+
+    if (end_row > start.row) {
+      if (toml_fold__is_fold(&symbols, ts_node_symbol(node))) {
+        if (count < capacity) {
+          folds[count] = (TomlFold) {ts_node_start_byte(node), ts_node_end_byte(node), start.row, end_row};
+        }
+        count++;
+      }
+      if (ts_tree_cursor_goto_first_child(&cursor)) continue;
+    }
+
+    bool done = false;
+    while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+      if (!ts_tree_cursor_goto_parent(&cursor)) {
+        done = true;
+        break;
+      }
+    }
+    if (done) break;
+  }
+
+  ts_tree_cursor_delete(&cursor);
+  return count;
+}
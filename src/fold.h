@@ -0,0 +1,39 @@
+#ifndef TREE_SITTER_TOML_FOLD_H_
+#define TREE_SITTER_TOML_FOLD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <tree_sitter/api.h>
+
+/*
+ *  Folding.
+ *
+ *  The fold ranges of `queries/folds.scm`, found without the query engine in
+ *  one walk of a tree cursor: every `table`, `table_array_element`, `array`,
+ *  `inline_table` and multiline `string` that spans more than one row. A
+ *  node on a single row cannot hold a fold, so the walk never descends into
+ *  one, and a document of one-line pairs costs about one step per pair.
+ */
+
+typedef struct {
+  uint32_t start_byte;
+  uint32_t end_byte;
+  uint32_t start_row;
+  uint32_t end_row;  // the last row with text of the node, not the row after its line ending
+} TomlFold;
+
+/**
+ * Write up to `capacity` folds of `tree` to `folds`, outer folds before the
+ * ones inside them and otherwise in document order, returning how many there
+ * are in total.
+ */
+uint32_t toml_fold_tree(const TSTree *tree, TomlFold *folds, uint32_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_FOLD_H_
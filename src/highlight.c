@@ -0,0 +1,123 @@
+#include "./highlight.h"
+#include "./highlight_symbols.h"
+
+static const char *const toml_highlight_names[TomlHighlightCount] = {
+  [TomlHighlightNone] = NULL,
+  [TomlHighlightProperty] = "property",
+  [TomlHighlightString] = "string",
+  [TomlHighlightConstantBuiltin] = "constant.builtin",
+  [TomlHighlightComment] = "comment",
+  [TomlHighlightNumber] = "number",
+  [TomlHighlightStringSpecial] = "string.special",
+  [TomlHighlightPunctuationDelimiter] = "punctuation.delimiter",
+  [TomlHighlightOperator] = "operator",
+  [TomlHighlightPunctuationBracket] = "punctuation.bracket",
+};
+
+const char *toml_highlight_name(TomlHighlight highlight) {
+  return highlight < TomlHighlightCount ? toml_highlight_names[highlight] : NULL;
+}
+
+TomlHighlight toml_highlight_for_symbol(TSSymbol symbol) {
+  return symbol < TOML_HIGHLIGHT_SYMBOL_COUNT ? (TomlHighlight)toml_highlight_symbols[symbol] : TomlHighlightNone;
+}
+
+// The part of a document to highlight, in bytes or in rows.
+typedef struct {
+  bool by_row;
+  uint32_t start;
+  uint32_t end;
+} TomlHighlightWindow;
+
+static bool toml_highlight__ends_before(const TomlHighlightWindow *window, TSNode node) {
+  if (!window->by_row) return ts_node_end_byte(node) <= window->start;
+  TSPoint end = ts_node_end_point(node);
+  return end.row < window->start || (end.row == window->start && end.column == 0);
+}
+
+static bool toml_highlight__starts_after(const TomlHighlightWindow *window, TSNode node) {
+  if (!window->by_row) return ts_node_start_byte(node) >= window->end;
+  return ts_node_start_point(node).row >= window->end;
+}
+
+// Moves to the first child that does not end before the window, if any.
+static bool toml_highlight__goto_first_child(TSTreeCursor *cursor, const TomlHighlightWindow *window) {
+  if (!window->by_row) return ts_tree_cursor_goto_first_child_for_byte(cursor, window->start) >= 0;
+
+  if (!ts_tree_cursor_goto_first_child(cursor)) return false;
+  while (toml_highlight__ends_before(window, ts_tree_cursor_current_node(cursor))) {
+    if (!ts_tree_cursor_goto_next_sibling(cursor)) {
+      ts_tree_cursor_goto_parent(cursor);
+      return false;
+    }
+  }
+  return true;
+}
+
+static uint32_t toml_highlight__window(
+  const TSTree *tree,
+  const TomlHighlightWindow *window,
+  TomlHighlightSpan *spans,
+  uint32_t capacity
+) {
+  TSTreeCursor cursor = ts_tree_cursor_new(ts_tree_root_node(tree));
+  uint32_t count = 0;
+
+  for (;;) {
+    TSNode node = ts_tree_cursor_current_node(&cursor);
+
+    // every node after this one in the walk starts no earlier
+    if (toml_highlight__starts_after(window, node)) break;
+
+    TomlHighlight highlight = toml_highlight_for_symbol(ts_node_symbol(node));
+    if (highlight != TomlHighlightNone) {
+      uint32_t start_byte = ts_node_start_byte(node);
+      uint32_t end_byte = ts_node_end_byte(node);
+      // nodes that error recovery inserted have nothing to color
+      if (end_byte > start_byte) {
+        if (count < capacity) spans[count] = (TomlHighlightSpan) {start_byte, end_byte, highlight};
+        count++;
+      }
+    } else if (toml_highlight__goto_first_child(&cursor, window)) {
+      continue;
+    }
+
+    bool done = false;
+    while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+      if (!ts_tree_cursor_goto_parent(&cursor)) {
+        done = true;
+        break;
+      }
+    }
+    if (done) break;
+  }
+
+  ts_tree_cursor_delete(&cursor);
+  return count;
+}
+
+uint32_t toml_highlight_tree(const TSTree *tree, TomlHighlightSpan *spans, uint32_t capacity) {
+  return toml_highlight_bytes(tree, 0, UINT32_MAX, spans, capacity);
+}
+
+uint32_t toml_highlight_bytes(
+  const TSTree *tree,
+  uint32_t start_byte,
+  uint32_t end_byte,
+  TomlHighlightSpan *spans,
+  uint32_t capacity
+) {
+  TomlHighlightWindow window = {false, start_byte, end_byte};
+  return toml_highlight__window(tree, &window, spans, capacity);
+}
+
+uint32_t toml_highlight_rows(
+  const TSTree *tree,
+  uint32_t start_row,
+  uint32_t end_row,
+  TomlHighlightSpan *spans,
+  uint32_t capacity
+) {
+  TomlHighlightWindow window = {true, start_row, end_row};
+  return toml_highlight__window(tree, &window, spans, capacity);
+}
@@ -0,0 +1,96 @@
+#ifndef TREE_SITTER_TOML_HIGHLIGHT_H_
+#define TREE_SITTER_TOML_HIGHLIGHT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <tree_sitter/api.h>
+
+/*
+ *  Syntax highlighting.
+ *
+ *  `queries/highlights.scm` only maps node types to capture names, with no
+ *  predicates and no patterns over more than one node, so it needs none of
+ *  the query engine. The highlighter looks the symbol of each node up in a
+ *  table generated from the query and `src/parser.c` (see
+ *  `scripts/generate-highlights.js`) and finds every span in one walk of a
+ *  tree cursor. It does not descend into a captured node, such as a string
+ *  with escapes, so spans never nest or overlap.
+ *
+ *  A viewer that shows a few lines of a large file highlights only those.
+ *  The walk then jumps past the subtrees that end before the window with
+ *  `ts_tree_cursor_goto_first_child_for_byte` and stops at the first node
+ *  that starts after it, so it costs about the depth of the tree plus the
+ *  nodes in view.
+ */
+
+// One per capture name of `queries/highlights.scm`, in order of appearance.
+typedef enum {
+  TomlHighlightNone,
+  TomlHighlightProperty,
+  TomlHighlightString,
+  TomlHighlightConstantBuiltin,
+  TomlHighlightComment,
+  TomlHighlightNumber,
+  TomlHighlightStringSpecial,
+  TomlHighlightPunctuationDelimiter,
+  TomlHighlightOperator,
+  TomlHighlightPunctuationBracket,
+  TomlHighlightCount,
+} TomlHighlight;
+
+typedef struct {
+  uint32_t start_byte;
+  uint32_t end_byte;
+  TomlHighlight highlight;
+} TomlHighlightSpan;
+
+/**
+ * The capture name of a highlight, such as "punctuation.bracket", or NULL
+ * for `TomlHighlightNone`.
+ */
+const char *toml_highlight_name(TomlHighlight highlight);
+
+/**
+ * The highlight of nodes of a symbol of `tree_sitter_toml()`.
+ */
+TomlHighlight toml_highlight_for_symbol(TSSymbol symbol);
+
+/**
+ * Write up to `capacity` spans of `tree` to `spans` in document order,
+ * returning how many there are in total.
+ */
+uint32_t toml_highlight_tree(const TSTree *tree, TomlHighlightSpan *spans, uint32_t capacity);
+
+/**
+ * Like `toml_highlight_tree`, but only for the spans that overlap the bytes
+ * from `start_byte` up to `end_byte`. Spans at the edges are not cut.
+ */
+uint32_t toml_highlight_bytes(
+  const TSTree *tree,
+  uint32_t start_byte,
+  uint32_t end_byte,
+  TomlHighlightSpan *spans,
+  uint32_t capacity
+);
+
+/**
+ * Like `toml_highlight_bytes`, but for the rows from `start_row` up to
+ * `end_row`. Without a byte to jump to, the walk steps over the top-level
+ * nodes before the first row one by one, though not into them.
+ */
+uint32_t toml_highlight_rows(
+  const TSTree *tree,
+  uint32_t start_row,
+  uint32_t end_row,
+  TomlHighlightSpan *spans,
+  uint32_t capacity
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_HIGHLIGHT_H_
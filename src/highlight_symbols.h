@@ -0,0 +1,34 @@
+// Generated by scripts/generate-highlights.js, do not edit.
+
+#ifndef TREE_SITTER_TOML_HIGHLIGHT_SYMBOLS_H_
+#define TREE_SITTER_TOML_HIGHLIGHT_SYMBOLS_H_
+
+#include "./highlight.h"
+
+#define TOML_HIGHLIGHT_SYMBOL_COUNT 69
+
+// the capture of each public symbol of src/parser.c in queries/highlights.scm
+static const uint8_t toml_highlight_symbols[TOML_HIGHLIGHT_SYMBOL_COUNT] = {
+  [2] = TomlHighlightComment,  // "comment"
+  [3] = TomlHighlightPunctuationBracket,  // "["
+  [4] = TomlHighlightPunctuationBracket,  // "]"
+  [5] = TomlHighlightPunctuationBracket,  // "[["
+  [6] = TomlHighlightPunctuationBracket,  // "]]"
+  [7] = TomlHighlightOperator,  // "="
+  [8] = TomlHighlightProperty,  // "bare_key"
+  [9] = TomlHighlightPunctuationDelimiter,  // "."
+  [27] = TomlHighlightConstantBuiltin,  // "boolean"
+  [28] = TomlHighlightStringSpecial,  // "offset_date_time"
+  [29] = TomlHighlightStringSpecial,  // "local_date_time"
+  [30] = TomlHighlightStringSpecial,  // "local_date"
+  [31] = TomlHighlightStringSpecial,  // "local_time"
+  [32] = TomlHighlightPunctuationDelimiter,  // ","
+  [33] = TomlHighlightPunctuationBracket,  // "{"
+  [34] = TomlHighlightPunctuationBracket,  // "}"
+  [48] = TomlHighlightString,  // "quoted_key"
+  [51] = TomlHighlightString,  // "string"
+  [56] = TomlHighlightNumber,  // "integer"
+  [57] = TomlHighlightNumber,  // "float"
+};
+
+#endif  // TREE_SITTER_TOML_HIGHLIGHT_SYMBOLS_H_
@@ -0,0 +1,409 @@
+#include "./index.h"
+#include "./arena.h"
+#include "./keys.h"
+#include "./syntax.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct TomlIndex {
+  TomlArena *arena;
+  TomlIndexEntry *root;
+
+  TomlKeyAtoms atoms;
+
+  // every entry but the root and the elements of arrays of tables, by path hash
+  TomlKeySlots slots;
+
+  // only while building
+  const char *source;
+  TomlSyntaxSymbols symbols;
+  TomlSyntaxScratch scratch;
+  TomlError failure;  // what stopped it, unless memory ran out
+};
+
+/*
+ *  Entries
+ */
+
+static uint32_t toml_index__slot(const TomlIndex *self, const TomlIndexEntry *parent, TomlAtom atom, uint32_t hash) {
+  const TomlKeySlots *slots = &self->slots;
+  uint32_t mask = slots->count - 1;
+  uint32_t i = hash & mask;
+  for (const TomlIndexEntry *entry; (entry = slots->entries[i]); i = (i + 1) & mask) {
+    if (slots->hashes[i] == hash && entry->parent == parent && entry->atom == atom) break;
+  }
+  return i;
+}
+
+static TomlIndexEntry *toml_index__find(const TomlIndex *self, const TomlIndexEntry *parent, TomlAtom atom) {
+  if (!self->slots.count) return NULL;
+  return self->slots.entries[toml_index__slot(self, parent, atom, toml_keys_mix(parent->hash, atom))];
+}
+
+static TomlIndexEntry *toml_index__entry(TomlIndex *self, const TomlIndexEntry *parent, TomlAtom atom, uint32_t hash, TomlIndexKind kind, TSNode node) {
+  TomlIndexEntry *entry = toml_arena_alloc(self->arena, sizeof(TomlIndexEntry));
+  if (!entry) return NULL;
+  memset(entry, 0, sizeof(TomlIndexEntry));
+  entry->parent = parent;
+  entry->atom = atom;
+  entry->hash = hash;
+  entry->kind = kind;
+  entry->node = node;
+  return entry;
+}
+
+// Creates the entry named `atom` inside `parent`, which must not have one yet.
+static TomlIndexEntry *toml_index__insert(TomlIndex *self, TomlIndexEntry *parent, TomlAtom atom, TomlIndexKind kind, TSNode node) {
+  if (!toml_keys_reserve_slot(&self->slots)) return NULL;
+
+  uint32_t hash = toml_keys_mix(parent->hash, atom);
+  TomlIndexEntry *entry = toml_index__entry(self, parent, atom, hash, kind, node);
+  if (!entry) return NULL;
+  toml_keys_fill_slot(&self->slots, toml_index__slot(self, parent, atom, hash), entry, hash);
+  return entry;
+}
+
+static TomlIndexEntry *toml_index__append_element(TomlIndex *self, TomlIndexEntry *array, TSNode node) {
+  uint32_t count = array->elements.count;
+  if (count == array->elements.capacity) {
+    uint32_t capacity = count ? count * 2 : 4;
+    const TomlIndexEntry **items = toml_arena_realloc(
+      self->arena,
+      (void *)array->elements.items,
+      count * sizeof(TomlIndexEntry *),
+      capacity * sizeof(TomlIndexEntry *)
+    );
+    if (!items) return NULL;
+    array->elements.items = items;
+    array->elements.capacity = capacity;
+  }
+
+  // elements are reached through their array, never by path, so they stay out of the slots
+  uint32_t hash = toml_keys_mix(array->hash ^ TOML_KEYS_UNNAMED_SEED, count);
+  TomlIndexEntry *element = toml_index__entry(self, array, count, hash, TomlIndexKindTable, node);
+  if (!element) return NULL;
+  array->elements.items[array->elements.count++] = element;
+  return element;
+}
+
+/*
+ *  Building
+ *
+ *  Every function returns false when out of memory, or after filling in
+ *  `failure` for a key with an invalid escape. Definitions that conflict
+ *  with an earlier one are skipped.
+ */
+
+static void toml_index__fail(TomlError *error, TSNode node, const char *message) {
+  if (!error) return;
+  error->message = message;
+  error->start_byte = ts_node_start_byte(node);
+  error->end_byte = ts_node_end_byte(node);
+}
+
+static TomlAtom toml_index__key_segment(TomlIndex *self, TSNode node) {
+  TomlString key;
+  TomlSyntaxDecodeResult decoded = toml_syntax_key_segment(&self->symbols, self->source, node, &self->scratch, &key);
+  if (decoded == TomlSyntaxInvalidEscape) toml_index__fail(&self->failure, node, toml_syntax_message(decoded));
+  if (decoded != TomlSyntaxDecoded) return TOML_ATOM_NONE;
+
+  // keys decoded into the scratch buffer would be overwritten by the next key
+  return toml_keys_intern(&self->atoms, key, toml_syntax_in_scratch(&self->scratch, key) ? self->arena : NULL);
+}
+
+// Returns the table that `atom` names inside `table`, creating it when missing,
+// or sets `*conflict` when the name is taken by something else.
+static TomlIndexEntry *toml_index__descend(TomlIndex *self, TomlIndexEntry *table, TomlAtom atom, TSNode node, bool dotted, bool *conflict) {
+  TomlIndexEntry *child = toml_index__find(self, table, atom);
+  if (!child) return toml_index__insert(self, table, atom, TomlIndexKindTable, node);
+
+  if (child->kind == TomlIndexKindTable && ts_node_symbol(child->node) != self->symbols.inline_table) return child;
+  if (child->kind == TomlIndexKindTableArray && !dotted) {
+    return (TomlIndexEntry *)child->elements.items[child->elements.count - 1];
+  }
+  *conflict = true;
+  return NULL;
+}
+
+// Walks the segments of a `key` node, descending into all but the last one.
+static TomlIndexEntry *toml_index__key(TomlIndex *self, TomlIndexEntry *table, TSNode node, bool dotted, TomlAtom *name, TSNode *name_node, bool *conflict) {
+  uint32_t count = ts_node_named_child_count(node);
+  bool has_name = false;
+
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode segment = ts_node_named_child(node, i);
+    if (toml_syntax_is_comment(&self->symbols, segment)) continue;
+    if (has_name) {
+      table = toml_index__descend(self, table, *name, *name_node, dotted, conflict);
+      if (!table) return NULL;
+    }
+    *name = toml_index__key_segment(self, segment);
+    if (*name == TOML_ATOM_NONE) return NULL;
+    *name_node = segment;
+    has_name = true;
+  }
+
+  return table;
+}
+
+static bool toml_index__pairs(TomlIndex *self, TomlIndexEntry *table, TSNode node, uint32_t start);
+
+static bool toml_index__pair(TomlIndex *self, TomlIndexEntry *table, TSNode node) {
+  TSNode key = ts_node_named_child(node, 0);
+  TSNode value = ts_node_next_named_sibling(key);
+  while (!ts_node_is_null(value) && toml_syntax_is_comment(&self->symbols, value)) {
+    value = ts_node_next_named_sibling(value);
+  }
+
+  TomlAtom name;
+  TSNode name_node;
+  bool conflict = false;
+  table = toml_index__key(self, table, key, true, &name, &name_node, &conflict);
+  if (!table) return conflict;
+  if (toml_index__find(self, table, name)) return true;
+
+  bool is_table = ts_node_symbol(value) == self->symbols.inline_table;
+  TomlIndexEntry *entry = toml_index__insert(self, table, name, is_table ? TomlIndexKindTable : TomlIndexKindValue, value);
+  if (!entry) return false;
+  return !is_table || toml_index__pairs(self, entry, value, 0);
+}
+
+static bool toml_index__pairs(TomlIndex *self, TomlIndexEntry *table, TSNode node, uint32_t start) {
+  uint32_t count = ts_node_named_child_count(node);
+  for (uint32_t i = start; i < count; i++) {
+    TSNode child = ts_node_named_child(node, i);
+    if (ts_node_symbol(child) == self->symbols.pair && !toml_index__pair(self, table, child)) return false;
+  }
+  return true;
+}
+
+static bool toml_index__section(TomlIndex *self, TSNode node, bool is_array) {
+  TSNode key = ts_node_named_child(ts_node_named_child(node, 0), 0);
+  TomlAtom name;
+  TSNode name_node;
+  bool conflict = false;
+  TomlIndexEntry *parent = toml_index__key(self, self->root, key, false, &name, &name_node, &conflict);
+  if (!parent) return conflict;
+
+  TomlIndexEntry *existing = toml_index__find(self, parent, name);
+  TomlIndexEntry *table;
+
+  if (!is_array) {
+    if (!existing) {
+      table = toml_index__insert(self, parent, name, TomlIndexKindTable, node);
+      if (!table) return false;
+    } else {
+      // only a table that headers below it created implicitly can still be defined
+      TSSymbol symbol = ts_node_symbol(existing->node);
+      if (existing->kind != TomlIndexKindTable || symbol == self->symbols.table || symbol == self->symbols.inline_table) {
+        return true;
+      }
+      existing->node = node;
+      table = existing;
+    }
+  } else {
+    if (!existing) {
+      existing = toml_index__insert(self, parent, name, TomlIndexKindTableArray, node);
+      if (!existing) return false;
+    } else if (existing->kind != TomlIndexKindTableArray) {
+      return true;
+    }
+    table = toml_index__append_element(self, existing, node);
+    if (!table) return false;
+  }
+
+  return toml_index__pairs(self, table, node, 1);
+}
+
+static bool toml_index__document(TomlIndex *self, TSNode node) {
+  const TomlSyntaxSymbols *symbols = &self->symbols;
+  uint32_t count = ts_node_named_child_count(node);
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode child = ts_node_named_child(node, i);
+    TSSymbol symbol = ts_node_symbol(child);
+    bool ok = true;
+    if (symbol == symbols->pair) {
+      ok = toml_index__pair(self, self->root, child);
+    } else if (symbol == symbols->table) {
+      ok = toml_index__section(self, child, false);
+    } else if (symbol == symbols->table_array_element) {
+      ok = toml_index__section(self, child, true);
+    }
+    if (!ok) return false;
+  }
+  return true;
+}
+
+/*
+ *  Paths
+ */
+
+static bool toml_index__is_bare(char c) {
+  return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+}
+
+static uint32_t toml_index__skip_whitespace(const char *text, uint32_t length, uint32_t i) {
+  while (i < length && (text[i] == ' ' || text[i] == '\t')) i++;
+  return i;
+}
+
+// Reads the segment at `*offset` into `key`, decoding basic strings into the arena.
+static bool toml_index__path_segment(TomlIndex *self, const char *text, uint32_t length, uint32_t *offset, TomlString *key) {
+  uint32_t start = *offset;
+  uint32_t end = start;
+
+  if (start < length && (text[start] == '"' || text[start] == '\'')) {
+    char quote = text[start];
+    for (end = start + 1; end < length && text[end] != quote && text[end] != '\n'; end++) {
+      if (quote == '"' && text[end] == '\\') end++;
+    }
+    if (end >= length || text[end] != quote) return false;
+    end++;
+
+    if (!toml_decode_string_view(text + start, end - start, key)) {
+      char *output = toml_arena_alloc(self->arena, end - start);
+      if (!output || !toml_decode_string(text + start, end - start, output, &key->length)) return false;
+      key->data = output;
+    }
+  } else {
+    while (end < length && toml_index__is_bare(text[end])) end++;
+    if (end == start) return false;
+    key->data = text + start;
+    key->length = end - start;
+  }
+
+  *offset = end;
+  return true;
+}
+
+static bool toml_index__is_element(const TomlIndexEntry *entry) {
+  return entry->parent && entry->parent->kind == TomlIndexKindTableArray;
+}
+
+static const TomlIndexEntry *toml_index__lookup(const TomlIndex *self, const TomlIndexEntry *base, const TomlIndexPath *path, uint32_t hash) {
+  if (!path->count) return base;
+  if (!self->slots.count) return NULL;
+
+  const TomlKeySlots *slots = &self->slots;
+  uint32_t mask = slots->count - 1;
+  for (uint32_t i = hash & mask; slots->entries[i]; i = (i + 1) & mask) {
+    if (slots->hashes[i] != hash) continue;
+    const TomlIndexEntry *entry = slots->entries[i];
+
+    // the hash only narrows it down, the atoms up to `base` decide; the
+    // element numbers of arrays of tables are not atoms and never match
+    uint32_t j = path->count;
+    while (j > 0 && entry && entry->atom == path->atoms[j - 1] && !toml_index__is_element(entry)) {
+      entry = entry->parent;
+      j--;
+    }
+    if (j == 0 && entry == base) return slots->entries[i];
+  }
+  return NULL;
+}
+
+/*
+ *  Public
+ */
+
+TomlIndex *toml_index_new(const TSTree *tree, const char *source, TomlError *error) {
+  TSNode document = ts_tree_root_node(tree);
+  if (ts_node_has_error(document)) {
+    toml_index__fail(error, toml_syntax_first_error(document), "syntax error");
+    return NULL;
+  }
+
+  // entries are a fraction of the source, keys and values being a few bytes each
+  TomlArena *arena = toml_arena_new(ts_node_end_byte(document) + 1024);
+  TomlIndex *self = arena ? toml_arena_alloc(arena, sizeof(TomlIndex)) : NULL;
+  if (!self) {
+    toml_arena_delete(arena);
+    toml_index__fail(error, document, "out of memory");
+    return NULL;
+  }
+
+  memset(self, 0, sizeof(TomlIndex));
+  self->arena = arena;
+  self->source = source;
+  toml_syntax_init_symbols(&self->symbols, ts_tree_language(tree));
+  self->root = toml_index__entry(self, NULL, TOML_ATOM_NONE, TOML_KEYS_ROOT_HASH, TomlIndexKindTable, document);
+
+  bool ok = self->root && toml_index__document(self, document);
+  toml_syntax_free_scratch(&self->scratch);
+  self->source = NULL;
+  if (!ok) {
+    if (self->failure.message && error) {
+      *error = self->failure;
+    } else {
+      toml_index__fail(error, document, "out of memory");
+    }
+    toml_index_delete(self);
+    return NULL;
+  }
+  return self;
+}
+
+void toml_index_delete(TomlIndex *self) {
+  if (!self) return;
+  toml_keys_free_atoms(&self->atoms);
+  toml_keys_free_slots(&self->slots);
+  toml_syntax_free_scratch(&self->scratch);
+  toml_arena_delete(self->arena);
+}
+
+const TomlIndexEntry *toml_index_root(const TomlIndex *self) {
+  return self->root;
+}
+
+TomlAtom toml_index_atom(const TomlIndex *self, const char *key, uint32_t length) {
+  return toml_keys_find_atom(&self->atoms, (TomlString) {key, length});
+}
+
+TomlString toml_index_atom_name(const TomlIndex *self, TomlAtom atom) {
+  if (atom >= self->atoms.count) return (TomlString) {NULL, 0};
+  return self->atoms.names[atom];
+}
+
+bool toml_index_path(TomlIndex *self, const char *text, uint32_t length, TomlIndexPath *result) {
+  // a path has at most one more segment than it has dots
+  uint32_t capacity = 1;
+  for (uint32_t i = 0; i < length; i++) capacity += text[i] == '.';
+  TomlAtom *atoms = toml_arena_alloc(self->arena, capacity * sizeof(TomlAtom));
+  if (!atoms) return false;
+
+  uint32_t count = 0;
+  uint32_t hash = TOML_KEYS_ROOT_HASH;
+  uint32_t i = toml_index__skip_whitespace(text, length, 0);
+  for (;;) {
+    TomlString key;
+    if (!toml_index__path_segment(self, text, length, &i, &key)) return false;
+    atoms[count] = toml_index_atom(self, key.data, key.length);
+    hash = toml_keys_mix(hash, atoms[count]);
+    count++;
+
+    i = toml_index__skip_whitespace(text, length, i);
+    if (i == length) break;
+    if (text[i] != '.') return false;
+    i = toml_index__skip_whitespace(text, length, i + 1);
+  }
+
+  result->atoms = atoms;
+  result->count = count;
+  result->hash = hash;
+  return true;
+}
+
+const TomlIndexEntry *toml_index_get(const TomlIndex *self, const TomlIndexPath *path) {
+  return toml_index__lookup(self, self->root, path, path->hash);
+}
+
+const TomlIndexEntry *toml_index_get_in(const TomlIndex *self, const TomlIndexEntry *base, const TomlIndexPath *path) {
+  uint32_t hash = base->hash;
+  for (uint32_t i = 0; i < path->count; i++) hash = toml_keys_mix(hash, path->atoms[i]);
+  return toml_index__lookup(self, base, path, hash);
+}
+
+const TomlIndexEntry *toml_index_child(const TomlIndex *self, const TomlIndexEntry *parent, TomlAtom atom) {
+  if (atom == TOML_ATOM_NONE) return NULL;
+  return toml_index__find(self, parent, atom);
+}
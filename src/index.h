@@ -0,0 +1,112 @@
+#ifndef TREE_SITTER_TOML_INDEX_H_
+#define TREE_SITTER_TOML_INDEX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "./value.h"
+
+/*
+ *  Key path index.
+ *
+ *  A `TomlIndex` maps every fully qualified key path of a document, such as
+ *  `server.tls.cert` from a `[server]` header and a `tls.cert = ...` pair, to
+ *  the node that defines it. Each distinct key segment is interned once as a
+ *  `TomlAtom`, and every entry carries a hash of its whole path folded from
+ *  the atoms. A path compiled once with `toml_index_path` is then found with
+ *  one probe of a hash table and a check of its atoms, whatever its depth,
+ *  without touching the tree or comparing any strings.
+ *
+ *  The index points into the tree and the source, which must outlive it. It
+ *  expects a document without semantic errors (see `validate.h`); in one that
+ *  has them, the first definition of a key wins and what conflicts with it is
+ *  left out.
+ */
+
+typedef uint32_t TomlAtom;
+
+#define TOML_ATOM_NONE UINT32_MAX
+
+typedef enum {
+  TomlIndexKindTable,
+  TomlIndexKindTableArray,
+  TomlIndexKindValue,  // any other value, static arrays included
+} TomlIndexKind;
+
+typedef struct TomlIndexEntry TomlIndexEntry;
+
+struct TomlIndexEntry {
+  const TomlIndexEntry *parent;  // NULL for the root table
+  TomlAtom atom;                 // the key, or the element number in an array of tables
+  uint32_t hash;
+  TomlIndexKind kind;
+  // the value of a pair, the `table` or `table_array_element` of a header, the
+  // `inline_table` of an inline table, or the last key segment of a table that
+  // only dotted keys and headers below it create
+  TSNode node;
+  struct {
+    const TomlIndexEntry **items;
+    uint32_t count;
+    uint32_t capacity;
+  } elements;  // arrays of tables only
+};
+
+typedef struct {
+  const TomlAtom *atoms;
+  uint32_t count;
+  uint32_t hash;  // of the path below the root table
+} TomlIndexPath;
+
+typedef struct TomlIndex TomlIndex;
+
+/**
+ * Index the tree of `source`. Returns NULL and fills in `error` (when given)
+ * if the tree has syntax errors, a key has an invalid escape sequence, or
+ * memory runs out.
+ */
+TomlIndex *toml_index_new(const TSTree *tree, const char *source, TomlError *error);
+
+void toml_index_delete(TomlIndex *self);
+
+const TomlIndexEntry *toml_index_root(const TomlIndex *self);
+
+/**
+ * Find the atom of a decoded key segment, or `TOML_ATOM_NONE` if no key of the
+ * document has that name.
+ */
+TomlAtom toml_index_atom(const TomlIndex *self, const char *key, uint32_t length);
+
+TomlString toml_index_atom_name(const TomlIndex *self, TomlAtom atom);
+
+/**
+ * Compile a dotted path written like a TOML key (`a."b.c".'d'`) into `result`,
+ * whose atoms live as long as the index. Segments that no key of the document
+ * has become `TOML_ATOM_NONE`, so the path is simply never found. Returns false
+ * for text that is not a valid key or when out of memory. Compiling allocates
+ * from the index and must not race with other calls to it; lookups only read
+ * and can run on any number of threads.
+ */
+bool toml_index_path(TomlIndex *self, const char *text, uint32_t length, TomlIndexPath *result);
+
+/**
+ * Find the entry at `path` below the root table, or NULL.
+ */
+const TomlIndexEntry *toml_index_get(const TomlIndex *self, const TomlIndexPath *path);
+
+/**
+ * Find the entry at `path` below `base`, such as an element of an array of
+ * tables, or NULL.
+ */
+const TomlIndexEntry *toml_index_get_in(const TomlIndex *self, const TomlIndexEntry *base, const TomlIndexPath *path);
+
+/**
+ * Find the entry named `atom` directly inside the table `parent`, or NULL.
+ */
+const TomlIndexEntry *toml_index_child(const TomlIndex *self, const TomlIndexEntry *parent, TomlAtom atom);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_INDEX_H_
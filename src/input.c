@@ -0,0 +1,216 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "./input.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TOML_FILE_INPUT_CHUNK_SIZE (64 * 1024)
+
+typedef enum {
+  TomlFileInputMapped,
+  TomlFileInputBuffered,
+  TomlFileInputChunked,
+} TomlFileInputMode;
+
+struct TomlFileInput {
+  int fd;
+  TomlFileInputMode mode;
+  size_t length;
+
+  // mapped or buffered text, or the text of a chunked file once asked for
+  char *data;
+
+  // chunked files only, the bytes at `chunk_start` the parser last asked for
+  char *chunk;
+  size_t chunk_start;
+  size_t chunk_length;
+};
+
+static bool toml_file_input__read_all(TomlFileInput *self) {
+  size_t capacity = TOML_FILE_INPUT_CHUNK_SIZE;
+  char *data = malloc(capacity);
+  size_t length = 0;
+  if (!data) return false;
+
+  for (;;) {
+    if (length == capacity) {
+      if (capacity > UINT32_MAX) {
+        free(data);
+        errno = EFBIG;
+        return false;
+      }
+      char *grown = realloc(data, capacity * 2);
+      if (!grown) {
+        free(data);
+        errno = ENOMEM;
+        return false;
+      }
+      data = grown;
+      capacity *= 2;
+    }
+
+    ssize_t read_length = read(self->fd, data + length, capacity - length);
+    if (read_length < 0) {
+      if (errno == EINTR) continue;
+      free(data);
+      return false;
+    }
+    if (read_length == 0) break;
+    length += (size_t)read_length;
+  }
+
+  if (length > UINT32_MAX) {
+    free(data);
+    errno = EFBIG;
+    return false;
+  }
+  // give back what the last doubling did not use
+  char *trimmed = length ? realloc(data, length) : NULL;
+  if (trimmed) data = trimmed;
+  self->data = data;
+  self->length = length;
+  return true;
+}
+
+// Fills `output` with the `length` bytes at `offset`, short only at the end of the file.
+static ssize_t toml_file_input__pread(int fd, char *output, size_t length, size_t offset) {
+  size_t total = 0;
+  while (total < length) {
+    ssize_t read_length = pread(fd, output + total, length - total, (off_t)(offset + total));
+    if (read_length < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    if (read_length == 0) break;
+    total += (size_t)read_length;
+  }
+  return (ssize_t)total;
+}
+
+static const char *toml_file_input__read(void *payload, uint32_t byte_index, TSPoint position, uint32_t *bytes_read) {
+  TomlFileInput *self = payload;
+  (void)position;
+
+  if (byte_index >= self->length) {
+    *bytes_read = 0;
+    return "";
+  }
+
+  if (self->data) {
+    *bytes_read = (uint32_t)(self->length - byte_index);
+    return self->data + byte_index;
+  }
+
+  // the lexer mostly moves forward, but can step back a few bytes into the last chunk
+  if (byte_index < self->chunk_start || byte_index >= self->chunk_start + self->chunk_length) {
+    ssize_t read_length = toml_file_input__pread(self->fd, self->chunk, TOML_FILE_INPUT_CHUNK_SIZE, byte_index);
+    if (read_length <= 0) {
+      // the file shrank or failed under us, the parser sees it end here
+      *bytes_read = 0;
+      return "";
+    }
+    self->chunk_start = byte_index;
+    self->chunk_length = (size_t)read_length;
+  }
+
+  size_t offset = byte_index - self->chunk_start;
+  *bytes_read = (uint32_t)(self->chunk_length - offset);
+  return self->chunk + offset;
+}
+
+TomlFileInput *toml_file_input_new(int fd) {
+  struct stat info;
+  if (fstat(fd, &info) != 0) return NULL;
+
+  TomlFileInput *self = calloc(1, sizeof(TomlFileInput));
+  if (!self) return NULL;
+  self->fd = fd;
+
+  if (!S_ISREG(info.st_mode)) {
+    self->mode = TomlFileInputBuffered;
+    if (!toml_file_input__read_all(self)) {
+      int error = errno;
+      free(self);
+      errno = error;
+      return NULL;
+    }
+    return self;
+  }
+
+  if ((uintmax_t)info.st_size > UINT32_MAX) {
+    free(self);
+    errno = EFBIG;
+    return NULL;
+  }
+  self->length = (size_t)info.st_size;
+
+  // mapping nothing is an error, an empty file needs no memory anyway
+  if (self->length == 0) {
+    self->mode = TomlFileInputBuffered;
+    return self;
+  }
+
+#ifndef TOML_FILE_INPUT_NO_MMAP
+  void *data = mmap(NULL, self->length, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data != MAP_FAILED) {
+    posix_madvise(data, self->length, POSIX_MADV_SEQUENTIAL);
+    self->mode = TomlFileInputMapped;
+    self->data = data;
+    return self;
+  }
+#endif
+
+  self->mode = TomlFileInputChunked;
+  self->chunk = malloc(TOML_FILE_INPUT_CHUNK_SIZE);
+  if (!self->chunk) {
+    free(self);
+    errno = ENOMEM;
+    return NULL;
+  }
+  return self;
+}
+
+void toml_file_input_delete(TomlFileInput *self) {
+  if (!self) return;
+  if (self->mode == TomlFileInputMapped) {
+    munmap(self->data, self->length);
+  } else {
+    free(self->data);
+  }
+  free(self->chunk);
+  free(self);
+}
+
+TSInput toml_file_input(TomlFileInput *self) {
+  return (TSInput) {
+    .payload = self,
+    .read = toml_file_input__read,
+    .encoding = TSInputEncodingUTF8,
+  };
+}
+
+size_t toml_file_input_length(const TomlFileInput *self) {
+  return self->length;
+}
+
+const char *toml_file_input_source(TomlFileInput *self) {
+  if (self->data || self->length == 0) return self->data ? self->data : "";
+
+  char *data = malloc(self->length);
+  if (!data) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  ssize_t read_length = toml_file_input__pread(self->fd, data, self->length, 0);
+  if (read_length < 0 || (size_t)read_length != self->length) {
+    if (read_length >= 0) errno = EIO;
+    free(data);
+    return NULL;
+  }
+  self->data = data;
+  return data;
+}
@@ -0,0 +1,54 @@
+#ifndef TREE_SITTER_TOML_INPUT_H_
+#define TREE_SITTER_TOML_INPUT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <tree_sitter/api.h>
+
+/*
+ *  File input for `ts_parser_parse` (POSIX only).
+ *
+ *  Regular files are memory-mapped and handed to the parser without being
+ *  copied, with the kernel told to expect sequential reads. A regular file
+ *  that cannot be mapped is read in chunks with `pread` as the parser asks
+ *  for them. Pipes, sockets and terminals cannot be read at an offset, so
+ *  they are read into memory up front. Defining TOML_FILE_INPUT_NO_MMAP
+ *  reads every regular file in chunks, as test/input.c does to cover them.
+ *
+ *  Inputs are limited to 4 GiB, like the parser's byte offsets.
+ */
+
+typedef struct TomlFileInput TomlFileInput;
+
+/**
+ * Create an input for `fd`, which must stay open until the input is deleted.
+ * Returns NULL and sets `errno` on failure, `EFBIG` for files over 4 GiB.
+ */
+TomlFileInput *toml_file_input_new(int fd);
+
+void toml_file_input_delete(TomlFileInput *self);
+
+/**
+ * The `TSInput` to pass to `ts_parser_parse`. Pointers it returns stay valid
+ * until its next read.
+ */
+TSInput toml_file_input(TomlFileInput *self);
+
+size_t toml_file_input_length(const TomlFileInput *self);
+
+/**
+ * The whole text, for consumers that need random access to it such as the
+ * decoders. Free for mapped and buffered files; a chunked file is read into
+ * memory on the first call. Returns NULL and sets `errno` on failure.
+ */
+const char *toml_file_input_source(TomlFileInput *self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_INPUT_H_
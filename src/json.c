@@ -0,0 +1,633 @@
+#include "./json.h"
+#include "./arena.h"
+#include "./syntax.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define toml_json__write_fd _write
+#else
+#include <unistd.h>
+#define toml_json__write_fd write
+#endif
+
+#define TOML_JSON_DEFAULT_BUFFER_SIZE (64 * 1024)
+#define TOML_JSON_INITIAL_SLOT_COUNT 64
+
+typedef enum {
+  TomlJsonNodeTable,
+  TomlJsonNodeArray,  // array of tables, its children are the elements
+  TomlJsonNodeValue,  // pair with a dotted key
+} TomlJsonNodeKind;
+
+typedef struct TomlJsonNode TomlJsonNode;
+
+// A table of the skeleton, or an entry in one that cannot be written in place.
+struct TomlJsonNode {
+  TomlJsonNode *parent;
+  TomlJsonNode *first_child;
+  TomlJsonNode *last_child;
+  TomlJsonNode *next_sibling;
+  TomlJsonNode *next_part;  // a later section of the same table, when its header is repeated
+  TomlJsonNode *last_part;
+  TomlString key;
+  TSNode node;  // section whose plain pairs belong to a table, or the value of a dotted pair
+  uint32_t hash;
+  uint8_t kind;
+  bool has_node;
+};
+
+struct TomlJsonWriter {
+  int fd;
+  char *buffer;
+  size_t length;
+  size_t capacity;
+  size_t flushed;  // bytes handed to `fd` so far
+  bool write_failed;
+
+  // decoded strings that contain escapes
+  TomlSyntaxScratch scratch;
+
+  // open addressing index of the skeleton's keyed nodes, by parent and key
+  TomlJsonNode **slots;
+  uint32_t slot_count;
+  uint32_t slot_used;
+
+  TomlArena *arena;
+  const char *source;
+  TomlSyntaxSymbols symbols;
+  TomlError *error;
+};
+
+/*
+ *  Output
+ */
+
+static bool toml_json__flush(TomlJsonWriter *self) {
+  const char *data = self->buffer;
+  size_t length = self->length;
+  self->length = 0;
+  self->flushed += length;
+
+  while (length > 0 && !self->write_failed) {
+    unsigned chunk = length < (1u << 30) ? (unsigned)length : (1u << 30);
+    long written = (long)toml_json__write_fd(self->fd, data, chunk);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      self->write_failed = true;
+      break;
+    }
+    data += written;
+    length -= (size_t)written;
+  }
+  return !self->write_failed;
+}
+
+static inline void toml_json__write(TomlJsonWriter *self, const char *data, size_t length) {
+  while (self->length + length > self->capacity) {
+    size_t room = self->capacity - self->length;
+    memcpy(self->buffer + self->length, data, room);
+    self->length += room;
+    data += room;
+    length -= room;
+    toml_json__flush(self);
+  }
+  memcpy(self->buffer + self->length, data, length);
+  self->length += length;
+}
+
+static inline void toml_json__put(TomlJsonWriter *self, char c) {
+  if (self->length == self->capacity) toml_json__flush(self);
+  self->buffer[self->length++] = c;
+}
+
+// JSON escape for each byte: 0 for none, 'u' for `\u00XX`, else the letter after the backslash
+static const char toml_json__escapes[256] = {
+  'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+  'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+  ['"'] = '"', ['\\'] = '\\',
+};
+
+static void toml_json__string(TomlJsonWriter *self, const char *data, uint32_t length) {
+  static const char hex[] = "0123456789abcdef";
+  uint32_t start = 0;
+
+  toml_json__put(self, '"');
+  for (uint32_t i = 0; i < length; i++) {
+    char escape = toml_json__escapes[(unsigned char)data[i]];
+    if (!escape) continue;
+
+    toml_json__write(self, data + start, i - start);
+    if (escape == 'u') {
+      char sequence[6] = {'\\', 'u', '0', '0', hex[(unsigned char)data[i] >> 4], hex[data[i] & 0xf]};
+      toml_json__write(self, sequence, sizeof(sequence));
+    } else {
+      char sequence[2] = {'\\', escape};
+      toml_json__write(self, sequence, sizeof(sequence));
+    }
+    start = i + 1;
+  }
+  toml_json__write(self, data + start, length - start);
+  toml_json__put(self, '"');
+}
+
+/*
+ *  Scalars
+ */
+
+static bool toml_json__fail(TomlJsonWriter *self, TSNode node, const char *message) {
+  if (self->error) {
+    self->error->message = message;
+    self->error->start_byte = ts_node_start_byte(node);
+    self->error->end_byte = ts_node_end_byte(node);
+  }
+  return false;
+}
+
+static bool toml_json__decode_string(TomlJsonWriter *self, TSNode node, TomlString *result) {
+  TomlSyntaxDecodeResult decoded = toml_syntax_string(self->source, node, &self->scratch, result);
+  return decoded == TomlSyntaxDecoded || toml_json__fail(self, node, toml_syntax_message(decoded));
+}
+
+static bool toml_json__key_segment(TomlJsonWriter *self, TSNode node, TomlString *result) {
+  TomlSyntaxDecodeResult decoded = toml_syntax_key_segment(&self->symbols, self->source, node, &self->scratch, result);
+  return decoded == TomlSyntaxDecoded || toml_json__fail(self, node, toml_syntax_message(decoded));
+}
+
+static void toml_json__float(TomlJsonWriter *self, double value) {
+  if (!isfinite(value)) {
+    toml_json__write(self, "null", 4);
+    return;
+  }
+
+  // the shortest of the usual precisions that reads back as the same double
+  char text[32];
+  int length = 0;
+  for (int precision = 15; precision <= 17; precision++) {
+    length = snprintf(text, sizeof(text), "%.*g", precision, value);
+    double parsed;
+    if (toml_decode_float(text, (uint32_t)length, &parsed) && parsed == value) break;
+  }
+  toml_json__write(self, text, (size_t)length);
+}
+
+static bool toml_json__datetime(TomlJsonWriter *self, TSNode node) {
+  const char *text = self->source + ts_node_start_byte(node);
+  uint32_t length = ts_node_end_byte(node) - ts_node_start_byte(node);
+  if (!toml_syntax_reserve(&self->scratch, length)) return toml_json__fail(self, node, "out of memory");
+
+  // RFC 3339 allows a lowercase `t` and `z` and TOML a space, JSON consumers mostly expect `T` and `Z`
+  char *output = self->scratch.data;
+  for (uint32_t i = 0; i < length; i++) {
+    char c = text[i];
+    bool is_delimiter = (c == ' ' || c == 't') && i > 0 && text[i - 1] >= '0' && text[i - 1] <= '9';
+    output[i] = is_delimiter ? 'T' : c == 'z' ? 'Z' : c;
+  }
+
+  toml_json__put(self, '"');
+  toml_json__write(self, output, length);
+  toml_json__put(self, '"');
+  return true;
+}
+
+/*
+ *  Skeleton
+ */
+
+static uint32_t toml_json__hash(const TomlJsonNode *parent, TomlString key) {
+  uint32_t hash = 2166136261u ^ (uint32_t)((uintptr_t)parent >> 4);
+  for (uint32_t i = 0; i < key.length; i++) {
+    hash = (hash ^ (unsigned char)key.data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static bool toml_json__grow_slots(TomlJsonWriter *self) {
+  uint32_t slot_count = self->slot_count ? self->slot_count * 2 : TOML_JSON_INITIAL_SLOT_COUNT;
+  TomlJsonNode **slots = calloc(slot_count, sizeof(TomlJsonNode *));
+  if (!slots) return false;
+
+  for (uint32_t i = 0; i < self->slot_count; i++) {
+    TomlJsonNode *node = self->slots[i];
+    if (!node) continue;
+    uint32_t j = node->hash & (slot_count - 1);
+    while (slots[j]) j = (j + 1) & (slot_count - 1);
+    slots[j] = node;
+  }
+
+  free(self->slots);
+  self->slots = slots;
+  self->slot_count = slot_count;
+  return true;
+}
+
+static TomlJsonNode *toml_json__append(TomlJsonWriter *self, TomlJsonNode *parent, TomlString key, TomlJsonNodeKind kind) {
+  TomlJsonNode *node = toml_arena_alloc(self->arena, sizeof(TomlJsonNode));
+  if (!node) return NULL;
+  memset(node, 0, sizeof(TomlJsonNode));
+  node->parent = parent;
+  node->key = key;
+  node->kind = (uint8_t)kind;
+
+  if (parent) {
+    if (parent->last_child) {
+      parent->last_child->next_sibling = node;
+    } else {
+      parent->first_child = node;
+    }
+    parent->last_child = node;
+  }
+  return node;
+}
+
+// Keys decoded into the scratch buffer would be overwritten by the next string.
+static bool toml_json__own_key(TomlJsonWriter *self, TomlString *key) {
+  if (!toml_syntax_in_scratch(&self->scratch, *key)) return true;
+  char *copy = toml_arena_alloc(self->arena, key->length);
+  if (!copy) return false;
+  memcpy(copy, key->data, key->length);
+  key->data = copy;
+  return true;
+}
+
+// Returns the child of `parent` named `key`, appending one of `kind` if there is none.
+static TomlJsonNode *toml_json__child(TomlJsonWriter *self, TomlJsonNode *parent, TomlString key, TomlJsonNodeKind kind) {
+  if ((self->slot_used + 1) * 2 > self->slot_count && !toml_json__grow_slots(self)) return NULL;
+
+  uint32_t hash = toml_json__hash(parent, key);
+  uint32_t i = hash & (self->slot_count - 1);
+  for (TomlJsonNode *node; (node = self->slots[i]); i = (i + 1) & (self->slot_count - 1)) {
+    if (
+      node->hash == hash && node->parent == parent && node->key.length == key.length
+      && memcmp(node->key.data, key.data, key.length) == 0
+    ) {
+      return node;
+    }
+  }
+
+  if (!toml_json__own_key(self, &key)) return NULL;
+  TomlJsonNode *node = toml_json__append(self, parent, key, kind);
+  if (!node) return NULL;
+  node->hash = hash;
+  self->slots[i] = node;
+  self->slot_used++;
+  return node;
+}
+
+// Walks all but the last segment of a `key` node from `table`, returning the
+// table the last segment belongs to and the decoded segment in `name`.
+static TomlJsonNode *toml_json__key(TomlJsonWriter *self, TomlJsonNode *table, TSNode key, TomlString *name) {
+  uint32_t count = ts_node_named_child_count(key);
+  bool has_name = false;
+
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode segment = ts_node_named_child(key, i);
+    if (toml_syntax_is_comment(&self->symbols, segment)) continue;
+
+    if (has_name) {
+      table = toml_json__child(self, table, *name, TomlJsonNodeTable);
+      if (!table) {
+        toml_json__fail(self, segment, "out of memory");
+        return NULL;
+      }
+      // tables under an array of tables belong to its last element
+      if (table->kind == TomlJsonNodeArray && table->last_child) table = table->last_child;
+    }
+
+    if (!toml_json__key_segment(self, segment, name)) return NULL;
+    has_name = true;
+  }
+
+  return table;
+}
+
+static bool toml_json__is_dotted(TomlJsonWriter *self, TSNode key) {
+  uint32_t count = ts_node_named_child_count(key);
+  uint32_t segments = 0;
+  for (uint32_t i = 0; i < count && segments < 2; i++) {
+    if (!toml_syntax_is_comment(&self->symbols, ts_node_named_child(key, i))) segments++;
+  }
+  return segments > 1;
+}
+
+static TSNode toml_json__pair_value(TomlJsonWriter *self, TSNode key) {
+  TSNode value = ts_node_next_named_sibling(key);
+  while (!ts_node_is_null(value) && toml_syntax_is_comment(&self->symbols, value)) {
+    value = ts_node_next_named_sibling(value);
+  }
+  return value;
+}
+
+// Adds the pairs of `section` that have dotted keys to the skeleton under `table`.
+static bool toml_json__dotted_pairs(TomlJsonWriter *self, TomlJsonNode *table, TSNode section) {
+  uint32_t count = ts_node_named_child_count(section);
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode pair = ts_node_named_child(section, i);
+    if (ts_node_symbol(pair) != self->symbols.pair) continue;
+
+    TSNode key = ts_node_named_child(pair, 0);
+    if (!toml_json__is_dotted(self, key)) continue;
+
+    TomlString name;
+    TomlJsonNode *parent = toml_json__key(self, table, key, &name);
+    if (!parent) return false;
+
+    // values are never looked up, so they stay out of the index
+    TomlJsonNode *value = NULL;
+    if (toml_json__own_key(self, &name)) value = toml_json__append(self, parent, name, TomlJsonNodeValue);
+    if (!value) return toml_json__fail(self, pair, "out of memory");
+    value->node = toml_json__pair_value(self, key);
+    value->has_node = true;
+  }
+  return true;
+}
+
+static bool toml_json__section(TomlJsonWriter *self, TomlJsonNode *root, TSNode section, bool is_array) {
+  TSNode header = ts_node_named_child(section, 0);
+  TSNode key = ts_node_named_child(header, 0);
+  TomlString name;
+  TomlJsonNode *parent = toml_json__key(self, root, key, &name);
+  if (!parent) return false;
+
+  TomlJsonNode *table = toml_json__child(self, parent, name, is_array ? TomlJsonNodeArray : TomlJsonNodeTable);
+  if (table && is_array) {
+    table = toml_json__append(self, table, (TomlString) {NULL, 0}, TomlJsonNodeTable);
+  }
+  if (!table) return toml_json__fail(self, key, "out of memory");
+
+  if (table->has_node) {
+    // a repeated `[header]`, whose pairs are kept like those of the first one
+    TomlJsonNode *part = toml_json__append(self, NULL, (TomlString) {NULL, 0}, TomlJsonNodeTable);
+    if (!part) return toml_json__fail(self, key, "out of memory");
+    part->node = section;
+    part->has_node = true;
+    if (table->last_part) {
+      table->last_part->next_part = part;
+    } else {
+      table->next_part = part;
+    }
+    table->last_part = part;
+  } else {
+    table->node = section;
+    table->has_node = true;
+  }
+  return toml_json__dotted_pairs(self, table, section);
+}
+
+static bool toml_json__skeleton(TomlJsonWriter *self, TomlJsonNode *root, TSNode document) {
+  const TomlSyntaxSymbols *symbols = &self->symbols;
+  if (!toml_json__dotted_pairs(self, root, document)) return false;
+
+  uint32_t count = ts_node_named_child_count(document);
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode child = ts_node_named_child(document, i);
+    TSSymbol symbol = ts_node_symbol(child);
+    bool ok = true;
+    if (symbol == symbols->table) {
+      ok = toml_json__section(self, root, child, false);
+    } else if (symbol == symbols->table_array_element) {
+      ok = toml_json__section(self, root, child, true);
+    }
+    if (!ok) return false;
+  }
+  return true;
+}
+
+/*
+ *  Writing
+ */
+
+static bool toml_json__value(TomlJsonWriter *self, TSNode node);
+static bool toml_json__table(TomlJsonWriter *self, const TomlJsonNode *table);
+
+// Writes the pairs of `section` whose keys are not dotted, continuing an open object.
+static bool toml_json__plain_pairs(TomlJsonWriter *self, TSNode section, bool *first) {
+  uint32_t count = ts_node_named_child_count(section);
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode pair = ts_node_named_child(section, i);
+    if (ts_node_symbol(pair) != self->symbols.pair) continue;
+
+    TSNode key = ts_node_named_child(pair, 0);
+    if (toml_json__is_dotted(self, key)) continue;
+
+    TSNode segment = ts_node_named_child(key, 0);
+    while (toml_syntax_is_comment(&self->symbols, segment)) segment = ts_node_next_named_sibling(segment);
+    TomlString name;
+    if (!toml_json__key_segment(self, segment, &name)) return false;
+
+    if (!*first) toml_json__put(self, ',');
+    *first = false;
+    toml_json__string(self, name.data, name.length);
+    toml_json__put(self, ':');
+    if (!toml_json__value(self, toml_json__pair_value(self, key))) return false;
+  }
+  return true;
+}
+
+static bool toml_json__table(TomlJsonWriter *self, const TomlJsonNode *table) {
+  bool first = true;
+  toml_json__put(self, '{');
+  if (table->has_node && !toml_json__plain_pairs(self, table->node, &first)) return false;
+  for (const TomlJsonNode *part = table->next_part; part; part = part->next_part) {
+    if (!toml_json__plain_pairs(self, part->node, &first)) return false;
+  }
+
+  for (const TomlJsonNode *child = table->first_child; child; child = child->next_sibling) {
+    if (!first) toml_json__put(self, ',');
+    first = false;
+    toml_json__string(self, child->key.data, child->key.length);
+    toml_json__put(self, ':');
+
+    bool ok = true;
+    if (child->kind == TomlJsonNodeValue) {
+      ok = toml_json__value(self, child->node);
+    } else if (child->kind == TomlJsonNodeArray) {
+      toml_json__put(self, '[');
+      for (const TomlJsonNode *element = child->first_child; element && ok; element = element->next_sibling) {
+        if (element != child->first_child) toml_json__put(self, ',');
+        ok = toml_json__table(self, element);
+      }
+      toml_json__put(self, ']');
+    } else {
+      ok = toml_json__table(self, child);
+    }
+    if (!ok) return false;
+  }
+
+  toml_json__put(self, '}');
+  return !self->write_failed;
+}
+
+static bool toml_json__inline_table(TomlJsonWriter *self, TSNode node) {
+  uint32_t count = ts_node_named_child_count(node);
+  bool has_dotted = false;
+  for (uint32_t i = 0; i < count && !has_dotted; i++) {
+    TSNode pair = ts_node_named_child(node, i);
+    has_dotted = ts_node_symbol(pair) == self->symbols.pair && toml_json__is_dotted(self, ts_node_named_child(pair, 0));
+  }
+
+  if (!has_dotted) {
+    bool first = true;
+    toml_json__put(self, '{');
+    if (!toml_json__plain_pairs(self, node, &first)) return false;
+    toml_json__put(self, '}');
+    return true;
+  }
+
+  // dotted keys inside braces get a skeleton of their own
+  TomlJsonNode *table = toml_json__append(self, NULL, (TomlString) {NULL, 0}, TomlJsonNodeTable);
+  if (!table) return toml_json__fail(self, node, "out of memory");
+  table->node = node;
+  table->has_node = true;
+  return toml_json__dotted_pairs(self, table, node) && toml_json__table(self, table);
+}
+
+static bool toml_json__array(TomlJsonWriter *self, TSNode node) {
+  uint32_t count = ts_node_named_child_count(node);
+  bool first = true;
+
+  toml_json__put(self, '[');
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode item = ts_node_named_child(node, i);
+    if (toml_syntax_is_comment(&self->symbols, item)) continue;
+    if (!first) toml_json__put(self, ',');
+    first = false;
+    if (!toml_json__value(self, item)) return false;
+  }
+  toml_json__put(self, ']');
+  return true;
+}
+
+static bool toml_json__value(TomlJsonWriter *self, TSNode node) {
+  const TomlSyntaxSymbols *symbols = &self->symbols;
+  TSSymbol symbol = ts_node_symbol(node);
+  const char *text = self->source + ts_node_start_byte(node);
+  uint32_t length = ts_node_end_byte(node) - ts_node_start_byte(node);
+
+  if (symbol == symbols->string) {
+    TomlString string;
+    if (!toml_json__decode_string(self, node, &string)) return false;
+    toml_json__string(self, string.data, string.length);
+  } else if (symbol == symbols->integer) {
+    int64_t value;
+    if (!toml_decode_integer(text, length, &value)) return toml_json__fail(self, node, "integer out of range");
+    char digits[24];
+    int digits_length = snprintf(digits, sizeof(digits), "%lld", (long long)value);
+    toml_json__write(self, digits, (size_t)digits_length);
+  } else if (symbol == symbols->float_) {
+    double value;
+    if (!toml_decode_float(text, length, &value)) return toml_json__fail(self, node, "invalid float");
+    toml_json__float(self, value);
+  } else if (symbol == symbols->boolean) {
+    toml_json__write(self, text, length);
+  } else if (
+    symbol == symbols->offset_date_time || symbol == symbols->local_date_time
+    || symbol == symbols->local_date || symbol == symbols->local_time
+  ) {
+    return toml_json__datetime(self, node);
+  } else if (symbol == symbols->array) {
+    return toml_json__array(self, node);
+  } else if (symbol == symbols->inline_table) {
+    return toml_json__inline_table(self, node);
+  } else {
+    return toml_json__fail(self, node, "unexpected node");
+  }
+  return true;
+}
+
+/*
+ *  Public
+ */
+
+TomlJsonWriter *toml_json_writer_new(int fd, size_t buffer_size) {
+  TomlJsonWriter *self = calloc(1, sizeof(TomlJsonWriter));
+  if (!self) return NULL;
+
+  self->fd = fd;
+  self->capacity = buffer_size ? buffer_size : TOML_JSON_DEFAULT_BUFFER_SIZE;
+  self->buffer = malloc(self->capacity);
+  if (!self->buffer) {
+    free(self);
+    return NULL;
+  }
+  return self;
+}
+
+bool toml_json_writer_delete(TomlJsonWriter *self) {
+  if (!self) return true;
+  bool ok = toml_json__flush(self);
+  free(self->buffer);
+  toml_syntax_free_scratch(&self->scratch);
+  free(self->slots);
+  free(self);
+  return ok;
+}
+
+bool toml_json_writer_write(TomlJsonWriter *self, const TSTree *tree, const char *source, TomlError *error) {
+  return toml_json_writer_write_trees(self, &tree, 1, source, error);
+}
+
+bool toml_json_writer_write_trees(
+  TomlJsonWriter *self,
+  const TSTree *const *trees,
+  uint32_t count,
+  const char *source,
+  TomlError *error
+) {
+  TSNode document = ts_tree_root_node(trees[0]);
+  self->source = source;
+  self->error = error;
+  if (error) error->message = NULL;
+
+  // where this document starts, so that a failure can take back what it wrote
+  size_t start = self->length;
+  size_t flushed = self->flushed;
+
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode piece = ts_tree_root_node(trees[i]);
+    if (ts_node_has_error(piece)) {
+      return toml_json__fail(self, toml_syntax_first_error(piece), "syntax error");
+    }
+  }
+
+  // the skeleton only holds headers and dotted keys, far fewer than the document has bytes
+  self->arena = toml_arena_new(ts_node_end_byte(ts_tree_root_node(trees[count - 1])) / 16 + 1024);
+  if (!self->arena) return toml_json__fail(self, document, "out of memory");
+  if (self->slots) memset(self->slots, 0, self->slot_count * sizeof(TomlJsonNode *));
+  self->slot_used = 0;
+  toml_syntax_init_symbols(&self->symbols, ts_tree_language(trees[0]));
+
+  // only the first piece can hold pairs before the first header
+  TomlJsonNode *root = toml_json__append(self, NULL, (TomlString) {NULL, 0}, TomlJsonNodeTable);
+  bool ok = root != NULL;
+  if (ok) {
+    root->node = document;
+    root->has_node = true;
+    for (uint32_t i = 0; i < count && ok; i++) {
+      ok = toml_json__skeleton(self, root, ts_tree_root_node(trees[i]));
+    }
+    ok = ok && toml_json__table(self, root);
+  } else {
+    toml_json__fail(self, document, "out of memory");
+  }
+
+  if (ok) {
+    toml_json__put(self, '\n');
+    ok = toml_json__flush(self);
+  } else if (self->flushed == flushed) {
+    self->length = start;
+  } else {
+    // the start of the document is already out, so its line is ended instead
+    toml_json__put(self, '\n');
+    toml_json__flush(self);
+  }
+  if (self->write_failed) toml_json__fail(self, document, "write failed");
+
+  toml_arena_delete(self->arena);
+  self->arena = NULL;
+  return ok;
+}
@@ -0,0 +1,71 @@
+#ifndef TREE_SITTER_TOML_JSON_H_
+#define TREE_SITTER_TOML_JSON_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "./value.h"
+
+/*
+ *  TOML to JSON transcoding.
+ *
+ *  A `TomlJsonWriter` turns a tree produced by `tree_sitter_toml()` into JSON
+ *  written to a file descriptor. Values are decoded straight from the source
+ *  text into a fixed-size output buffer and never collected into a document:
+ *  the only thing built up front is a skeleton of the tables that headers and
+ *  dotted keys open, so that a table whose parts are spread over the file is
+ *  still written as one JSON object.
+ *
+ *  Tables come out in the order they first appear. Inside a table, pairs with
+ *  plain keys come first, in source order, followed by the tables, arrays of
+ *  tables and dotted pairs in the order they first appear. The skeleton is
+ *  not a validator: keys that TOML forbids redefining are written twice, and
+ *  the pairs of a `[table]` whose header is repeated are all written.
+ *
+ *  Values map to JSON as follows: integers and floats to numbers, with `inf`
+ *  and `nan` as `null`; booleans to booleans; strings to strings; date-times,
+ *  dates and times to strings as written, with `T` and `Z` upper-cased.
+ */
+
+typedef struct TomlJsonWriter TomlJsonWriter;
+
+/**
+ * Create a writer for `fd` whose output buffer holds `buffer_size` bytes, or
+ * a default size when it is 0. The writer can be reused for many documents.
+ */
+TomlJsonWriter *toml_json_writer_new(int fd, size_t buffer_size);
+
+/**
+ * Flush what is still buffered and free the writer. Does not close `fd`.
+ */
+bool toml_json_writer_delete(TomlJsonWriter *self);
+
+/**
+ * Write the tree of `source` as one JSON value followed by a newline. Returns
+ * false and fills in `error` (when given) if the tree has syntax errors, a
+ * string has an invalid escape, or writing fails. Nothing of a document that
+ * fails is written, unless it had outgrown the buffer, in which case the part
+ * already written is ended with a newline so that the next document starts on
+ * a line of its own.
+ */
+bool toml_json_writer_write(TomlJsonWriter *self, const TSTree *tree, const char *source, TomlError *error);
+
+/**
+ * Write the trees of a document parsed in pieces, such as the ones from
+ * `toml_parallel_parse`, as one JSON value. The trees must use byte offsets
+ * into the same `source` and come in source order.
+ */
+bool toml_json_writer_write_trees(
+  TomlJsonWriter *self,
+  const TSTree *const *trees,
+  uint32_t count,
+  const char *source,
+  TomlError *error
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_JSON_H_
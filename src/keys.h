@@ -0,0 +1,283 @@
+#ifndef TREE_SITTER_TOML_KEYS_H_
+#define TREE_SITTER_TOML_KEYS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "./arena.h"
+#include "./index.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *  Key paths, shared by the modules that follow them through a document:
+ *  value.c, validate.c, index.c and model.c. Internal, not part of any
+ *  public header.
+ *
+ *  Key segments are interned as atoms, and the entries of key paths are
+ *  found through one hash table by the hash of their parent mixed with
+ *  their atom. The rules for defining a key more than once are a state that
+ *  every key path goes through as the places that mention it are met in
+ *  document order, each place either moving it on or being an error.
+ */
+
+#define TOML_KEYS_INITIAL_SLOT_COUNT 64
+
+// the hash of the root table, and the seed of the tables that no path reaches
+#define TOML_KEYS_ROOT_HASH 0x9e3779b9u
+#define TOML_KEYS_UNNAMED_SEED 0x5bd1e995u
+
+/*
+ *  Atoms
+ */
+
+// Interned key segments, found by name through `slots`, which holds atom + 1.
+typedef struct {
+  TomlString *names;
+  uint32_t *hashes;
+  uint32_t count;
+  uint32_t capacity;
+  uint32_t *slots;
+  uint32_t slot_count;
+} TomlKeyAtoms;
+
+static inline uint32_t toml_keys_hash(TomlString key) {
+  uint32_t hash = 2166136261u;
+  for (uint32_t i = 0; i < key.length; i++) {
+    hash = (hash ^ (unsigned char)key.data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static inline uint32_t toml_keys__atom_slot(const TomlKeyAtoms *self, TomlString key, uint32_t hash) {
+  uint32_t mask = self->slot_count - 1;
+  uint32_t i = hash & mask;
+  for (uint32_t slot; (slot = self->slots[i]); i = (i + 1) & mask) {
+    const TomlString *name = &self->names[slot - 1];
+    if (
+      self->hashes[slot - 1] == hash && name->length == key.length
+      && memcmp(name->data, key.data, key.length) == 0
+    ) {
+      break;
+    }
+  }
+  return i;
+}
+
+static inline bool toml_keys__grow_atoms(TomlKeyAtoms *self) {
+  uint32_t capacity = self->capacity ? self->capacity * 2 : TOML_KEYS_INITIAL_SLOT_COUNT / 2;
+  TomlString *names = realloc(self->names, capacity * sizeof(TomlString));
+  if (!names) return false;
+  self->names = names;
+  uint32_t *hashes = realloc(self->hashes, capacity * sizeof(uint32_t));
+  if (!hashes) return false;
+  self->hashes = hashes;
+  self->capacity = capacity;
+
+  uint32_t slot_count = capacity * 2;
+  uint32_t *slots = calloc(slot_count, sizeof(uint32_t));
+  if (!slots) return false;
+  for (uint32_t atom = 0; atom < self->count; atom++) {
+    uint32_t i = self->hashes[atom] & (slot_count - 1);
+    while (slots[i]) i = (i + 1) & (slot_count - 1);
+    slots[i] = atom + 1;
+  }
+  free(self->slots);
+  self->slots = slots;
+  self->slot_count = slot_count;
+  return true;
+}
+
+// Returns the atom of `key`, or `TOML_ATOM_NONE` if it was never interned.
+static inline TomlAtom toml_keys_find_atom(const TomlKeyAtoms *self, TomlString key) {
+  if (!self->slot_count) return TOML_ATOM_NONE;
+  uint32_t slot = self->slots[toml_keys__atom_slot(self, key, toml_keys_hash(key))];
+  return slot ? slot - 1 : TOML_ATOM_NONE;
+}
+
+// Returns the atom of `key`, adding it when it is new, or `TOML_ATOM_NONE`
+// when out of memory. A new key is copied into `arena` when one is given,
+// for text that does not outlive the atoms.
+static inline TomlAtom toml_keys_intern(TomlKeyAtoms *self, TomlString key, TomlArena *arena) {
+  uint32_t hash = toml_keys_hash(key);
+  uint32_t i = 0;
+  if (self->slot_count) {
+    i = toml_keys__atom_slot(self, key, hash);
+    if (self->slots[i]) return self->slots[i] - 1;
+  }
+
+  if (self->count == self->capacity) {
+    if (!toml_keys__grow_atoms(self)) return TOML_ATOM_NONE;
+    i = toml_keys__atom_slot(self, key, hash);
+  }
+
+  if (arena && key.length) {
+    char *copy = toml_arena_alloc(arena, key.length);
+    if (!copy) return TOML_ATOM_NONE;
+    memcpy(copy, key.data, key.length);
+    key.data = copy;
+  }
+
+  TomlAtom atom = self->count++;
+  self->names[atom] = key;
+  self->hashes[atom] = hash;
+  self->slots[i] = atom + 1;
+  return atom;
+}
+
+static inline void toml_keys_free_atoms(TomlKeyAtoms *self) {
+  free(self->names);
+  free(self->hashes);
+  free(self->slots);
+}
+
+/*
+ *  Entries
+ */
+
+// Returns the hash of the path made of the path hashed as `hash` and one more segment.
+static inline uint32_t toml_keys_mix(uint32_t hash, uint32_t value) {
+  hash = (hash ^ value) * 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  return hash ^ (hash >> 16);
+}
+
+// The entries of key paths by the hash of their path, with open addressing.
+// Each module probes from `hash & (count - 1)` and tells its own entries
+// apart; the hashes are kept next to them so that growing and removing need
+// not know what an entry is.
+typedef struct {
+  void **entries;
+  uint32_t *hashes;
+  uint32_t count;  // a power of two, or 0
+  uint32_t used;
+} TomlKeySlots;
+
+// Makes room for one more entry, keeping the table at most half full.
+static inline bool toml_keys_reserve_slot(TomlKeySlots *self) {
+  if ((self->used + 1) * 2 <= self->count) return true;
+
+  uint32_t count = self->count ? self->count * 2 : TOML_KEYS_INITIAL_SLOT_COUNT;
+  void **entries = calloc(count, sizeof(void *));
+  uint32_t *hashes = malloc(count * sizeof(uint32_t));
+  if (!entries || !hashes) {
+    free(entries);
+    free(hashes);
+    return false;
+  }
+
+  for (uint32_t i = 0; i < self->count; i++) {
+    if (!self->entries[i]) continue;
+    uint32_t j = self->hashes[i] & (count - 1);
+    while (entries[j]) j = (j + 1) & (count - 1);
+    entries[j] = self->entries[i];
+    hashes[j] = self->hashes[i];
+  }
+
+  free(self->entries);
+  free(self->hashes);
+  self->entries = entries;
+  self->hashes = hashes;
+  self->count = count;
+  return true;
+}
+
+// Stores `entry` in the empty slot that a probe for `hash` ended on.
+static inline void toml_keys_fill_slot(TomlKeySlots *self, uint32_t slot, void *entry, uint32_t hash) {
+  self->entries[slot] = entry;
+  self->hashes[slot] = hash;
+  self->used++;
+}
+
+// Removes an entry, moving back the entries after it that would otherwise
+// no longer be found.
+static inline void toml_keys_remove_slot(TomlKeySlots *self, const void *entry, uint32_t hash) {
+  uint32_t mask = self->count - 1;
+  uint32_t i = hash & mask;
+  while (self->entries[i] != entry) i = (i + 1) & mask;
+  self->entries[i] = NULL;
+  self->used--;
+
+  for (uint32_t j = (i + 1) & mask; self->entries[j]; j = (j + 1) & mask) {
+    uint32_t home = self->hashes[j] & mask;
+    bool stays = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+    if (stays) continue;
+    self->entries[i] = self->entries[j];
+    self->hashes[i] = self->hashes[j];
+    self->entries[j] = NULL;
+    i = j;
+  }
+}
+
+static inline void toml_keys_free_slots(TomlKeySlots *self) {
+  free(self->entries);
+  free(self->hashes);
+}
+
+/*
+ *  Rules
+ */
+
+// A place in the document that mentions a key path.
+typedef enum {
+  TomlKeyDefinitionValue,     // the last key of a pair
+  TomlKeyDefinitionInline,    // the last key of a pair whose value is an inline table
+  TomlKeyDefinitionHeader,    // the last key of a `[header]`
+  TomlKeyDefinitionElement,   // the last key of a `[[header]]`
+  TomlKeyDefinitionDotted,    // any other key of a pair
+  TomlKeyDefinitionImplicit,  // any other key of a header
+} TomlKeyDefinition;
+
+// What the places met so far made of a key path.
+typedef enum {
+  TomlKeyStateNone,
+  TomlKeyStateValue,     // anything but a table, static arrays included
+  TomlKeyStateInline,    // an inline table, sealed
+  TomlKeyStateHeader,    // a table defined by a `[header]`
+  TomlKeyStateDotted,    // a table created by a dotted key
+  TomlKeyStateImplicit,  // a table that headers below it created
+  TomlKeyStateArray,     // an array of tables
+} TomlKeyState;
+
+// Returns the error of `definition` given the state of its key path, or NULL
+// after moving the state on.
+static inline const char *toml_keys_define(TomlKeyState *state, TomlKeyDefinition definition) {
+  TomlKeyState current = *state;
+  switch (definition) {
+    case TomlKeyDefinitionValue:
+    case TomlKeyDefinitionInline:
+      if (current != TomlKeyStateNone) return "duplicate key";
+      *state = definition == TomlKeyDefinitionValue ? TomlKeyStateValue : TomlKeyStateInline;
+      return NULL;
+    case TomlKeyDefinitionHeader:
+      if (current != TomlKeyStateNone && current != TomlKeyStateImplicit) return "table redefined";
+      *state = TomlKeyStateHeader;
+      return NULL;
+    case TomlKeyDefinitionElement:
+      if (current != TomlKeyStateNone && current != TomlKeyStateArray) {
+        return "cannot append to a value that is not an array of tables";
+      }
+      *state = TomlKeyStateArray;
+      return NULL;
+    case TomlKeyDefinitionDotted:
+      if (current == TomlKeyStateInline) return "cannot extend an inline table";
+      if (current == TomlKeyStateHeader) return "cannot extend a table defined by a header with dotted keys";
+      if (current == TomlKeyStateValue || current == TomlKeyStateArray) return "key already has a value";
+      if (current == TomlKeyStateNone) *state = TomlKeyStateDotted;
+      return NULL;
+    case TomlKeyDefinitionImplicit:
+      if (current == TomlKeyStateInline) return "cannot extend an inline table";
+      if (current == TomlKeyStateValue) return "key already has a value";
+      if (current == TomlKeyStateNone) *state = TomlKeyStateImplicit;
+      return NULL;
+  }
+  return NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_KEYS_H_
@@ -0,0 +1,123 @@
+#include "./lazy.h"
+#include "./syntax.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TOML_LAZY_INITIAL_SLOT_COUNT 64
+
+typedef struct {
+  const void *id;
+  const TomlValue *value;
+} TomlLazySlot;
+
+struct TomlLazyDocument {
+  TomlIndex *index;
+  TomlValueDecoder *decoder;
+  TSSymbol inline_table;
+
+  // decoded values by node id
+  TomlLazySlot *slots;
+  uint32_t slot_count;
+  uint32_t slot_used;
+};
+
+static uint32_t toml_lazy__hash(const void *id) {
+  uint64_t hash = (uint64_t)(uintptr_t)id * 0x9e3779b97f4a7c15ull;
+  return (uint32_t)(hash >> 32);
+}
+
+static TomlLazySlot *toml_lazy__slot(const TomlLazyDocument *self, const void *id) {
+  uint32_t mask = self->slot_count - 1;
+  uint32_t i = toml_lazy__hash(id) & mask;
+  while (self->slots[i].id && self->slots[i].id != id) i = (i + 1) & mask;
+  return &self->slots[i];
+}
+
+static bool toml_lazy__grow_slots(TomlLazyDocument *self) {
+  uint32_t slot_count = self->slot_count ? self->slot_count * 2 : TOML_LAZY_INITIAL_SLOT_COUNT;
+  TomlLazySlot *slots = calloc(slot_count, sizeof(TomlLazySlot));
+  if (!slots) return false;
+
+  for (uint32_t i = 0; i < self->slot_count; i++) {
+    if (!self->slots[i].id) continue;
+    uint32_t j = toml_lazy__hash(self->slots[i].id) & (slot_count - 1);
+    while (slots[j].id) j = (j + 1) & (slot_count - 1);
+    slots[j] = self->slots[i];
+  }
+
+  free(self->slots);
+  self->slots = slots;
+  self->slot_count = slot_count;
+  return true;
+}
+
+static bool toml_lazy__fail(TomlError *error, TSNode node, const char *message) {
+  if (error) {
+    error->message = message;
+    error->start_byte = ts_node_start_byte(node);
+    error->end_byte = ts_node_end_byte(node);
+  }
+  return false;
+}
+
+TomlLazyDocument *toml_lazy_document_new(const TSTree *tree, const char *source, TomlError *error) {
+  TomlLazyDocument *self = calloc(1, sizeof(TomlLazyDocument));
+  if (!self) {
+    toml_lazy__fail(error, ts_tree_root_node(tree), "out of memory");
+    return NULL;
+  }
+
+  const TSLanguage *language = ts_tree_language(tree);
+  self->index = toml_index_new(tree, source, error);
+  if (!self->index) {
+    free(self);
+    return NULL;
+  }
+  self->decoder = toml_value_decoder_new(language, source);
+  if (!self->decoder) {
+    toml_lazy__fail(error, ts_tree_root_node(tree), "out of memory");
+    toml_lazy_document_delete(self);
+    return NULL;
+  }
+  self->inline_table = toml_syntax_symbol(language, "inline_table");
+  return self;
+}
+
+void toml_lazy_document_delete(TomlLazyDocument *self) {
+  if (!self) return;
+  toml_index_delete(self->index);
+  toml_value_decoder_delete(self->decoder);
+  free(self->slots);
+  free(self);
+}
+
+TomlIndex *toml_lazy_document_index(TomlLazyDocument *self) {
+  return self->index;
+}
+
+const TomlValue *toml_lazy_document_value(TomlLazyDocument *self, const TomlIndexEntry *entry, TomlError *error) {
+  bool has_value = entry->kind == TomlIndexKindValue
+    || (entry->kind == TomlIndexKindTable && ts_node_symbol(entry->node) == self->inline_table);
+  if (!has_value) return NULL;
+
+  if (self->slot_count) {
+    TomlLazySlot *slot = toml_lazy__slot(self, entry->node.id);
+    if (slot->id) return slot->value;
+  }
+
+  const TomlValue *value = toml_value_decoder_decode(self->decoder, entry->node, error);
+  if (!value) return NULL;
+
+  // a value that cannot be cached is still correct, only decoded again next time
+  if ((self->slot_used + 1) * 2 > self->slot_count && !toml_lazy__grow_slots(self)) return value;
+  TomlLazySlot *slot = toml_lazy__slot(self, entry->node.id);
+  slot->id = entry->node.id;
+  slot->value = value;
+  self->slot_used++;
+  return value;
+}
+
+const TomlValue *toml_lazy_document_get(TomlLazyDocument *self, const TomlIndexPath *path, TomlError *error) {
+  const TomlIndexEntry *entry = toml_index_get(self->index, path);
+  return entry ? toml_lazy_document_value(self, entry, error) : NULL;
+}
@@ -0,0 +1,57 @@
+#ifndef TREE_SITTER_TOML_LAZY_H_
+#define TREE_SITTER_TOML_LAZY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "./index.h"
+
+/*
+ *  Lazily decoded documents.
+ *
+ *  A `TomlLazyDocument` indexes every key of a tree up front (see `index.h`)
+ *  but leaves the values alone until they are asked for. The first access to
+ *  a value decodes its node and caches the result by node id, so the next
+ *  access returns the same `TomlValue` without decoding again. Opening a big
+ *  configuration that is only partly read costs about as much as the parse.
+ *
+ *  The tree and the source must outlive the document. A lazy document is not
+ *  validated; run `toml_validator_check` on the tree when that matters.
+ */
+
+typedef struct TomlLazyDocument TomlLazyDocument;
+
+/**
+ * Index the tree of `source`. Returns NULL and fills in `error` (when given)
+ * if the tree has syntax errors, a key has an invalid escape sequence, or
+ * memory runs out.
+ */
+TomlLazyDocument *toml_lazy_document_new(const TSTree *tree, const char *source, TomlError *error);
+
+void toml_lazy_document_delete(TomlLazyDocument *self);
+
+/**
+ * The key index, for compiling paths and walking arrays of tables.
+ */
+TomlIndex *toml_lazy_document_index(TomlLazyDocument *self);
+
+/**
+ * Decode the value of an entry, or return the one decoded before. Only pairs
+ * have a value; tables opened by headers or dotted keys and arrays of tables
+ * return NULL without an error and are walked through the index instead.
+ * Returns NULL and fills in `error` (when given) if decoding fails.
+ */
+const TomlValue *toml_lazy_document_value(TomlLazyDocument *self, const TomlIndexEntry *entry, TomlError *error);
+
+/**
+ * Look up `path` below the root table and return its value, or NULL if there
+ * is none.
+ */
+const TomlValue *toml_lazy_document_get(TomlLazyDocument *self, const TomlIndexPath *path, TomlError *error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_LAZY_H_
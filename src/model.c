@@ -0,0 +1,1089 @@
+#include "./model.h"
+#include "./arena.h"
+#include "./index.h"
+#include "./keys.h"
+#include "./syntax.h"
+#include <stdlib.h>
+#include <string.h>
+
+// decoded values of rebuilt sections are only released once there are this many, and more than live ones
+#define TOML_MODEL_STALE_VALUE_LIMIT 4096
+
+#define TOML_MODEL_DEFINITION_KIND_COUNT (TomlKeyDefinitionImplicit + 1)
+
+typedef enum {
+  TomlModelSectionPair,
+  TomlModelSectionTable,
+  TomlModelSectionTableArray,
+  TomlModelSectionError,
+} TomlModelSectionKind;
+
+typedef struct TomlModelEntry TomlModelEntry;
+typedef struct TomlModelSection TomlModelSection;
+typedef struct TomlModelDefinition TomlModelDefinition;
+
+typedef struct {
+  TomlModelSection **contents;
+  uint32_t size;
+  uint32_t capacity;
+} TomlModelSectionArray;
+
+typedef struct {
+  TomlModelEntry **contents;
+  uint32_t size;
+  uint32_t capacity;
+} TomlModelEntryArray;
+
+// A key path, like a `TomlIndexEntry`, that lives as long as something defines it.
+struct TomlModelEntry {
+  TomlModelEntry *parent;  // NULL for the root and for tables that no path reaches
+  TomlAtom atom;
+  uint32_t hash;
+  uint32_t child_count;
+  TomlModelDefinition *definitions;  // in no particular order
+  uint32_t kind_counts[TOML_MODEL_DEFINITION_KIND_COUNT];  // how many of `definitions` are of each kind
+  TomlModelSectionArray elements;    // `[[header]]` sections appending to it, in document order
+  uint32_t touched;                  // position + 1 in the model's `touched`, or 0
+  uint32_t conflicted;               // position + 1 in the model's `conflicted`, or 0
+};
+
+// One place in a section that defines an entry or goes through it.
+struct TomlModelDefinition {
+  TomlModelEntry *entry;
+  TomlModelSection *section;
+  TomlModelDefinition *previous;
+  TomlModelDefinition *next;
+  TomlKeyDefinition kind;
+  // byte ranges relative to the section, so that edits before it do not change them
+  uint32_t start;
+  uint32_t end;
+  uint32_t value_start;
+  uint32_t value_end;
+  const TomlValue *value;  // pairs only, decoded on first read
+};
+
+// A top-level `pair`, `table` or `table_array_element`.
+struct TomlModelSection {
+  uint32_t start_byte;
+  uint32_t end_byte;
+  TomlModelSectionKind kind;
+  bool dirty;    // overlapped by an edit since the last update
+  bool pending;  // not yet built from the current tree
+  TomlModelEntry *array;    // the array of tables that a `[[header]]` appends to
+  TomlModelEntry *element;  // the table of that element, kept across rebuilds
+  TomlModelEntryArray tables;  // inline tables inside arrays, which no path reaches
+  TomlModelDefinition *definitions;
+  uint32_t definition_count;
+  TomlError *errors;  // relative to the section
+  uint32_t error_count;
+  uint32_t listed;  // position + 1 in the model's `erroneous`, or 0
+};
+
+struct TomlModel {
+  TomlModelEntry *root;
+  TomlModelSectionArray sections;  // in document order
+
+  // interned keys, copied into `atom_arena` since the source changes with every edit
+  TomlArena *atom_arena;
+  TomlKeyAtoms atoms;
+
+  // entries that a path reaches, by parent and atom
+  TomlKeySlots slots;
+  uint32_t table_serial;
+
+  TomlModelEntryArray touched;     // entries whose definitions changed during an update
+  TomlModelEntryArray conflicted;  // entries with errors
+  TomlModelSectionArray erroneous; // sections with errors of their own
+
+  // only during an update
+  TomlModelSectionArray removed;
+  TomlModelEntryArray changed_arrays;
+  TomlModelDefinition *building;
+  uint32_t building_size;
+  uint32_t building_capacity;
+  TomlError *building_errors;
+  uint32_t building_error_size;
+  uint32_t building_error_capacity;
+  TomlModelDefinition **sorted;
+  uint32_t sorted_capacity;
+  TomlSyntaxScratch scratch;
+  TSTreeCursor cursor;
+
+  const TSTree *tree;
+  const char *source;
+  TomlSyntaxSymbols symbols;
+  TomlValueDecoder *decoder;
+  uint32_t decoded_count;
+  uint32_t stale_count;
+  bool out_of_memory;
+};
+
+/*
+ *  Arrays
+ */
+
+static bool toml_model__reserve(void **contents, uint32_t *capacity, uint32_t size, size_t element_size) {
+  if (size <= *capacity) return true;
+  uint32_t new_capacity = *capacity ? *capacity * 2 : 8;
+  while (new_capacity < size) new_capacity *= 2;
+  void *new_contents = realloc(*contents, new_capacity * element_size);
+  if (!new_contents) return false;
+  *contents = new_contents;
+  *capacity = new_capacity;
+  return true;
+}
+
+static bool toml_model__push_entry(TomlModelEntryArray *self, TomlModelEntry *entry) {
+  if (!toml_model__reserve((void **)&self->contents, &self->capacity, self->size + 1, sizeof(TomlModelEntry *))) {
+    return false;
+  }
+  self->contents[self->size++] = entry;
+  return true;
+}
+
+static bool toml_model__insert_sections(TomlModelSectionArray *self, uint32_t index, uint32_t count) {
+  if (!toml_model__reserve((void **)&self->contents, &self->capacity, self->size + count, sizeof(TomlModelSection *))) {
+    return false;
+  }
+  memmove(
+    &self->contents[index + count],
+    &self->contents[index],
+    (self->size - index) * sizeof(TomlModelSection *)
+  );
+  self->size += count;
+  return true;
+}
+
+static void toml_model__erase_sections(TomlModelSectionArray *self, uint32_t index, uint32_t count) {
+  if (!count) return;
+  memmove(
+    &self->contents[index],
+    &self->contents[index + count],
+    (self->size - index - count) * sizeof(TomlModelSection *)
+  );
+  self->size -= count;
+}
+
+// Adds `entry` to a set whose members remember their position + 1 in `*position`.
+static bool toml_model__list(TomlModelEntryArray *self, TomlModelEntry *entry, uint32_t *position) {
+  if (*position) return true;
+  if (!toml_model__push_entry(self, entry)) return false;
+  *position = self->size;
+  return true;
+}
+
+static void toml_model__unlist_touched(TomlModel *self, TomlModelEntry *entry) {
+  if (!entry->touched) return;
+  TomlModelEntry *last = self->touched.contents[--self->touched.size];
+  self->touched.contents[entry->touched - 1] = last;
+  last->touched = entry->touched;
+  entry->touched = 0;
+}
+
+static void toml_model__unlist_conflicted(TomlModel *self, TomlModelEntry *entry) {
+  if (!entry->conflicted) return;
+  TomlModelEntry *last = self->conflicted.contents[--self->conflicted.size];
+  self->conflicted.contents[entry->conflicted - 1] = last;
+  last->conflicted = entry->conflicted;
+  entry->conflicted = 0;
+}
+
+/*
+ *  Entries
+ */
+
+static uint32_t toml_model__slot(const TomlModel *self, const TomlModelEntry *parent, TomlAtom atom, uint32_t hash) {
+  const TomlKeySlots *slots = &self->slots;
+  uint32_t mask = slots->count - 1;
+  uint32_t i = hash & mask;
+  for (const TomlModelEntry *entry; (entry = slots->entries[i]); i = (i + 1) & mask) {
+    if (slots->hashes[i] == hash && entry->parent == parent && entry->atom == atom) break;
+  }
+  return i;
+}
+
+static TomlModelEntry *toml_model__find(const TomlModel *self, const TomlModelEntry *parent, TomlAtom atom) {
+  if (!self->slots.count) return NULL;
+  return self->slots.entries[toml_model__slot(self, parent, atom, toml_keys_mix(parent->hash, atom))];
+}
+
+// Returns the entry named `atom` in `parent`, creating it when missing.
+static TomlModelEntry *toml_model__child(TomlModel *self, TomlModelEntry *parent, TomlAtom atom) {
+  TomlModelEntry *entry = toml_model__find(self, parent, atom);
+  if (entry) return entry;
+
+  if (!toml_keys_reserve_slot(&self->slots)) return NULL;
+  entry = calloc(1, sizeof(TomlModelEntry));
+  if (!entry) return NULL;
+  entry->parent = parent;
+  entry->atom = atom;
+  entry->hash = toml_keys_mix(parent->hash, atom);
+  toml_keys_fill_slot(&self->slots, toml_model__slot(self, parent, atom, entry->hash), entry, entry->hash);
+  parent->child_count++;
+  return entry;
+}
+
+// Creates a table that no path reaches, for an element of an array of tables
+// or an inline table inside an array.
+static TomlModelEntry *toml_model__table(TomlModel *self) {
+  TomlModelEntry *entry = calloc(1, sizeof(TomlModelEntry));
+  if (!entry) return NULL;
+  entry->atom = TOML_ATOM_NONE;
+  entry->hash = toml_keys_mix(TOML_KEYS_ROOT_HASH ^ TOML_KEYS_UNNAMED_SEED, ++self->table_serial);
+  return entry;
+}
+
+static void toml_model__free_entry(TomlModel *self, TomlModelEntry *entry) {
+  toml_model__unlist_touched(self, entry);
+  toml_model__unlist_conflicted(self, entry);
+  free(entry->elements.contents);
+  free(entry);
+}
+
+// Frees an entry once nothing defines it and it has no children, then its
+// parents in turn.
+static void toml_model__release(TomlModel *self, TomlModelEntry *entry) {
+  while (entry->parent && !entry->definitions && !entry->child_count && !entry->elements.size) {
+    TomlModelEntry *parent = entry->parent;
+    toml_keys_remove_slot(&self->slots, entry, entry->hash);
+    toml_model__free_entry(self, entry);
+    parent->child_count--;
+    entry = parent;
+  }
+}
+
+static bool toml_model__touch(TomlModel *self, TomlModelEntry *entry) {
+  return toml_model__list(&self->touched, entry, &entry->touched);
+}
+
+/*
+ *  Arrays of tables
+ */
+
+// Returns the position of the first element of `array` that starts at or after `start_byte`.
+static uint32_t toml_model__element_position(const TomlModelEntry *array, uint32_t start_byte) {
+  uint32_t low = 0;
+  uint32_t high = array->elements.size;
+  while (low < high) {
+    uint32_t middle = low + (high - low) / 2;
+    if (array->elements.contents[middle]->start_byte < start_byte) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+static bool toml_model__add_element(TomlModelEntry *array, TomlModelSection *section) {
+  uint32_t position = toml_model__element_position(array, section->start_byte);
+  if (!toml_model__insert_sections(&array->elements, position, 1)) return false;
+  array->elements.contents[position] = section;
+  return true;
+}
+
+static void toml_model__remove_element(TomlModelEntry *array, TomlModelSection *section) {
+  uint32_t position = toml_model__element_position(array, section->start_byte);
+  while (array->elements.contents[position] != section) position++;
+  toml_model__erase_sections(&array->elements, position, 1);
+}
+
+// Returns the table that a header reaches through `entry` at `start_byte`:
+// the last element appended before it for an array of tables, or the entry.
+static TomlModelEntry *toml_model__resolve(TomlModelEntry *entry, uint32_t start_byte) {
+  uint32_t position = toml_model__element_position(entry, start_byte);
+  return position ? entry->elements.contents[position - 1]->element : entry;
+}
+
+static bool toml_model__note_changed_array(TomlModel *self, TomlModelEntry *array) {
+  for (uint32_t i = 0; i < self->changed_arrays.size; i++) {
+    if (self->changed_arrays.contents[i] == array) return true;
+  }
+  return toml_model__push_entry(&self->changed_arrays, array);
+}
+
+/*
+ *  Building sections
+ */
+
+static bool toml_model__fail(TomlModel *self) {
+  self->out_of_memory = true;
+  return false;
+}
+
+static bool toml_model__error(TomlModel *self, const TomlModelSection *section, TSNode node, const char *message) {
+  if (!toml_model__reserve(
+    (void **)&self->building_errors,
+    &self->building_error_capacity,
+    self->building_error_size + 1,
+    sizeof(TomlError)
+  )) {
+    return toml_model__fail(self);
+  }
+  TomlError *error = &self->building_errors[self->building_error_size++];
+  error->message = message;
+  error->start_byte = ts_node_start_byte(node) - section->start_byte;
+  error->end_byte = ts_node_end_byte(node) - section->start_byte;
+  return true;
+}
+
+static TomlModelDefinition *toml_model__define(
+  TomlModel *self,
+  const TomlModelSection *section,
+  TomlModelEntry *entry,
+  TomlKeyDefinition kind,
+  TSNode node
+) {
+  if (!toml_model__reserve(
+    (void **)&self->building,
+    &self->building_capacity,
+    self->building_size + 1,
+    sizeof(TomlModelDefinition)
+  )) {
+    toml_model__fail(self);
+    return NULL;
+  }
+  TomlModelDefinition *definition = &self->building[self->building_size++];
+  memset(definition, 0, sizeof(TomlModelDefinition));
+  definition->entry = entry;
+  definition->kind = kind;
+  definition->start = ts_node_start_byte(node) - section->start_byte;
+  definition->end = ts_node_end_byte(node) - section->start_byte;
+  return definition;
+}
+
+// Returns the atom of a key segment, or `TOML_ATOM_NONE` when its escapes are
+// wrong or memory runs out, which also sets `out_of_memory`.
+static TomlAtom toml_model__key_segment(TomlModel *self, const TomlModelSection *section, TSNode node) {
+  TomlString key;
+  TomlSyntaxDecodeResult decoded = toml_syntax_key_segment(&self->symbols, self->source, node, &self->scratch, &key);
+  if (decoded == TomlSyntaxOutOfMemory) {
+    toml_model__fail(self);
+    return TOML_ATOM_NONE;
+  }
+  if (decoded != TomlSyntaxDecoded) {
+    toml_model__error(self, section, node, toml_syntax_message(decoded));
+    return TOML_ATOM_NONE;
+  }
+
+  TomlAtom atom = toml_keys_intern(&self->atoms, key, self->atom_arena);
+  if (atom == TOML_ATOM_NONE) toml_model__fail(self);
+  return atom;
+}
+
+static bool toml_model__pair(TomlModel *self, TomlModelSection *section, TomlModelEntry *table, TSNode node);
+
+static bool toml_model__pairs(TomlModel *self, TomlModelSection *section, TomlModelEntry *table, TSNode node, uint32_t start) {
+  uint32_t count = ts_node_named_child_count(node);
+  for (uint32_t i = start; i < count; i++) {
+    TSNode child = ts_node_named_child(node, i);
+    if (ts_node_symbol(child) == self->symbols.pair && !toml_model__pair(self, section, table, child)) return false;
+  }
+  return true;
+}
+
+// Gives each inline table inside an array a table of its own, so that only its own keys can clash.
+static bool toml_model__array(TomlModel *self, TomlModelSection *section, TSNode node) {
+  uint32_t count = ts_node_named_child_count(node);
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode item = ts_node_named_child(node, i);
+    TSSymbol symbol = ts_node_symbol(item);
+    if (symbol == self->symbols.array) {
+      if (!toml_model__array(self, section, item)) return false;
+    } else if (symbol == self->symbols.inline_table) {
+      TomlModelEntry *table = toml_model__table(self);
+      if (!table || !toml_model__push_entry(&section->tables, table)) {
+        free(table);
+        return toml_model__fail(self);
+      }
+      if (!toml_model__pairs(self, section, table, item, 0)) return false;
+    }
+  }
+  return true;
+}
+
+static bool toml_model__pair(TomlModel *self, TomlModelSection *section, TomlModelEntry *table, TSNode node) {
+  TSNode key = ts_node_named_child(node, 0);
+  TSNode value = ts_node_next_named_sibling(key);
+  while (!ts_node_is_null(value) && toml_syntax_is_comment(&self->symbols, value)) {
+    value = ts_node_next_named_sibling(value);
+  }
+
+  uint32_t count = ts_node_named_child_count(key);
+  TSNode name_node = {{0}, NULL, NULL};
+  TomlAtom name = TOML_ATOM_NONE;
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode segment = ts_node_named_child(key, i);
+    if (toml_syntax_is_comment(&self->symbols, segment)) continue;
+    if (name != TOML_ATOM_NONE) {
+      table = toml_model__child(self, table, name);
+      if (!table) return toml_model__fail(self);
+      if (!toml_model__define(self, section, table, TomlKeyDefinitionDotted, name_node)) return false;
+    }
+    name = toml_model__key_segment(self, section, segment);
+    if (name == TOML_ATOM_NONE) return !self->out_of_memory;
+    name_node = segment;
+  }
+
+  TomlModelEntry *entry = toml_model__child(self, table, name);
+  if (!entry) return toml_model__fail(self);
+
+  TSSymbol symbol = ts_node_symbol(value);
+  bool is_inline = symbol == self->symbols.inline_table;
+  TomlKeyDefinition kind = is_inline ? TomlKeyDefinitionInline : TomlKeyDefinitionValue;
+  TomlModelDefinition *definition = toml_model__define(self, section, entry, kind, name_node);
+  if (!definition) return false;
+  definition->value_start = ts_node_start_byte(value) - section->start_byte;
+  definition->value_end = ts_node_end_byte(value) - section->start_byte;
+
+  if (is_inline) return toml_model__pairs(self, section, entry, value, 0);
+  if (symbol == self->symbols.array) return toml_model__array(self, section, value);
+  return true;
+}
+
+// Defines the keys of a header, and sets `*table` to where its pairs go unless a key is wrong.
+static bool toml_model__header(TomlModel *self, TomlModelSection *section, TSNode node, TomlModelEntry **table) {
+  *table = NULL;
+  TSNode key = ts_node_named_child(ts_node_named_child(node, 0), 0);
+  uint32_t count = ts_node_named_child_count(key);
+  TomlModelEntry *parent = self->root;
+  TSNode name_node = {{0}, NULL, NULL};
+  TomlAtom name = TOML_ATOM_NONE;
+
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode segment = ts_node_named_child(key, i);
+    if (toml_syntax_is_comment(&self->symbols, segment)) continue;
+    if (name != TOML_ATOM_NONE) {
+      TomlModelEntry *entry = toml_model__child(self, parent, name);
+      if (!entry) return toml_model__fail(self);
+      if (!toml_model__define(self, section, entry, TomlKeyDefinitionImplicit, name_node)) return false;
+      parent = toml_model__resolve(entry, section->start_byte);
+    }
+    name = toml_model__key_segment(self, section, segment);
+    if (name == TOML_ATOM_NONE) return !self->out_of_memory;
+    name_node = segment;
+  }
+
+  TomlModelEntry *entry = toml_model__child(self, parent, name);
+  if (!entry) return toml_model__fail(self);
+
+  if (section->kind == TomlModelSectionTable) {
+    *table = entry;
+    return toml_model__define(self, section, entry, TomlKeyDefinitionHeader, key) != NULL;
+  }
+
+  if (!section->element) section->element = toml_model__table(self);
+  if (!section->element || !toml_model__add_element(entry, section)) return toml_model__fail(self);
+  section->array = entry;
+  *table = section->element;
+  return toml_model__define(self, section, entry, TomlKeyDefinitionElement, key) != NULL;
+}
+
+static void toml_model__list_errors(TomlModel *self, TomlModelSection *section) {
+  if (section->error_count && !section->listed) {
+    if (!toml_model__reserve(
+      (void **)&self->erroneous.contents,
+      &self->erroneous.capacity,
+      self->erroneous.size + 1,
+      sizeof(TomlModelSection *)
+    )) {
+      toml_model__fail(self);
+      return;
+    }
+    self->erroneous.contents[self->erroneous.size++] = section;
+    section->listed = self->erroneous.size;
+  } else if (!section->error_count && section->listed) {
+    TomlModelSection *last = self->erroneous.contents[--self->erroneous.size];
+    self->erroneous.contents[section->listed - 1] = last;
+    last->listed = section->listed;
+    section->listed = 0;
+  }
+}
+
+// Defines the keys of a section from its node in the current tree.
+static bool toml_model__build(TomlModel *self, TomlModelSection *section, TSNode node) {
+  TSSymbol symbol = ts_node_symbol(node);
+  section->start_byte = ts_node_start_byte(node);
+  section->end_byte = ts_node_end_byte(node);
+  section->pending = false;
+  self->building_size = 0;
+  self->building_error_size = 0;
+
+  bool ok = true;
+  if (ts_node_has_error(node)) {
+    section->kind = TomlModelSectionError;
+    ok = toml_model__error(self, section, toml_syntax_first_error(node), "syntax error");
+  } else if (symbol == self->symbols.pair) {
+    section->kind = TomlModelSectionPair;
+    ok = toml_model__pair(self, section, self->root, node);
+  } else if (symbol == self->symbols.table || symbol == self->symbols.table_array_element) {
+    section->kind = symbol == self->symbols.table ? TomlModelSectionTable : TomlModelSectionTableArray;
+    TomlModelEntry *table;
+    ok = toml_model__header(self, section, node, &table) && (!table || toml_model__pairs(self, section, table, node, 1));
+  } else {
+    section->kind = TomlModelSectionError;
+    ok = toml_model__error(self, section, node, "syntax error");
+  }
+  if (!ok) return false;
+
+  if (self->building_size) {
+    section->definitions = malloc(self->building_size * sizeof(TomlModelDefinition));
+    if (!section->definitions) return toml_model__fail(self);
+    memcpy(section->definitions, self->building, self->building_size * sizeof(TomlModelDefinition));
+  }
+  section->definition_count = self->building_size;
+  for (uint32_t i = 0; i < section->definition_count; i++) {
+    TomlModelDefinition *definition = &section->definitions[i];
+    TomlModelEntry *entry = definition->entry;
+    definition->section = section;
+    definition->next = entry->definitions;
+    if (entry->definitions) entry->definitions->previous = definition;
+    entry->definitions = definition;
+    entry->kind_counts[definition->kind]++;
+    if (!toml_model__touch(self, entry)) return toml_model__fail(self);
+  }
+
+  if (self->building_error_size) {
+    section->errors = malloc(self->building_error_size * sizeof(TomlError));
+    if (!section->errors) return toml_model__fail(self);
+    memcpy(section->errors, self->building_errors, self->building_error_size * sizeof(TomlError));
+  }
+  section->error_count = self->building_error_size;
+  toml_model__list_errors(self, section);
+  return !self->out_of_memory;
+}
+
+// Removes everything a section defines, keeping the table of its element.
+static bool toml_model__clear(TomlModel *self, TomlModelSection *section) {
+  if (section->array) {
+    toml_model__remove_element(section->array, section);
+    if (!toml_model__note_changed_array(self, section->array)) return toml_model__fail(self);
+    section->array = NULL;
+  }
+
+  // children are defined after their parents, so going backwards releases
+  // them first and never frees an entry that an earlier definition still uses
+  for (uint32_t i = section->definition_count; i > 0; i--) {
+    TomlModelDefinition *definition = &section->definitions[i - 1];
+    TomlModelEntry *entry = definition->entry;
+    if (definition->previous) {
+      definition->previous->next = definition->next;
+    } else {
+      entry->definitions = definition->next;
+    }
+    if (definition->next) definition->next->previous = definition->previous;
+    entry->kind_counts[definition->kind]--;
+    if (definition->value) {
+      self->decoded_count--;
+      self->stale_count++;
+    }
+    if (!toml_model__touch(self, entry)) return toml_model__fail(self);
+    toml_model__release(self, entry);
+  }
+
+  for (uint32_t i = 0; i < section->tables.size; i++) {
+    toml_model__free_entry(self, section->tables.contents[i]);
+  }
+  section->tables.size = 0;
+  free(section->definitions);
+  section->definitions = NULL;
+  section->definition_count = 0;
+  free(section->errors);
+  section->errors = NULL;
+  section->error_count = 0;
+  toml_model__list_errors(self, section);
+  return true;
+}
+
+static void toml_model__free_section(TomlModel *self, TomlModelSection *section) {
+  if (section->element) toml_model__free_entry(self, section->element);
+  free(section->tables.contents);
+  free(section);
+}
+
+/*
+ *  Errors
+ */
+
+static uint32_t toml_model__definition_start(const TomlModelDefinition *definition) {
+  return definition->section->start_byte + definition->start;
+}
+
+static int toml_model__compare_definitions(const void *a, const void *b) {
+  uint32_t left = toml_model__definition_start(*(const TomlModelDefinition *const *)a);
+  uint32_t right = toml_model__definition_start(*(const TomlModelDefinition *const *)b);
+  return left < right ? -1 : left > right;
+}
+
+// Collects the definitions of an entry in document order into `sorted`.
+static uint32_t toml_model__sorted_definitions(TomlModel *self, const TomlModelEntry *entry) {
+  uint32_t count = 0;
+  for (const TomlModelDefinition *definition = entry->definitions; definition; definition = definition->next) {
+    if (!toml_model__reserve((void **)&self->sorted, &self->sorted_capacity, count + 1, sizeof(TomlModelDefinition *))) {
+      toml_model__fail(self);
+      return count;
+    }
+    self->sorted[count++] = (TomlModelDefinition *)definition;
+  }
+  if (count > 1) qsort(self->sorted, count, sizeof(TomlModelDefinition *), toml_model__compare_definitions);
+  return count;
+}
+
+// Whether the definitions of an entry can break a rule in some order. Tables
+// that pairs and headers only go through, and that at most one header defines
+// unless dotted keys also do, cannot, and neither can arrays of tables that
+// are only appended to. Sections repeat these shapes the most, so an edit to
+// one of many `[deps.x]` sections does not have to order every definition of
+// `deps` again.
+static bool toml_model__may_conflict(const TomlModelEntry *entry) {
+  const uint32_t *counts = entry->kind_counts;
+  if (counts[TomlKeyDefinitionValue] || counts[TomlKeyDefinitionInline]) return true;
+  if (counts[TomlKeyDefinitionElement]) {
+    return counts[TomlKeyDefinitionHeader] || counts[TomlKeyDefinitionDotted] || counts[TomlKeyDefinitionImplicit];
+  }
+  return counts[TomlKeyDefinitionHeader] > 1 || (counts[TomlKeyDefinitionHeader] && counts[TomlKeyDefinitionDotted]);
+}
+
+// Writes the errors of an entry from `errors[offset]` on, as far as `capacity` allows, and returns how many it has.
+static uint32_t toml_model__entry_errors(TomlModel *self, const TomlModelEntry *entry, TomlError *errors, uint32_t offset, uint32_t capacity) {
+  // one definition is always fine
+  const TomlModelDefinition *first = entry->definitions;
+  if (!first || !first->next || !toml_model__may_conflict(entry)) return 0;
+
+  uint32_t count = toml_model__sorted_definitions(self, entry);
+  TomlKeyState state = TomlKeyStateNone;
+  uint32_t error_count = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    const TomlModelDefinition *definition = self->sorted[i];
+    const char *message = toml_keys_define(&state, definition->kind);
+    if (!message) continue;
+    if (offset + error_count < capacity) {
+      TomlError *error = &errors[offset + error_count];
+      error->message = message;
+      error->start_byte = toml_model__definition_start(definition);
+      error->end_byte = definition->section->start_byte + definition->end;
+    }
+    error_count++;
+  }
+  return error_count;
+}
+
+static void toml_model__check_touched(TomlModel *self) {
+  for (uint32_t i = 0; i < self->touched.size; i++) {
+    TomlModelEntry *entry = self->touched.contents[i];
+    entry->touched = 0;
+    if (toml_model__entry_errors(self, entry, NULL, 0, 0)) {
+      if (!toml_model__list(&self->conflicted, entry, &entry->conflicted)) toml_model__fail(self);
+    } else {
+      toml_model__unlist_conflicted(self, entry);
+    }
+  }
+  self->touched.size = 0;
+}
+
+/*
+ *  Updating
+ */
+
+static bool toml_model__is_section(const TomlModel *self, TSNode node) {
+  return ts_node_is_named(node) && !toml_syntax_is_comment(&self->symbols, node);
+}
+
+// Moves the cursor to the first top-level node of the current tree that ends after `byte`.
+static bool toml_model__seek(TomlModel *self, uint32_t byte) {
+  ts_tree_cursor_reset(&self->cursor, ts_tree_root_node(self->tree));
+  return ts_tree_cursor_goto_first_child_for_byte(&self->cursor, byte) >= 0;
+}
+
+static TSNode toml_model__node_at(TomlModel *self, uint32_t start_byte) {
+  if (toml_model__seek(self, start_byte)) {
+    do {
+      TSNode node = ts_tree_cursor_current_node(&self->cursor);
+      if (ts_node_start_byte(node) > start_byte) break;
+      if (ts_node_start_byte(node) == start_byte && toml_model__is_section(self, node)) return node;
+    } while (ts_tree_cursor_goto_next_sibling(&self->cursor));
+  }
+  return (TSNode) {{0}, NULL, NULL};
+}
+
+// Returns the position of the first section that ends at or after `byte`.
+static uint32_t toml_model__section_position(const TomlModel *self, uint32_t byte) {
+  uint32_t low = 0;
+  uint32_t high = self->sections.size;
+  while (low < high) {
+    uint32_t middle = low + (high - low) / 2;
+    if (self->sections.contents[middle]->end_byte < byte) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+// Replaces the sections in and around `[*start, *end]` with pending sections
+// for the top-level nodes of the new tree there, growing the range until
+// both sides cover the same text. Returns the position of the first one.
+static bool toml_model__replace(TomlModel *self, uint32_t *start, uint32_t *end, uint32_t *position, uint32_t *pending) {
+  uint32_t low = *start;
+  uint32_t high = *end;
+  uint32_t first, last;
+
+  for (;;) {
+    bool grew = false;
+
+    first = toml_model__section_position(self, low);
+    for (last = first; last < self->sections.size && self->sections.contents[last]->start_byte <= high; last++) {
+      TomlModelSection *section = self->sections.contents[last];
+      if (section->start_byte < low) low = section->start_byte, grew = true;
+      if (section->end_byte > high) high = section->end_byte, grew = true;
+    }
+
+    if (toml_model__seek(self, low)) {
+      do {
+        TSNode node = ts_tree_cursor_current_node(&self->cursor);
+        if (ts_node_start_byte(node) > high) break;
+        if (!toml_model__is_section(self, node)) continue;
+        if (ts_node_start_byte(node) < low) low = ts_node_start_byte(node), grew = true;
+        if (ts_node_end_byte(node) > high) high = ts_node_end_byte(node), grew = true;
+      } while (ts_tree_cursor_goto_next_sibling(&self->cursor));
+    }
+
+    if (!grew) break;
+  }
+
+  for (uint32_t i = first; i < last; i++) {
+    TomlModelSection *section = self->sections.contents[i];
+    if (!toml_model__clear(self, section)) return false;
+    if (!toml_model__reserve(
+      (void **)&self->removed.contents,
+      &self->removed.capacity,
+      self->removed.size + 1,
+      sizeof(TomlModelSection *)
+    )) {
+      return toml_model__fail(self);
+    }
+    self->removed.contents[self->removed.size++] = section;
+  }
+  toml_model__erase_sections(&self->sections, first, last - first);
+
+  uint32_t count = 0;
+  if (toml_model__seek(self, low)) {
+    do {
+      TSNode node = ts_tree_cursor_current_node(&self->cursor);
+      if (ts_node_start_byte(node) > high) break;
+      if (!toml_model__is_section(self, node)) continue;
+
+      TomlModelSection *section = calloc(1, sizeof(TomlModelSection));
+      if (!section || !toml_model__insert_sections(&self->sections, first + count, 1)) {
+        free(section);
+        return toml_model__fail(self);
+      }
+      section->start_byte = ts_node_start_byte(node);
+      section->end_byte = ts_node_end_byte(node);
+      section->pending = true;
+      self->sections.contents[first + count++] = section;
+    } while (ts_tree_cursor_goto_next_sibling(&self->cursor));
+  }
+
+  *start = low;
+  *end = high;
+  *position = first;
+  *pending += count;
+  return true;
+}
+
+// Whether a header of `section` goes through an array of tables whose elements changed.
+static bool toml_model__depends_on_changed_array(const TomlModel *self, const TomlModelSection *section) {
+  for (uint32_t i = 0; i < section->definition_count; i++) {
+    const TomlModelDefinition *definition = &section->definitions[i];
+    if (definition->kind != TomlKeyDefinitionImplicit) continue;
+    for (uint32_t j = 0; j < self->changed_arrays.size; j++) {
+      if (self->changed_arrays.contents[j] == definition->entry) return true;
+    }
+  }
+  return false;
+}
+
+static void toml_model__forget_changed_array(TomlModel *self, const TomlModelEntry *array) {
+  for (uint32_t i = 0; i < self->changed_arrays.size; i++) {
+    if (self->changed_arrays.contents[i] == array) {
+      self->changed_arrays.contents[i] = self->changed_arrays.contents[--self->changed_arrays.size];
+      return;
+    }
+  }
+}
+
+// Builds the pending sections from `position` on, and rebuilds the sections
+// after them whose headers now reach a different element of an array of tables.
+static bool toml_model__rebuild(TomlModel *self, uint32_t position, uint32_t pending) {
+  for (uint32_t i = position; i < self->sections.size; i++) {
+    if (!pending && !self->changed_arrays.size) break;
+
+    TomlModelSection *section = self->sections.contents[i];
+    const TomlModelEntry *array = section->array;
+    bool changed;
+    if (section->pending) {
+      changed = true;
+      pending--;
+    } else {
+      changed = toml_model__depends_on_changed_array(self, section);
+      if (changed && !toml_model__clear(self, section)) return false;
+    }
+
+    if (changed) {
+      TSNode node = toml_model__node_at(self, section->start_byte);
+      if (ts_node_is_null(node) || !toml_model__build(self, section, node)) return toml_model__fail(self);
+    }
+
+    // the sections after an element that stayed where it was still reach it
+    if (section->array) {
+      if (changed && section->array != array) {
+        if (!toml_model__note_changed_array(self, section->array)) return toml_model__fail(self);
+      } else {
+        toml_model__forget_changed_array(self, section->array);
+      }
+    }
+  }
+  return true;
+}
+
+static void toml_model__release_stale_values(TomlModel *self) {
+  if (self->stale_count < TOML_MODEL_STALE_VALUE_LIMIT || self->stale_count < self->decoded_count) return;
+
+  const TSLanguage *language = ts_tree_language(self->tree);
+  TomlValueDecoder *decoder = toml_value_decoder_new(language, self->source);
+  if (!decoder) return;
+  toml_value_decoder_delete(self->decoder);
+  self->decoder = decoder;
+
+  for (uint32_t i = 0; i < self->sections.size; i++) {
+    TomlModelSection *section = self->sections.contents[i];
+    for (uint32_t j = 0; j < section->definition_count; j++) section->definitions[j].value = NULL;
+  }
+  self->decoded_count = 0;
+  self->stale_count = 0;
+}
+
+static int toml_model__compare_ranges(const void *a, const void *b) {
+  uint32_t left = ((const TSRange *)a)->start_byte;
+  uint32_t right = ((const TSRange *)b)->start_byte;
+  return left < right ? -1 : left > right;
+}
+
+static int toml_model__compare_errors(const void *a, const void *b) {
+  const TomlError *left = a;
+  const TomlError *right = b;
+  if (left->start_byte != right->start_byte) return left->start_byte < right->start_byte ? -1 : 1;
+  if (left->end_byte != right->end_byte) return left->end_byte < right->end_byte ? -1 : 1;
+  return strcmp(left->message, right->message);
+}
+
+/*
+ *  Public
+ */
+
+TomlModel *toml_model_new(const TSTree *tree, const char *source) {
+  TomlModel *self = calloc(1, sizeof(TomlModel));
+  if (!self) return NULL;
+
+  const TSLanguage *language = ts_tree_language(tree);
+  TSNode document = ts_tree_root_node(tree);
+  self->root = calloc(1, sizeof(TomlModelEntry));
+  self->atom_arena = toml_arena_new(4096);
+  self->decoder = toml_value_decoder_new(language, source);
+  self->cursor = ts_tree_cursor_new(document);
+  toml_syntax_init_symbols(&self->symbols, language);
+  if (!self->root || !self->atom_arena || !self->decoder) {
+    toml_model_delete(self);
+    return NULL;
+  }
+  self->root->atom = TOML_ATOM_NONE;
+  self->root->hash = TOML_KEYS_ROOT_HASH;
+
+  TSRange whole = {
+    .start_point = ts_node_start_point(document),
+    .end_point = ts_node_end_point(document),
+    .start_byte = ts_node_start_byte(document),
+    .end_byte = ts_node_end_byte(document),
+  };
+  if (!toml_model_update(self, tree, source, &whole, 1)) {
+    toml_model_delete(self);
+    return NULL;
+  }
+  return self;
+}
+
+void toml_model_delete(TomlModel *self) {
+  if (!self) return;
+  for (uint32_t i = 0; i < self->sections.size; i++) {
+    TomlModelSection *section = self->sections.contents[i];
+    for (uint32_t j = 0; j < section->tables.size; j++) free(section->tables.contents[j]);
+    free(section->definitions);
+    free(section->errors);
+    toml_model__free_section(self, section);
+  }
+  for (uint32_t i = 0; i < self->removed.size; i++) toml_model__free_section(self, self->removed.contents[i]);
+  for (uint32_t i = 0; i < self->slots.count; i++) {
+    TomlModelEntry *entry = self->slots.entries[i];
+    if (entry) {
+      free(entry->elements.contents);
+      free(entry);
+    }
+  }
+  free(self->root);
+  free(self->sections.contents);
+  toml_keys_free_slots(&self->slots);
+  toml_keys_free_atoms(&self->atoms);
+  toml_arena_delete(self->atom_arena);
+  free(self->touched.contents);
+  free(self->conflicted.contents);
+  free(self->erroneous.contents);
+  free(self->removed.contents);
+  free(self->changed_arrays.contents);
+  free(self->building);
+  free(self->building_errors);
+  free(self->sorted);
+  toml_syntax_free_scratch(&self->scratch);
+  ts_tree_cursor_delete(&self->cursor);
+  toml_value_decoder_delete(self->decoder);
+  free(self);
+}
+
+void toml_model_edit(TomlModel *self, const TSInputEdit *edit) {
+  int64_t delta = (int64_t)edit->new_end_byte - (int64_t)edit->old_end_byte;
+  uint32_t i = toml_model__section_position(self, edit->start_byte);
+
+  for (; i < self->sections.size; i++) {
+    TomlModelSection *section = self->sections.contents[i];
+    if (section->start_byte > edit->old_end_byte) {
+      section->start_byte = (uint32_t)(section->start_byte + delta);
+      section->end_byte = (uint32_t)(section->end_byte + delta);
+    } else {
+      // sections touching the edit are rebuilt whole, so only their extent matters
+      if (section->start_byte > edit->start_byte) section->start_byte = edit->start_byte;
+      section->end_byte = section->end_byte > edit->old_end_byte
+        ? (uint32_t)(section->end_byte + delta)
+        : edit->new_end_byte;
+      section->dirty = true;
+    }
+  }
+}
+
+bool toml_model_update(
+  TomlModel *self,
+  const TSTree *tree,
+  const char *source,
+  const TSRange *changed_ranges,
+  uint32_t changed_range_count
+) {
+  self->tree = tree;
+  self->source = source;
+  toml_value_decoder_set_source(self->decoder, source);
+
+  // the changed ranges and the sections that edits touched, in document order
+  uint32_t range_count = changed_range_count;
+  for (uint32_t i = 0; i < self->sections.size; i++) range_count += self->sections.contents[i]->dirty;
+  TSRange *ranges = malloc((range_count ? range_count : 1) * sizeof(TSRange));
+  if (!ranges) return toml_model__fail(self);
+  memcpy(ranges, changed_ranges, changed_range_count * sizeof(TSRange));
+  range_count = changed_range_count;
+  for (uint32_t i = 0; i < self->sections.size; i++) {
+    TomlModelSection *section = self->sections.contents[i];
+    if (!section->dirty) continue;
+    ranges[range_count].start_byte = section->start_byte;
+    ranges[range_count].end_byte = section->end_byte;
+    range_count++;
+  }
+  qsort(ranges, range_count, sizeof(TSRange), toml_model__compare_ranges);
+
+  uint32_t first = UINT32_MAX;
+  uint32_t pending = 0;
+  bool ok = true;
+  for (uint32_t i = 0; i < range_count && ok; i++) {
+    uint32_t start = ranges[i].start_byte;
+    uint32_t end = ranges[i].end_byte;
+    while (i + 1 < range_count && ranges[i + 1].start_byte <= end) {
+      if (ranges[++i].end_byte > end) end = ranges[i].end_byte;
+    }
+
+    uint32_t position;
+    ok = toml_model__replace(self, &start, &end, &position, &pending);
+    if (ok && position < first) first = position;
+
+    // the replaced range may have grown over the next ones
+    while (i + 1 < range_count && ranges[i + 1].end_byte <= end) i++;
+  }
+  free(ranges);
+
+  if (ok && first != UINT32_MAX) ok = toml_model__rebuild(self, first, pending);
+  if (!ok) return toml_model__fail(self);
+
+  for (uint32_t i = 0; i < self->removed.size; i++) toml_model__free_section(self, self->removed.contents[i]);
+  self->removed.size = 0;
+  self->changed_arrays.size = 0;
+  toml_model__check_touched(self);
+  toml_model__release_stale_values(self);
+  return !self->out_of_memory;
+}
+
+uint32_t toml_model_errors(TomlModel *self, TomlError *errors, uint32_t capacity) {
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < self->erroneous.size; i++) count += self->erroneous.contents[i]->error_count;
+  for (uint32_t i = 0; i < self->conflicted.size; i++) {
+    count += toml_model__entry_errors(self, self->conflicted.contents[i], NULL, 0, 0);
+  }
+
+  // all of them are sorted, so the first `capacity` are the first in the document
+  TomlError *all = malloc((count ? count : 1) * sizeof(TomlError));
+  if (!all) return count;
+  uint32_t size = 0;
+  for (uint32_t i = 0; i < self->erroneous.size; i++) {
+    const TomlModelSection *section = self->erroneous.contents[i];
+    for (uint32_t j = 0; j < section->error_count; j++) {
+      TomlError *error = &all[size++];
+      *error = section->errors[j];
+      error->start_byte += section->start_byte;
+      error->end_byte += section->start_byte;
+    }
+  }
+  for (uint32_t i = 0; i < self->conflicted.size; i++) {
+    size += toml_model__entry_errors(self, self->conflicted.contents[i], all, size, count);
+  }
+  qsort(all, size, sizeof(TomlError), toml_model__compare_errors);
+  if (capacity) memcpy(errors, all, (size < capacity ? size : capacity) * sizeof(TomlError));
+  free(all);
+  return count;
+}
+
+const TomlValue *toml_model_get(TomlModel *self, const TomlString *keys, uint32_t count, TomlError *error) {
+  TomlModelEntry *entry = self->root;
+  for (uint32_t i = 0; i < count && entry; i++) {
+    TomlAtom atom = toml_keys_find_atom(&self->atoms, keys[i]);
+    entry = atom == TOML_ATOM_NONE ? NULL : toml_model__find(self, entry, atom);
+  }
+  if (!entry || entry == self->root) return NULL;
+
+  // a key defined twice keeps its first value
+  TomlModelDefinition *pair = NULL;
+  for (TomlModelDefinition *definition = entry->definitions; definition; definition = definition->next) {
+    if (definition->kind != TomlKeyDefinitionValue && definition->kind != TomlKeyDefinitionInline) continue;
+    if (!pair || toml_model__definition_start(definition) < toml_model__definition_start(pair)) pair = definition;
+  }
+  if (!pair) return NULL;
+
+  uint32_t start = pair->section->start_byte + pair->value_start;
+  uint32_t end = pair->section->start_byte + pair->value_end;
+  if (pair->value) {
+    if (pair->value->start_byte == start) return pair->value;
+    // decoded before an edit moved its section, so its byte offsets are behind
+    pair->value = NULL;
+    self->decoded_count--;
+    self->stale_count++;
+  }
+
+  TSNode node = ts_node_named_descendant_for_byte_range(ts_tree_root_node(self->tree), start, end);
+  pair->value = toml_value_decoder_decode(self->decoder, node, error);
+  if (pair->value) self->decoded_count++;
+  return pair->value;
+}
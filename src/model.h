@@ -0,0 +1,81 @@
+#ifndef TREE_SITTER_TOML_MODEL_H_
+#define TREE_SITTER_TOML_MODEL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "./value.h"
+
+/*
+ *  Incremental semantic model.
+ *
+ *  A `TomlModel` holds what an editor needs to know about a document beyond
+ *  its tree: which key paths exist, the decoded value of each pair, and the
+ *  errors of `validate.h`. It follows the tree through edits the same way
+ *  the tree follows the text. Every edit given to `ts_tree_edit` is also
+ *  given to `toml_model_edit`. After the reparse, `toml_model_update` gets
+ *  the new tree and the ranges from `ts_tree_get_changed_ranges`.
+ *
+ *  The model is kept per top-level `pair`, `table` and `table_array_element`.
+ *  An update rebuilds only the ones that the edits and the changed ranges
+ *  touch, together with the later sections whose header goes through an
+ *  array of tables that gained or lost an element. It changes their key
+ *  definitions and errors in place, so its cost grows with the edit rather
+ *  than with the document, apart from shifting section offsets.
+ *
+ *  Errors are those of `toml_validator_check`, except that keys below one
+ *  that conflicts, and the pairs of a section whose header conflicts, are
+ *  still checked. A section with syntax errors gets one "syntax error" and
+ *  defines no keys, while the rest of the document is checked as usual.
+ */
+
+typedef struct TomlModel TomlModel;
+
+/**
+ * Build the model of a whole tree. Returns NULL when out of memory.
+ */
+TomlModel *toml_model_new(const TSTree *tree, const char *source);
+
+void toml_model_delete(TomlModel *self);
+
+/**
+ * Shift the model by an edit, as `ts_tree_edit` does for a tree. The parts
+ * of the model that the edit overlaps are rebuilt on the next update.
+ */
+void toml_model_edit(TomlModel *self, const TSInputEdit *edit);
+
+/**
+ * Bring the model up to date with `tree`, the reparse of the edited text
+ * `source`, given the ranges that changed since the last update. The tree
+ * and the source must stay alive until the next update. Returns false when
+ * out of memory, after which the model can only be deleted.
+ */
+bool toml_model_update(
+  TomlModel *self,
+  const TSTree *tree,
+  const char *source,
+  const TSRange *changed_ranges,
+  uint32_t changed_range_count
+);
+
+/**
+ * Write up to `capacity` errors to `errors` in the order they appear in the
+ * document, returning how many there are in total.
+ */
+uint32_t toml_model_errors(TomlModel *self, TomlError *errors, uint32_t capacity);
+
+/**
+ * Find the pair at the path made of `count` decoded keys below the root
+ * table, and decode its value or return the one decoded before, unless an
+ * edit has moved it since. Returns NULL if there is no such pair, and fills
+ * in `error` (when given) if decoding fails. Values stay valid until the next
+ * update.
+ */
+const TomlValue *toml_model_get(TomlModel *self, const TomlString *keys, uint32_t count, TomlError *error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_MODEL_H_
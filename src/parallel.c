@@ -0,0 +1,161 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "./parallel.h"
+#include "./structural.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  const TSLanguage *language;
+  const char *source;
+  uint32_t length;
+  TSRange range;
+  TSTree *tree;
+} TomlParallelJob;
+
+#define TOML_PARALLEL_POSITIONS 4096
+
+// Whether only spaces and tabs come before `offset` on its line.
+static bool toml_parallel__at_line_start(const char *source, uint32_t offset, uint32_t *column) {
+  uint32_t start = offset;
+  while (start > 0 && (source[start - 1] == ' ' || source[start - 1] == '\t' || source[start - 1] == '\r')) start--;
+  *column = offset - start;
+  return start == 0 || source[start - 1] == '\n';
+}
+
+static uint32_t toml_parallel__count_rows(const char *source, uint32_t start, uint32_t end) {
+  uint32_t rows = 0;
+  const char *cursor = source + start;
+  const char *limit = source + end;
+  while ((cursor = memchr(cursor, '\n', (size_t)(limit - cursor)))) {
+    rows++;
+    cursor++;
+  }
+  return rows;
+}
+
+uint32_t toml_parallel_split(const char *source, uint32_t length, uint32_t max_count, TSRange *ranges) {
+  uint32_t count = 1;
+  uint32_t depth = 0;
+  uint32_t row = 0;
+  uint32_t row_offset = 0;
+  uint64_t next_split = max_count > 1 ? length / max_count : UINT32_MAX;
+
+  ranges[0].start_byte = 0;
+  ranges[0].start_point = (TSPoint) {0, 0};
+
+  // headers are the `[` at line start outside of any array, string or comment
+  TomlStructuralScanner scanner;
+  uint32_t positions[TOML_PARALLEL_POSITIONS];
+  uint32_t position_count;
+  toml_structural_scanner_init(&scanner, source, length, toml_structural_best_kernel());
+  while (count < max_count && (position_count = toml_structural_next(&scanner, positions, TOML_PARALLEL_POSITIONS))) {
+    for (uint32_t i = 0; i < position_count; i++) {
+      uint32_t offset = positions[i];
+      uint32_t column;
+      switch (source[offset]) {
+        case '[':
+          if (
+            depth == 0 && offset >= next_split && offset > ranges[count - 1].start_byte && count < max_count
+            && toml_parallel__at_line_start(source, offset, &column)
+          ) {
+            row += toml_parallel__count_rows(source, row_offset, offset);
+            row_offset = offset;
+            ranges[count - 1].end_byte = offset;
+            ranges[count - 1].end_point = (TSPoint) {row, column};
+            ranges[count].start_byte = offset;
+            ranges[count].start_point = (TSPoint) {row, column};
+            count++;
+            next_split = (uint64_t)length * count / max_count;
+          }
+          depth++;
+          break;
+        case '{':
+          depth++;
+          break;
+        case ']':
+        case '}':
+          if (depth > 0) depth--;
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  uint32_t line_start = length;
+  while (line_start > 0 && source[line_start - 1] != '\n') line_start--;
+  row += toml_parallel__count_rows(source, row_offset, length);
+  ranges[count - 1].end_byte = length;
+  ranges[count - 1].end_point = (TSPoint) {row, length - line_start};
+  return count;
+}
+
+static void *toml_parallel__parse(void *payload) {
+  TomlParallelJob *job = payload;
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, job->language);
+  ts_parser_set_included_ranges(parser, &job->range, 1);
+  job->tree = ts_parser_parse_string(parser, NULL, job->source, job->length);
+  ts_parser_delete(parser);
+  return NULL;
+}
+
+bool toml_parallel_parse(
+  const TSLanguage *language,
+  const char *source,
+  uint32_t length,
+  uint32_t thread_count,
+  TomlParallelTrees *result
+) {
+  if (thread_count == 0) thread_count = 1;
+  TSRange *ranges = malloc(thread_count * sizeof(TSRange));
+  TomlParallelJob *jobs = malloc(thread_count * sizeof(TomlParallelJob));
+  pthread_t *threads = malloc(thread_count * sizeof(pthread_t));
+  bool *started = calloc(thread_count, sizeof(bool));
+  TSTree **trees = malloc(thread_count * sizeof(TSTree *));
+  if (!ranges || !jobs || !threads || !started || !trees) {
+    free(ranges);
+    free(jobs);
+    free(threads);
+    free(started);
+    free(trees);
+    return false;
+  }
+
+  uint32_t count = toml_parallel_split(source, length, thread_count, ranges);
+  for (uint32_t i = 0; i < count; i++) {
+    jobs[i] = (TomlParallelJob) {language, source, length, ranges[i], NULL};
+  }
+
+  // the calling thread takes the first piece, and any piece a thread could not be started for
+  for (uint32_t i = 1; i < count; i++) {
+    started[i] = pthread_create(&threads[i], NULL, toml_parallel__parse, &jobs[i]) == 0;
+  }
+  toml_parallel__parse(&jobs[0]);
+  for (uint32_t i = 1; i < count; i++) {
+    if (started[i]) {
+      pthread_join(threads[i], NULL);
+    } else {
+      toml_parallel__parse(&jobs[i]);
+    }
+  }
+
+  for (uint32_t i = 0; i < count; i++) trees[i] = jobs[i].tree;
+  result->trees = trees;
+  result->count = count;
+
+  free(ranges);
+  free(jobs);
+  free(threads);
+  free(started);
+  return true;
+}
+
+void toml_parallel_trees_delete(TomlParallelTrees *self) {
+  for (uint32_t i = 0; i < self->count; i++) ts_tree_delete(self->trees[i]);
+  free(self->trees);
+  self->trees = NULL;
+  self->count = 0;
+}
@@ -0,0 +1,57 @@
+#ifndef TREE_SITTER_TOML_PARALLEL_H_
+#define TREE_SITTER_TOML_PARALLEL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <tree_sitter/api.h>
+
+/*
+ *  Parallel parsing (POSIX threads).
+ *
+ *  A document is pairs followed by a flat run of `[table]` and `[[table]]`
+ *  sections, so it can be cut in front of any header and the pieces parsed
+ *  on their own. The structural index of `structural.h` finds the headers,
+ *  skipping over strings, comments and multiline arrays, and the pieces are
+ *  parsed concurrently with `ts_parser_set_included_ranges` over the
+ *  whole source. The trees therefore use the byte offsets and points of the
+ *  whole source, and their `document` roots read together in order as the
+ *  document's sections.
+ */
+
+typedef struct {
+  TSTree **trees;
+  uint32_t count;
+} TomlParallelTrees;
+
+/**
+ * Find up to `max_count` ranges that split `source` in front of top-level
+ * headers into pieces of about equal size, writing them to `ranges`. Returns
+ * the number of ranges, at least 1; fewer than asked for when there are not
+ * enough headers.
+ */
+uint32_t toml_parallel_split(const char *source, uint32_t length, uint32_t max_count, TSRange *ranges);
+
+/**
+ * Parse `source` on up to `thread_count` threads, the calling thread included.
+ * A piece whose thread cannot be started is parsed on the calling thread
+ * instead. Returns false, with nothing to delete, only when out of memory.
+ */
+bool toml_parallel_parse(
+  const TSLanguage *language,
+  const char *source,
+  uint32_t length,
+  uint32_t thread_count,
+  TomlParallelTrees *result
+);
+
+void toml_parallel_trees_delete(TomlParallelTrees *self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_PARALLEL_H_
@@ -13,21 +13,158 @@ enum TokenType {
   MULTILINE_LITERAL_STRING_END,
 };
 
-void *tree_sitter_toml_external_scanner_create() { return NULL; }
-void tree_sitter_toml_external_scanner_destroy(void *payload) {}
-unsigned tree_sitter_toml_external_scanner_serialize(void *payload, char *buffer) { return 0; }
-void tree_sitter_toml_external_scanner_deserialize(void *payload, const char *buffer, unsigned length) {}
+enum StringKind {
+  NO_STRING,
+  BASIC_STRING,
+  LITERAL_STRING,
+};
+
+typedef struct {
+  // the multiline string the last external token was scanned in
+  uint8_t string;
+  // length of the delimiter run that stopped the last content token, 0 if unknown
+  uint8_t delimiter_run;
+} Scanner;
+
+void *tree_sitter_toml_external_scanner_create() {
+  return calloc(1, sizeof(Scanner));
+}
+
+void tree_sitter_toml_external_scanner_destroy(void *payload) {
+  free(payload);
+}
+
+unsigned tree_sitter_toml_external_scanner_serialize(void *payload, char *buffer) {
+  Scanner *scanner = (Scanner *)payload;
+  buffer[0] = (char)scanner->string;
+  buffer[1] = (char)scanner->delimiter_run;
+  return 2;
+}
+
+void tree_sitter_toml_external_scanner_deserialize(void *payload, const char *buffer, unsigned length) {
+  Scanner *scanner = (Scanner *)payload;
+  scanner->string = NO_STRING;
+  scanner->delimiter_run = 0;
+
+  if (length >= 2) {
+    scanner->string = (uint8_t)buffer[0];
+    scanner->delimiter_run = (uint8_t)buffer[1];
+  }
+}
+
+uint8_t tree_sitter_toml_external_scanner_count_delimiters(TSLexer *lexer, int32_t delimiter) {
+  uint8_t count = 0;
+
+  while (lexer->lookahead == delimiter) {
+    lexer->advance(lexer, false);
+    if (count < 0x7f) {
+      count++;
+    }
+  }
+
+  return count;
+}
+
+bool tree_sitter_toml_external_scanner_scan_multiline_string_body(TSLexer *lexer, int32_t delimiter, bool include_line_ending, uint8_t *delimiter_run) {
+  bool has_content = false;
+
+  for (;;) {
+    int32_t c = lexer->lookahead;
+
+    if (c == delimiter) {
+      // measure the run here, the next token needs its length to tell the content quotes from the end
+      lexer->mark_end(lexer);
+      *delimiter_run = tree_sitter_toml_external_scanner_count_delimiters(lexer, delimiter);
+      return has_content;
+    }
+
+    if (c == '\n' || c == '\r') {
+      // the line ending is the last part of the token, or left to the next one during error recovery
+      lexer->mark_end(lexer);
+      if (!include_line_ending) {
+        return has_content;
+      }
+      if (c == '\r') {
+        lexer->advance(lexer, false);
+        if (lexer->lookahead != '\n') {
+          return has_content;
+        }
+      }
+      lexer->advance(lexer, false);
+      lexer->mark_end(lexer);
+      return true;
+    }
 
-bool tree_sitter_toml_external_scanner_scan_multiline_string_end(TSLexer *lexer, const bool *valid_symbols, int32_t delimiter, enum TokenType content_symbol, enum TokenType end_symbol) {
-  if (!valid_symbols[end_symbol] || lexer->lookahead != delimiter) {
+    if ((delimiter == '"' && c == '\\') || (c < 0x20 && c != '\t') || c == 0x7f) {
+      break;
+    }
+
+    lexer->advance(lexer, false);
+    has_content = true;
+  }
+
+  lexer->mark_end(lexer);
+  return has_content;
+}
+
+bool tree_sitter_toml_external_scanner_scan_multiline_string_end(Scanner *scanner, TSLexer *lexer, const bool *valid_symbols, int32_t delimiter, enum TokenType content_symbol, enum TokenType end_symbol) {
+  if (!valid_symbols[end_symbol]) {
     return false;
   }
 
+  uint8_t kind = delimiter == '"' ? BASIC_STRING : LITERAL_STRING;
+
+  // the line ending is never valid inside a string, so it is only valid here during error recovery,
+  // where only the remembered string kind tells whether we are still in the middle of a string body
+  bool recovering = valid_symbols[LINE_ENDING_OR_EOF];
+  bool in_string = scanner->string == kind;
+  uint8_t delimiter_run = in_string ? scanner->delimiter_run : 0;
+
+  lexer->result_symbol = content_symbol;
+
+  if (lexer->lookahead != delimiter) {
+    // during error recovery a body is only continued in a string that was already seen, and never past the line
+    if (
+      !valid_symbols[content_symbol]
+      || (recovering && !in_string)
+      || !tree_sitter_toml_external_scanner_scan_multiline_string_body(lexer, delimiter, !recovering, &delimiter_run)
+    ) {
+      return false;
+    }
+    scanner->string = kind;
+    scanner->delimiter_run = delimiter_run;
+    return true;
+  }
+
+  if (delimiter_run >= 3) {
+    // the run was measured by the previous token, everything but the last three is content
+    uint8_t length = delimiter_run == 3 ? 3 : delimiter_run - 3;
+    for (uint8_t i = 0; i < length; i++) {
+      if (lexer->lookahead != delimiter) {
+        return false;
+      }
+      lexer->advance(lexer, false);
+    }
+    lexer->mark_end(lexer);
+
+    if (delimiter_run == 3) {
+      scanner->string = NO_STRING;
+      scanner->delimiter_run = 0;
+      lexer->result_symbol = end_symbol;
+    } else {
+      scanner->delimiter_run = 3;
+    }
+    return true;
+  }
+
+  // a run of one or two quotes is content, but says nothing about being inside a string,
+  // so the remembered kind is left as it is
+  scanner->delimiter_run = 0;
+
   lexer->advance(lexer, false);
   lexer->mark_end(lexer);
 
   if (lexer->lookahead != delimiter) {
-    lexer->result_symbol = content_symbol;
     return true;
   }
 
@@ -35,7 +172,6 @@ bool tree_sitter_toml_external_scanner_scan_multiline_string_end(TSLexer *lexer,
 
   if (lexer->lookahead != delimiter) {
     lexer->mark_end(lexer);
-    lexer->result_symbol = content_symbol;
     return true;
   }
 
@@ -43,11 +179,14 @@ bool tree_sitter_toml_external_scanner_scan_multiline_string_end(TSLexer *lexer,
 
   if (lexer->lookahead != delimiter) {
     lexer->mark_end(lexer);
+    scanner->string = NO_STRING;
     lexer->result_symbol = end_symbol;
     return true;
   }
 
-  lexer->result_symbol = content_symbol;
+  // four or more delimiters, emit the first one as content and remember the rest of the run
+  scanner->string = kind;
+  scanner->delimiter_run = 2 + tree_sitter_toml_external_scanner_count_delimiters(lexer, delimiter);
   return true;
 }
 
@@ -56,15 +195,19 @@ bool tree_sitter_toml_external_scanner_scan(
   TSLexer *lexer,
   const bool *valid_symbols
 ) {
+  Scanner *scanner = (Scanner *)payload;
+
   if (
-    tree_sitter_toml_external_scanner_scan_multiline_string_end(lexer, valid_symbols, '"', MULTILINE_BASIC_STRING_CONTENT, MULTILINE_BASIC_STRING_END)
-    || tree_sitter_toml_external_scanner_scan_multiline_string_end(lexer, valid_symbols, '\'', MULTILINE_LITERAL_STRING_CONTENT, MULTILINE_LITERAL_STRING_END)
+    tree_sitter_toml_external_scanner_scan_multiline_string_end(scanner, lexer, valid_symbols, '"', MULTILINE_BASIC_STRING_CONTENT, MULTILINE_BASIC_STRING_END)
+    || tree_sitter_toml_external_scanner_scan_multiline_string_end(scanner, lexer, valid_symbols, '\'', MULTILINE_LITERAL_STRING_CONTENT, MULTILINE_LITERAL_STRING_END)
   ) {
     return true;
   }
 
   if (valid_symbols[LINE_ENDING_OR_EOF]) {
     lexer->result_symbol = LINE_ENDING_OR_EOF;
+    scanner->string = NO_STRING;
+    scanner->delimiter_run = 0;
 
     while (lexer->lookahead == ' ' || lexer->lookahead == '\t') {
       lexer->advance(lexer, true);
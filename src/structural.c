@@ -0,0 +1,331 @@
+#include "./structural.h"
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#define TOML_STRUCTURAL_X86 1
+#include <immintrin.h>
+#endif
+
+typedef enum {
+  TomlStructuralStatePlain,
+  TomlStructuralStateBasic,
+  TomlStructuralStateLiteral,
+  TomlStructuralStateMultilineBasic,
+  TomlStructuralStateMultilineLiteral,
+  TomlStructuralStateComment,
+} TomlStructuralState;
+
+// One bit per byte of a 64-byte block for each class of byte.
+typedef struct {
+  uint64_t double_quote;
+  uint64_t single_quote;
+  uint64_t backslash;
+  uint64_t hash;
+  uint64_t newline;
+  uint64_t operators;  // [ ] { } = ,
+} TomlStructuralMasks;
+
+typedef void (*TomlStructuralClassify)(const char *block, TomlStructuralMasks *masks);
+
+/*
+ *  Kernels
+ */
+
+static void toml_structural__classify_scalar(const char *block, TomlStructuralMasks *masks) {
+  memset(masks, 0, sizeof(TomlStructuralMasks));
+  for (unsigned i = 0; i < 64; i++) {
+    uint64_t bit = (uint64_t)1 << i;
+    switch (block[i]) {
+      case '"': masks->double_quote |= bit; break;
+      case '\'': masks->single_quote |= bit; break;
+      case '\\': masks->backslash |= bit; break;
+      case '#': masks->hash |= bit; break;
+      case '\n': masks->newline |= bit; break;
+      case '[': case ']': case '{': case '}': case '=': case ',': masks->operators |= bit; break;
+      default: break;
+    }
+  }
+}
+
+#ifdef TOML_STRUCTURAL_X86
+
+// Operators by nibble: a byte is one when the entries for its low and high
+// nibble share a bit. Bit 0 is `[ ] { }` (0x5B 0x5D 0x7B 0x7D), bit 1 is `=`
+// (0x3D) and bit 2 is `,` (0x2C).
+#define TOML_STRUCTURAL_LOW_NIBBLES 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 4, 3, 0, 0
+#define TOML_STRUCTURAL_HIGH_NIBBLES 0, 0, 4, 2, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0
+
+__attribute__((target("sse4.2")))
+static uint64_t toml_structural__sse42_eq(const __m128i chunks[4], char c) {
+  __m128i needle = _mm_set1_epi8(c);
+  uint64_t mask = 0;
+  for (unsigned i = 0; i < 4; i++) {
+    mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunks[i], needle)) << (16 * i);
+  }
+  return mask;
+}
+
+__attribute__((target("sse4.2")))
+static void toml_structural__classify_sse42(const char *block, TomlStructuralMasks *masks) {
+  const __m128i low_nibbles = _mm_setr_epi8(TOML_STRUCTURAL_LOW_NIBBLES);
+  const __m128i high_nibbles = _mm_setr_epi8(TOML_STRUCTURAL_HIGH_NIBBLES);
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  __m128i chunks[4];
+  uint64_t operators = 0;
+
+  for (unsigned i = 0; i < 4; i++) {
+    chunks[i] = _mm_loadu_si128((const __m128i *)(block + 16 * i));
+    __m128i low = _mm_shuffle_epi8(low_nibbles, _mm_and_si128(chunks[i], nibble));
+    __m128i high = _mm_shuffle_epi8(high_nibbles, _mm_and_si128(_mm_srli_epi16(chunks[i], 4), nibble));
+    __m128i is_operator = _mm_cmpeq_epi8(_mm_and_si128(low, high), _mm_setzero_si128());
+    operators |= (uint64_t)(uint16_t)~_mm_movemask_epi8(is_operator) << (16 * i);
+  }
+
+  masks->double_quote = toml_structural__sse42_eq(chunks, '"');
+  masks->single_quote = toml_structural__sse42_eq(chunks, '\'');
+  masks->backslash = toml_structural__sse42_eq(chunks, '\\');
+  masks->hash = toml_structural__sse42_eq(chunks, '#');
+  masks->newline = toml_structural__sse42_eq(chunks, '\n');
+  masks->operators = operators;
+}
+
+__attribute__((target("avx2")))
+static uint64_t toml_structural__avx2_eq(__m256i first, __m256i second, char c) {
+  __m256i needle = _mm256_set1_epi8(c);
+  uint64_t low = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(first, needle));
+  uint64_t high = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(second, needle));
+  return low | high << 32;
+}
+
+__attribute__((target("avx2")))
+static uint64_t toml_structural__avx2_operator(__m256i chunk) {
+  const __m256i low_nibbles = _mm256_setr_epi8(TOML_STRUCTURAL_LOW_NIBBLES, TOML_STRUCTURAL_LOW_NIBBLES);
+  const __m256i high_nibbles = _mm256_setr_epi8(TOML_STRUCTURAL_HIGH_NIBBLES, TOML_STRUCTURAL_HIGH_NIBBLES);
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+  __m256i low = _mm256_shuffle_epi8(low_nibbles, _mm256_and_si256(chunk, nibble));
+  __m256i high = _mm256_shuffle_epi8(high_nibbles, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble));
+  __m256i is_other = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256());
+  return (uint32_t)~_mm256_movemask_epi8(is_other);
+}
+
+__attribute__((target("avx2")))
+static void toml_structural__classify_avx2(const char *block, TomlStructuralMasks *masks) {
+  __m256i first = _mm256_loadu_si256((const __m256i *)block);
+  __m256i second = _mm256_loadu_si256((const __m256i *)(block + 32));
+
+  masks->double_quote = toml_structural__avx2_eq(first, second, '"');
+  masks->single_quote = toml_structural__avx2_eq(first, second, '\'');
+  masks->backslash = toml_structural__avx2_eq(first, second, '\\');
+  masks->hash = toml_structural__avx2_eq(first, second, '#');
+  masks->newline = toml_structural__avx2_eq(first, second, '\n');
+  masks->operators = toml_structural__avx2_operator(first) | toml_structural__avx2_operator(second) << 32;
+}
+
+#endif
+
+static const TomlStructuralClassify toml_structural__kernels[TomlStructuralKernelCount] = {
+  toml_structural__classify_scalar,
+#ifdef TOML_STRUCTURAL_X86
+  toml_structural__classify_sse42,
+  toml_structural__classify_avx2,
+#endif
+};
+
+bool toml_structural_kernel_supported(TomlStructuralKernel kernel) {
+#ifdef TOML_STRUCTURAL_X86
+  __builtin_cpu_init();
+  switch (kernel) {
+    case TomlStructuralKernelScalar: return true;
+    case TomlStructuralKernelSSE42: return __builtin_cpu_supports("sse4.2");
+    case TomlStructuralKernelAVX2: return __builtin_cpu_supports("avx2");
+    default: return false;
+  }
+#else
+  return kernel == TomlStructuralKernelScalar;
+#endif
+}
+
+TomlStructuralKernel toml_structural_best_kernel(void) {
+  if (toml_structural_kernel_supported(TomlStructuralKernelAVX2)) return TomlStructuralKernelAVX2;
+  if (toml_structural_kernel_supported(TomlStructuralKernelSSE42)) return TomlStructuralKernelSSE42;
+  return TomlStructuralKernelScalar;
+}
+
+const char *toml_structural_kernel_name(TomlStructuralKernel kernel) {
+  switch (kernel) {
+    case TomlStructuralKernelScalar: return "scalar";
+    case TomlStructuralKernelSSE42: return "sse4.2";
+    case TomlStructuralKernelAVX2: return "avx2";
+    default: return NULL;
+  }
+}
+
+/*
+ *  Masking
+ */
+
+static inline unsigned toml_structural__trailing_zeros(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return (unsigned)__builtin_ctzll(mask);
+#else
+  unsigned count = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    count++;
+  }
+  return count;
+#endif
+}
+
+// Bits `from` and above, nothing once `from` is past the block.
+static inline uint64_t toml_structural__from(unsigned from) {
+  return from < 64 ? ~(uint64_t)0 << from : 0;
+}
+
+static inline uint32_t toml_structural__emit(uint64_t bits, uint32_t base, uint32_t *positions, uint32_t count) {
+  while (bits) {
+    positions[count++] = base + toml_structural__trailing_zeros(bits);
+    bits &= bits - 1;
+  }
+  return count;
+}
+
+// Number of `quote` bytes at `offset`, up to `max`.
+static inline unsigned toml_structural__run(const TomlStructuralScanner *self, uint32_t offset, char quote, unsigned max) {
+  unsigned run = 0;
+  while (run < max && offset + run < self->length && self->source[offset + run] == quote) run++;
+  return run;
+}
+
+uint32_t toml_structural_next(TomlStructuralScanner *self, uint32_t *positions, uint32_t capacity) {
+  TomlStructuralClassify classify = toml_structural__kernels[self->kernel];
+  uint32_t count = 0;
+
+  while (self->offset < self->length && count + 64 <= capacity) {
+    uint32_t base = self->offset;
+    TomlStructuralMasks masks;
+    if (self->length - base >= 64) {
+      classify(self->source + base, &masks);
+    } else {
+      // the last block is padded with spaces, which are never structural
+      char block[64];
+      memset(block, ' ', sizeof(block));
+      memcpy(block, self->source + base, self->length - base);
+      classify(block, &masks);
+    }
+
+    unsigned at = self->skip;
+    while (at < 64) {
+      uint64_t from = toml_structural__from(at);
+      uint64_t events;
+      unsigned event;
+
+      switch (self->state) {
+        case TomlStructuralStatePlain:
+          events = (masks.double_quote | masks.single_quote | masks.hash) & from;
+          if (!events) {
+            count = toml_structural__emit((masks.operators | masks.newline) & from, base, positions, count);
+            at = 64;
+            break;
+          }
+          event = toml_structural__trailing_zeros(events);
+          count = toml_structural__emit(
+            (masks.operators | masks.newline) & from & ~toml_structural__from(event), base, positions, count
+          );
+          positions[count++] = base + event;
+
+          if (masks.hash >> event & 1) {
+            self->state = TomlStructuralStateComment;
+            at = event + 1;
+          } else {
+            char quote = self->source[base + event];
+            bool is_basic = quote == '"';
+            if (toml_structural__run(self, base + event, quote, 3) == 3) {
+              self->state = is_basic ? TomlStructuralStateMultilineBasic : TomlStructuralStateMultilineLiteral;
+              at = event + 3;
+            } else {
+              self->state = is_basic ? TomlStructuralStateBasic : TomlStructuralStateLiteral;
+              at = event + 1;
+            }
+          }
+          break;
+
+        case TomlStructuralStateBasic:
+        case TomlStructuralStateLiteral:
+          events = self->state == TomlStructuralStateBasic
+            ? (masks.double_quote | masks.backslash | masks.newline) & from
+            : (masks.single_quote | masks.newline) & from;
+          if (!events) {
+            at = 64;
+            break;
+          }
+          event = toml_structural__trailing_zeros(events);
+          if (masks.backslash >> event & 1) {
+            at = event + 2;
+          } else if (masks.newline >> event & 1) {
+            // an unterminated string ends with its line
+            self->state = TomlStructuralStatePlain;
+            at = event;
+          } else {
+            positions[count++] = base + event;
+            self->state = TomlStructuralStatePlain;
+            at = event + 1;
+          }
+          break;
+
+        case TomlStructuralStateMultilineBasic:
+        case TomlStructuralStateMultilineLiteral: {
+          bool is_basic = self->state == TomlStructuralStateMultilineBasic;
+          events = is_basic ? (masks.double_quote | masks.backslash) & from : masks.single_quote & from;
+          if (!events) {
+            at = 64;
+            break;
+          }
+          event = toml_structural__trailing_zeros(events);
+          if (masks.backslash >> event & 1) {
+            at = event + 2;
+            break;
+          }
+          // up to two quotes before the closing three are still content
+          unsigned run = toml_structural__run(self, base + event, is_basic ? '"' : '\'', 5);
+          if (run >= 3) {
+            positions[count++] = base + event + run - 3;
+            self->state = TomlStructuralStatePlain;
+          }
+          at = event + run;
+          break;
+        }
+
+        default:  // comment
+          events = masks.newline & from;
+          if (!events) {
+            at = 64;
+            break;
+          }
+          self->state = TomlStructuralStatePlain;
+          at = toml_structural__trailing_zeros(events);
+          break;
+      }
+    }
+
+    // escapes and quote runs can reach into the next block
+    self->skip = at - 64;
+    self->offset = base + 64 < self->length ? base + 64 : self->length;
+  }
+
+  return count;
+}
+
+void toml_structural_scanner_init(
+  TomlStructuralScanner *self,
+  const char *source,
+  uint32_t length,
+  TomlStructuralKernel kernel
+) {
+  self->source = source;
+  self->length = length;
+  self->offset = 0;
+  self->skip = 0;
+  self->state = TomlStructuralStatePlain;
+  self->kernel = toml_structural_kernel_supported(kernel) ? (uint8_t)kernel : TomlStructuralKernelScalar;
+}
@@ -0,0 +1,76 @@
+#ifndef TREE_SITTER_TOML_STRUCTURAL_H_
+#define TREE_SITTER_TOML_STRUCTURAL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ *  Structural index.
+ *
+ *  Finds the bytes that give a document its shape without lexing it: the
+ *  brackets, braces, `=`, `,`, `#` and newlines outside strings and comments,
+ *  and the quotes that open and close strings (the first byte of `"""` and
+ *  `'''`). The source is classified 64 bytes at a time into bitmasks by a
+ *  scalar, SSE4.2 or AVX2 kernel. Strings and comments are then masked by
+ *  stepping only over the quotes, backslashes, `#` and newlines those masks
+ *  hold, so a block in the middle of a string or of plain values costs a few
+ *  mask operations.
+ *
+ *  The index is for fast whole-document passes that only need the shape,
+ *  like finding where to split a document. It does not validate: broken
+ *  documents get an index that is wrong where they are broken.
+ */
+
+typedef enum {
+  TomlStructuralKernelScalar,
+  TomlStructuralKernelSSE42,
+  TomlStructuralKernelAVX2,
+  TomlStructuralKernelCount,
+} TomlStructuralKernel;
+
+/**
+ * Scans a source in steps. Initialize with `toml_structural_scanner_init`;
+ * the fields are private.
+ */
+typedef struct {
+  const char *source;
+  uint32_t length;
+  uint32_t offset;
+  uint32_t skip;
+  uint8_t state;
+  uint8_t kernel;
+} TomlStructuralScanner;
+
+/**
+ * The fastest kernel the CPU running this supports.
+ */
+TomlStructuralKernel toml_structural_best_kernel(void);
+
+bool toml_structural_kernel_supported(TomlStructuralKernel kernel);
+
+const char *toml_structural_kernel_name(TomlStructuralKernel kernel);
+
+void toml_structural_scanner_init(
+  TomlStructuralScanner *self,
+  const char *source,
+  uint32_t length,
+  TomlStructuralKernel kernel
+);
+
+/**
+ * Index the next bytes of the source, writing the offsets of their
+ * structural bytes to `positions` in order and returning how many there
+ * are. `capacity` must be at least 64; about that many bytes are scanned per
+ * call. Returns 0 only once the whole source has been scanned.
+ */
+uint32_t toml_structural_next(TomlStructuralScanner *self, uint32_t *positions, uint32_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_STRUCTURAL_H_
@@ -0,0 +1,165 @@
+#ifndef TREE_SITTER_TOML_SYNTAX_H_
+#define TREE_SITTER_TOML_SYNTAX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "./value.h"
+#include <stdlib.h>
+#include <string.h>
+#include <tree_sitter/api.h>
+
+/*
+ *  Helpers shared by the modules that walk a tree of `tree_sitter_toml()`.
+ *  Internal, not part of any public header.
+ */
+
+// Returns the innermost node on the first path of nodes with errors below `node`,
+// which is where a "syntax error" is reported.
+static inline TSNode toml_syntax_first_error(TSNode node) {
+  for (;;) {
+    uint32_t count = ts_node_child_count(node);
+    uint32_t i = 0;
+    for (; i < count; i++) {
+      TSNode child = ts_node_child(node, i);
+      if (ts_node_has_error(child)) {
+        node = child;
+        break;
+      }
+    }
+    if (i == count) return node;
+  }
+}
+
+// The symbols the walks tell nodes apart by, looked up once per tree.
+typedef struct {
+  TSSymbol comment;
+  TSSymbol pair;
+  TSSymbol table;
+  TSSymbol table_array_element;
+  TSSymbol bare_key;
+  TSSymbol string;
+  TSSymbol integer;
+  TSSymbol float_;
+  TSSymbol boolean;
+  TSSymbol offset_date_time;
+  TSSymbol local_date_time;
+  TSSymbol local_date;
+  TSSymbol local_time;
+  TSSymbol array;
+  TSSymbol inline_table;
+} TomlSyntaxSymbols;
+
+static inline TSSymbol toml_syntax_symbol(const TSLanguage *language, const char *name) {
+  return ts_language_symbol_for_name(language, name, (uint32_t)strlen(name), true);
+}
+
+static inline void toml_syntax_init_symbols(TomlSyntaxSymbols *self, const TSLanguage *language) {
+  self->comment = toml_syntax_symbol(language, "comment");
+  self->pair = toml_syntax_symbol(language, "pair");
+  self->table = toml_syntax_symbol(language, "table");
+  self->table_array_element = toml_syntax_symbol(language, "table_array_element");
+  self->bare_key = toml_syntax_symbol(language, "bare_key");
+  self->string = toml_syntax_symbol(language, "string");
+  self->integer = toml_syntax_symbol(language, "integer");
+  self->float_ = toml_syntax_symbol(language, "float");
+  self->boolean = toml_syntax_symbol(language, "boolean");
+  self->offset_date_time = toml_syntax_symbol(language, "offset_date_time");
+  self->local_date_time = toml_syntax_symbol(language, "local_date_time");
+  self->local_date = toml_syntax_symbol(language, "local_date");
+  self->local_time = toml_syntax_symbol(language, "local_time");
+  self->array = toml_syntax_symbol(language, "array");
+  self->inline_table = toml_syntax_symbol(language, "inline_table");
+}
+
+static inline bool toml_syntax_is_comment(const TomlSyntaxSymbols *symbols, TSNode node) {
+  return ts_node_symbol(node) == symbols->comment;
+}
+
+// A buffer for decoded text, reused from one decode to the next.
+typedef struct {
+  char *data;
+  uint32_t capacity;
+} TomlSyntaxScratch;
+
+static inline bool toml_syntax_reserve(TomlSyntaxScratch *self, uint32_t size) {
+  if (size <= self->capacity) return true;
+  uint32_t capacity = self->capacity ? self->capacity : 256;
+  while (capacity < size) capacity *= 2;
+  char *data = realloc(self->data, capacity);
+  if (!data) return false;
+  self->data = data;
+  self->capacity = capacity;
+  return true;
+}
+
+// Whether `text` lives in the scratch buffer, and so only until its next use.
+static inline bool toml_syntax_in_scratch(const TomlSyntaxScratch *self, TomlString text) {
+  return text.length && text.data >= self->data && text.data < self->data + self->capacity;
+}
+
+static inline void toml_syntax_free_scratch(TomlSyntaxScratch *self) {
+  free(self->data);
+  self->data = NULL;
+  self->capacity = 0;
+}
+
+typedef enum {
+  TomlSyntaxDecoded,
+  TomlSyntaxOutOfMemory,
+  TomlSyntaxInvalidEscape,
+} TomlSyntaxDecodeResult;
+
+// The error to report for a failed decode, or NULL.
+static inline const char *toml_syntax_message(TomlSyntaxDecodeResult result) {
+  switch (result) {
+    case TomlSyntaxDecoded:
+      return NULL;
+    case TomlSyntaxOutOfMemory:
+      return "out of memory";
+    case TomlSyntaxInvalidEscape:
+      return "invalid escape sequence";
+  }
+  return NULL;
+}
+
+// Decodes the text of a `string` or `quoted_key` node, as a view of `source`
+// when it has no escapes and into `scratch` otherwise.
+static inline TomlSyntaxDecodeResult toml_syntax_string(
+  const char *source,
+  TSNode node,
+  TomlSyntaxScratch *scratch,
+  TomlString *text
+) {
+  const char *start = source + ts_node_start_byte(node);
+  uint32_t length = ts_node_end_byte(node) - ts_node_start_byte(node);
+  if (toml_decode_string_view(start, length, text)) return TomlSyntaxDecoded;
+
+  if (!toml_syntax_reserve(scratch, length)) return TomlSyntaxOutOfMemory;
+  if (!toml_decode_string(start, length, scratch->data, &text->length)) return TomlSyntaxInvalidEscape;
+  text->data = scratch->data;
+  return TomlSyntaxDecoded;
+}
+
+// Decodes a key segment, a `bare_key` or a `quoted_key` node, like
+// `toml_syntax_string`. A key with an invalid escape is an error to every
+// module, never kept as its raw text.
+static inline TomlSyntaxDecodeResult toml_syntax_key_segment(
+  const TomlSyntaxSymbols *symbols,
+  const char *source,
+  TSNode node,
+  TomlSyntaxScratch *scratch,
+  TomlString *key
+) {
+  if (ts_node_symbol(node) != symbols->bare_key) return toml_syntax_string(source, node, scratch, key);
+  key->data = source + ts_node_start_byte(node);
+  key->length = ts_node_end_byte(node) - ts_node_start_byte(node);
+  return TomlSyntaxDecoded;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_SYNTAX_H_
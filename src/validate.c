@@ -0,0 +1,354 @@
+#include "./validate.h"
+#include "./arena.h"
+#include "./keys.h"
+#include "./syntax.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TOML_VALIDATOR_INITIAL_SLOT_COUNT 64
+
+typedef struct TomlKey TomlKey;
+
+// A node of the key trie, identified by its parent and its key.
+struct TomlKey {
+  TomlKey *parent;
+  TomlKey *last_element;  // arrays of tables only, the table of the last `[[header]]`
+  TomlString key;
+  uint32_t hash;
+  uint8_t state;  // `TomlKeyState`
+};
+
+struct TomlValidator {
+  // open addressing index of the trie, by parent and key
+  TomlKey **slots;
+  uint32_t slot_count;
+  uint32_t slot_used;
+
+  // decoded quoted keys that contain escapes
+  TomlSyntaxScratch scratch;
+
+  TomlArena *arena;
+  const char *source;
+  TomlSyntaxSymbols symbols;
+  TomlError *errors;
+  uint32_t capacity;
+  uint32_t count;
+  bool out_of_memory;
+};
+
+static void toml_validator__error(TomlValidator *self, TSNode node, const char *message) {
+  if (self->count < self->capacity) {
+    TomlError *error = &self->errors[self->count];
+    error->message = message;
+    error->start_byte = ts_node_start_byte(node);
+    error->end_byte = ts_node_end_byte(node);
+  }
+  self->count++;
+}
+
+static void toml_validator__out_of_memory(TomlValidator *self, TSNode node) {
+  if (!self->out_of_memory) toml_validator__error(self, node, "out of memory");
+  self->out_of_memory = true;
+}
+
+/*
+ *  Trie
+ */
+
+static uint32_t toml_validator__hash(const TomlKey *parent, TomlString key) {
+  uint32_t hash = 2166136261u ^ (uint32_t)((uintptr_t)parent >> 4);
+  for (uint32_t i = 0; i < key.length; i++) {
+    hash = (hash ^ (unsigned char)key.data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static bool toml_validator__grow_slots(TomlValidator *self) {
+  uint32_t slot_count = self->slot_count ? self->slot_count * 2 : TOML_VALIDATOR_INITIAL_SLOT_COUNT;
+  TomlKey **slots = calloc(slot_count, sizeof(TomlKey *));
+  if (!slots) return false;
+
+  for (uint32_t i = 0; i < self->slot_count; i++) {
+    TomlKey *key = self->slots[i];
+    if (!key) continue;
+    uint32_t j = key->hash & (slot_count - 1);
+    while (slots[j]) j = (j + 1) & (slot_count - 1);
+    slots[j] = key;
+  }
+
+  free(self->slots);
+  self->slots = slots;
+  self->slot_count = slot_count;
+  return true;
+}
+
+// Returns the slot that holds `key` under `parent`, or the empty slot it belongs in.
+static TomlKey **toml_validator__slot(TomlValidator *self, const TomlKey *parent, TomlString key, uint32_t hash) {
+  uint32_t i = hash & (self->slot_count - 1);
+  for (TomlKey *entry; (entry = self->slots[i]); i = (i + 1) & (self->slot_count - 1)) {
+    if (
+      entry->hash == hash && entry->parent == parent && entry->key.length == key.length
+      && memcmp(entry->key.data, key.data, key.length) == 0
+    ) {
+      break;
+    }
+  }
+  return &self->slots[i];
+}
+
+static TomlKey *toml_validator__find(TomlValidator *self, const TomlKey *parent, TomlString key) {
+  if (!self->slot_count) return NULL;
+  return *toml_validator__slot(self, parent, key, toml_validator__hash(parent, key));
+}
+
+// Creates a trie node, and indexes it when it has a parent.
+static TomlKey *toml_validator__insert(TomlValidator *self, TomlKey *parent, TomlString key, TomlKeyState state, TSNode node) {
+  if ((self->slot_used + 1) * 2 > self->slot_count && !toml_validator__grow_slots(self)) {
+    toml_validator__out_of_memory(self, node);
+    return NULL;
+  }
+
+  // keys decoded into the scratch buffer would be overwritten by the next key
+  if (toml_syntax_in_scratch(&self->scratch, key)) {
+    char *copy = toml_arena_alloc(self->arena, key.length);
+    if (!copy) {
+      toml_validator__out_of_memory(self, node);
+      return NULL;
+    }
+    memcpy(copy, key.data, key.length);
+    key.data = copy;
+  }
+
+  TomlKey *entry = toml_arena_alloc(self->arena, sizeof(TomlKey));
+  if (!entry) {
+    toml_validator__out_of_memory(self, node);
+    return NULL;
+  }
+  memset(entry, 0, sizeof(TomlKey));
+  entry->parent = parent;
+  entry->key = key;
+  entry->state = (uint8_t)state;
+
+  if (parent) {
+    entry->hash = toml_validator__hash(parent, key);
+    *toml_validator__slot(self, parent, key, entry->hash) = entry;
+    self->slot_used++;
+  }
+  return entry;
+}
+
+/*
+ *  Checks
+ */
+
+static bool toml_validator__key_segment(TomlValidator *self, TSNode node, TomlString *result) {
+  TomlSyntaxDecodeResult decoded = toml_syntax_key_segment(&self->symbols, self->source, node, &self->scratch, result);
+  if (decoded == TomlSyntaxOutOfMemory) {
+    toml_validator__out_of_memory(self, node);
+  } else if (decoded != TomlSyntaxDecoded) {
+    toml_validator__error(self, node, toml_syntax_message(decoded));
+  }
+  return decoded == TomlSyntaxDecoded;
+}
+
+// Reports the error, if any, of defining `key` once more.
+static bool toml_validator__define(TomlValidator *self, TomlKey *key, TomlKeyDefinition definition, TSNode node) {
+  TomlKeyState state = key->state;
+  const char *message = toml_keys_define(&state, definition);
+  if (message) {
+    toml_validator__error(self, node, message);
+    return false;
+  }
+  key->state = (uint8_t)state;
+  return true;
+}
+
+// Returns the table that `key` names inside `table`, creating it when missing.
+static TomlKey *toml_validator__descend(TomlValidator *self, TomlKey *table, TomlString key, TSNode node, bool dotted) {
+  TomlKey *child = toml_validator__find(self, table, key);
+  if (!child) return toml_validator__insert(self, table, key, dotted ? TomlKeyStateDotted : TomlKeyStateImplicit, node);
+
+  if (!toml_validator__define(self, child, dotted ? TomlKeyDefinitionDotted : TomlKeyDefinitionImplicit, node)) return NULL;
+  return child->state == TomlKeyStateArray ? child->last_element : child;
+}
+
+// Walks the segments of a `key` node, descending into all but the last one.
+static TomlKey *toml_validator__key(TomlValidator *self, TomlKey *table, TSNode node, bool dotted, TomlString *name, TSNode *name_node) {
+  uint32_t count = ts_node_named_child_count(node);
+  bool has_name = false;
+
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode segment = ts_node_named_child(node, i);
+    if (toml_syntax_is_comment(&self->symbols, segment)) continue;
+    if (has_name) {
+      table = toml_validator__descend(self, table, *name, *name_node, dotted);
+      if (!table) return NULL;
+    }
+    if (!toml_validator__key_segment(self, segment, name)) return NULL;
+    *name_node = segment;
+    has_name = true;
+  }
+
+  return table;
+}
+
+static void toml_validator__pair(TomlValidator *self, TomlKey *table, TSNode node);
+
+// Checks the inline tables of a value, which own the keys inside their braces.
+static void toml_validator__value(TomlValidator *self, TomlKey *key, TSNode node) {
+  TSSymbol symbol = ts_node_symbol(node);
+
+  if (symbol == self->symbols.inline_table) {
+    if (!key) key = toml_validator__insert(self, NULL, (TomlString) {NULL, 0}, TomlKeyStateInline, node);
+    if (!key) return;
+
+    uint32_t count = ts_node_named_child_count(node);
+    for (uint32_t i = 0; i < count && !self->out_of_memory; i++) {
+      TSNode child = ts_node_named_child(node, i);
+      if (ts_node_symbol(child) == self->symbols.pair) toml_validator__pair(self, key, child);
+    }
+  } else if (symbol == self->symbols.array) {
+    uint32_t count = ts_node_named_child_count(node);
+    for (uint32_t i = 0; i < count && !self->out_of_memory; i++) {
+      TSNode item = ts_node_named_child(node, i);
+      if (!toml_syntax_is_comment(&self->symbols, item)) toml_validator__value(self, NULL, item);
+    }
+  }
+}
+
+static void toml_validator__pair(TomlValidator *self, TomlKey *table, TSNode node) {
+  TSNode key = ts_node_named_child(node, 0);
+  TSNode value = ts_node_next_named_sibling(key);
+  while (!ts_node_is_null(value) && toml_syntax_is_comment(&self->symbols, value)) {
+    value = ts_node_next_named_sibling(value);
+  }
+
+  TomlString name;
+  TSNode name_node;
+  table = toml_validator__key(self, table, key, true, &name, &name_node);
+  if (!table) return;
+
+  TomlKeyDefinition definition = ts_node_symbol(value) == self->symbols.inline_table
+    ? TomlKeyDefinitionInline
+    : TomlKeyDefinitionValue;
+  TomlKey *existing = toml_validator__find(self, table, name);
+  if (existing) {
+    toml_validator__define(self, existing, definition, name_node);
+    return;
+  }
+
+  TomlKeyState state = TomlKeyStateNone;
+  toml_keys_define(&state, definition);
+  TomlKey *entry = toml_validator__insert(self, table, name, state, name_node);
+  if (entry) toml_validator__value(self, entry, value);
+}
+
+// Resolves the `[header]` or `[[header]]` of a section to the table its pairs belong to.
+static TomlKey *toml_validator__header(TomlValidator *self, TomlKey *root, TSNode header, bool is_array) {
+  TSNode key = ts_node_named_child(header, 0);
+  TomlString name;
+  TSNode name_node;
+  TomlKey *parent = toml_validator__key(self, root, key, false, &name, &name_node);
+  if (!parent) return NULL;
+
+  TomlKey *existing = toml_validator__find(self, parent, name);
+  TomlKeyDefinition definition = is_array ? TomlKeyDefinitionElement : TomlKeyDefinitionHeader;
+  if (existing && !toml_validator__define(self, existing, definition, key)) return NULL;
+
+  if (!is_array) {
+    return existing ? existing : toml_validator__insert(self, parent, name, TomlKeyStateHeader, key);
+  }
+
+  TomlKey *array = existing;
+  if (!array) {
+    array = toml_validator__insert(self, parent, name, TomlKeyStateArray, key);
+    if (!array) return NULL;
+  }
+
+  // each element is a fresh parent, so its keys never meet the previous element's
+  TomlKey *table = toml_validator__insert(self, NULL, (TomlString) {NULL, 0}, TomlKeyStateHeader, key);
+  if (!table) return NULL;
+  array->last_element = table;
+  return table;
+}
+
+static void toml_validator__section(TomlValidator *self, TomlKey *root, TSNode node, bool is_array) {
+  uint32_t count = ts_node_named_child_count(node);
+  TomlKey *table = toml_validator__header(self, root, ts_node_named_child(node, 0), is_array);
+
+  // the pairs of a section whose header is wrong have nowhere to go
+  if (!table) return;
+
+  for (uint32_t i = 1; i < count && !self->out_of_memory; i++) {
+    TSNode child = ts_node_named_child(node, i);
+    if (ts_node_symbol(child) == self->symbols.pair) toml_validator__pair(self, table, child);
+  }
+}
+
+/*
+ *  Public
+ */
+
+TomlValidator *toml_validator_new(void) {
+  return calloc(1, sizeof(TomlValidator));
+}
+
+void toml_validator_delete(TomlValidator *self) {
+  if (!self) return;
+  free(self->slots);
+  toml_syntax_free_scratch(&self->scratch);
+  toml_arena_delete(self->arena);
+  free(self);
+}
+
+uint32_t toml_validator_check(
+  TomlValidator *self,
+  const TSTree *tree,
+  const char *source,
+  TomlError *errors,
+  uint32_t capacity
+) {
+  TSNode document = ts_tree_root_node(tree);
+  self->source = source;
+  self->errors = errors;
+  self->capacity = capacity;
+  self->count = 0;
+  self->out_of_memory = false;
+
+  if (ts_node_has_error(document)) {
+    toml_validator__error(self, toml_syntax_first_error(document), "syntax error");
+    return self->count;
+  }
+
+  // about one trie node per key, and keys take a few bytes of source each;
+  // the arena of the last document is reused, its largest block kept
+  if (self->arena) {
+    toml_arena_reset(self->arena);
+  } else {
+    self->arena = toml_arena_new(ts_node_end_byte(document) / 4 + 1024);
+    if (!self->arena) {
+      toml_validator__out_of_memory(self, document);
+      return self->count;
+    }
+  }
+  if (self->slots) memset(self->slots, 0, self->slot_count * sizeof(TomlKey *));
+  self->slot_used = 0;
+  toml_syntax_init_symbols(&self->symbols, ts_tree_language(tree));
+
+  TomlKey *root = toml_validator__insert(self, NULL, (TomlString) {NULL, 0}, TomlKeyStateImplicit, document);
+  const TomlSyntaxSymbols *symbols = &self->symbols;
+  uint32_t count = ts_node_named_child_count(document);
+  for (uint32_t i = 0; i < count && root && !self->out_of_memory; i++) {
+    TSNode child = ts_node_named_child(document, i);
+    TSSymbol symbol = ts_node_symbol(child);
+    if (symbol == symbols->pair) {
+      toml_validator__pair(self, root, child);
+    } else if (symbol == symbols->table) {
+      toml_validator__section(self, root, child, false);
+    } else if (symbol == symbols->table_array_element) {
+      toml_validator__section(self, root, child, true);
+    }
+  }
+
+  return self->count;
+}
@@ -0,0 +1,53 @@
+#ifndef TREE_SITTER_TOML_VALIDATE_H_
+#define TREE_SITTER_TOML_VALIDATE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "./value.h"
+
+/*
+ *  Semantic validation.
+ *
+ *  The grammar accepts documents that TOML forbids: keys defined twice,
+ *  `[tables]` opened twice, `[[arrays]]` appended to a static array, and
+ *  dotted keys or headers that reach into inline tables or into tables of
+ *  other kinds. A `TomlValidator` finds these without decoding any value,
+ *  with the same rules and messages as `toml_document_new`, but it keeps
+ *  going after the first error so that an editor can show all of them.
+ *
+ *  Keys live in a trie whose nodes are found through one hash table keyed
+ *  by the parent node and the key, so each key segment costs one lookup no
+ *  matter how deep it is.
+ */
+
+typedef struct TomlValidator TomlValidator;
+
+/**
+ * Create a validator. It keeps its memory between documents, so checking a
+ * document again after each edit allocates next to nothing.
+ */
+TomlValidator *toml_validator_new(void);
+
+void toml_validator_delete(TomlValidator *self);
+
+/**
+ * Check the tree of `source`, writing up to `capacity` errors to `errors` in
+ * the order they are found and returning how many were found in total. A
+ * tree with syntax errors gets one error for the first of them and no
+ * semantic checks.
+ */
+uint32_t toml_validator_check(
+  TomlValidator *self,
+  const TSTree *tree,
+  const char *source,
+  TomlError *errors,
+  uint32_t capacity
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_VALIDATE_H_
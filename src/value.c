@@ -0,0 +1,525 @@
+#include "./value.h"
+#include "./arena.h"
+#include "./keys.h"
+#include "./syntax.h"
+#include <string.h>
+
+// entry capacity from which a table gets a hash index
+#define TOML_TABLE_INDEX_THRESHOLD 16
+
+struct TomlDocument {
+  TomlArena *arena;
+  TomlValue *root;
+};
+
+typedef struct {
+  TomlArena *arena;
+  TomlValue *root;
+  const char *source;
+  TomlSyntaxSymbols symbols;
+  TomlError *error;
+} TomlDecoder;
+
+struct TomlValueDecoder {
+  TomlDecoder decoder;
+};
+
+/*
+ *  Storage
+ */
+
+static TomlValue *toml_value__new(TomlArena *arena, TomlValueType type, TSNode node) {
+  TomlValue *self = toml_arena_alloc(arena, sizeof(TomlValue));
+  if (!self) return NULL;
+  memset(self, 0, sizeof(TomlValue));
+  self->type = type;
+  self->start_byte = ts_node_start_byte(node);
+  self->end_byte = ts_node_end_byte(node);
+  return self;
+}
+
+static uint32_t toml_table__hash(TomlString key) {
+  uint32_t hash = 2166136261u;
+  for (uint32_t i = 0; i < key.length; i++) {
+    hash = (hash ^ (uint8_t)key.data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static bool toml_table__matches(const TomlEntry *entry, TomlString key, uint32_t hash) {
+  return entry->hash == hash && entry->key.length == key.length && memcmp(entry->key.data, key.data, key.length) == 0;
+}
+
+static TomlValue *toml_table__find(const TomlValue *self, TomlString key) {
+  uint32_t hash = toml_table__hash(key);
+
+  // small tables, which are most of them, are cheaper to scan than to index
+  if (!self->as.table.slot_count) {
+    for (uint32_t i = 0; i < self->as.table.count; i++) {
+      const TomlEntry *entry = &self->as.table.entries[i];
+      if (toml_table__matches(entry, key, hash)) return entry->value;
+    }
+    return NULL;
+  }
+
+  uint32_t mask = self->as.table.slot_count - 1;
+  for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+    uint32_t slot = self->as.table.slots[i];
+    if (!slot) return NULL;
+    const TomlEntry *entry = &self->as.table.entries[slot - 1];
+    if (toml_table__matches(entry, key, hash)) return entry->value;
+  }
+}
+
+static void toml_table__index(TomlValue *self, uint32_t entry) {
+  uint32_t mask = self->as.table.slot_count - 1;
+  uint32_t i = self->as.table.entries[entry].hash & mask;
+  while (self->as.table.slots[i]) i = (i + 1) & mask;
+  self->as.table.slots[i] = entry + 1;
+}
+
+// Rebuilds the hash index with twice the slots of the entry capacity.
+static bool toml_table__grow_slots(TomlArena *arena, TomlValue *self) {
+  uint32_t slot_count = self->as.table.capacity * 2;
+  uint32_t *slots = toml_arena_alloc(arena, slot_count * sizeof(uint32_t));
+  if (!slots) return false;
+  memset(slots, 0, slot_count * sizeof(uint32_t));
+
+  self->as.table.slots = slots;
+  self->as.table.slot_count = slot_count;
+  for (uint32_t i = 0; i < self->as.table.count; i++) {
+    toml_table__index(self, i);
+  }
+  return true;
+}
+
+static bool toml_table__put(TomlArena *arena, TomlValue *self, TomlString key, TomlValue *value) {
+  if (self->as.table.count == self->as.table.capacity) {
+    uint32_t capacity = self->as.table.capacity ? self->as.table.capacity * 2 : 4;
+    TomlEntry *entries = toml_arena_realloc(
+      arena,
+      self->as.table.entries,
+      self->as.table.capacity * sizeof(TomlEntry),
+      capacity * sizeof(TomlEntry)
+    );
+    if (!entries) return false;
+    self->as.table.entries = entries;
+    self->as.table.capacity = capacity;
+    if (capacity >= TOML_TABLE_INDEX_THRESHOLD && !toml_table__grow_slots(arena, self)) return false;
+  }
+  uint32_t index = self->as.table.count++;
+  TomlEntry *entry = &self->as.table.entries[index];
+  entry->key = key;
+  entry->hash = toml_table__hash(key);
+  entry->value = value;
+  if (self->as.table.slot_count) toml_table__index(self, index);
+  return true;
+}
+
+static bool toml_array__push(TomlArena *arena, TomlValue *self, TomlValue *value) {
+  if (self->as.array.count == self->as.array.capacity) {
+    uint32_t capacity = self->as.array.capacity ? self->as.array.capacity * 2 : 4;
+    TomlValue **items = toml_arena_realloc(
+      arena,
+      self->as.array.items,
+      self->as.array.capacity * sizeof(TomlValue *),
+      capacity * sizeof(TomlValue *)
+    );
+    if (!items) return false;
+    self->as.array.items = items;
+    self->as.array.capacity = capacity;
+  }
+  self->as.array.items[self->as.array.count++] = value;
+  return true;
+}
+
+/*
+ *  Scalars
+ */
+
+static bool toml_decoder__fail(TomlDecoder *self, TSNode node, const char *message) {
+  if (self->error) {
+    self->error->message = message;
+    self->error->start_byte = ts_node_start_byte(node);
+    self->error->end_byte = ts_node_end_byte(node);
+  }
+  return false;
+}
+
+// Decodes the text of a `string` or `quoted_key` node, quotes included.
+static bool toml_decoder__string(TomlDecoder *self, TSNode node, TomlString *result) {
+  const char *text = self->source + ts_node_start_byte(node);
+  uint32_t length = ts_node_end_byte(node) - ts_node_start_byte(node);
+
+  char *output = toml_arena_alloc(self->arena, length);
+  if (!output) return toml_decoder__fail(self, node, "out of memory");
+
+  uint32_t output_length;
+  if (!toml_decode_string(text, length, output, &output_length)) {
+    return toml_decoder__fail(self, node, "invalid escape sequence");
+  }
+
+  toml_arena_realloc(self->arena, output, length, output_length);
+  result->data = output;
+  result->length = output_length;
+  return true;
+}
+
+/*
+ *  Tables and arrays
+ */
+
+static bool toml_decoder__key_segment(TomlDecoder *self, TSNode node, TomlString *result) {
+  if (ts_node_symbol(node) != self->symbols.bare_key) {
+    return toml_decoder__string(self, node, result);
+  }
+
+  uint32_t length = ts_node_end_byte(node) - ts_node_start_byte(node);
+  char *output = toml_arena_alloc(self->arena, length);
+  if (!output) return toml_decoder__fail(self, node, "out of memory");
+  memcpy(output, self->source + ts_node_start_byte(node), length);
+  result->data = output;
+  result->length = length;
+  return true;
+}
+
+// Returns the state of the rules of keys.h that a value has reached.
+static TomlKeyState toml_decoder__key_state(const TomlValue *value) {
+  if (value->type == TomlValueTypeArray && (value->flags & TomlValueFlagTableArray)) return TomlKeyStateArray;
+  if (value->type != TomlValueTypeTable) return TomlKeyStateValue;
+  if (value->flags & TomlValueFlagInline) return TomlKeyStateInline;
+  if (value->flags & TomlValueFlagDefined) return TomlKeyStateHeader;
+  if (value->flags & TomlValueFlagDotted) return TomlKeyStateDotted;
+  return TomlKeyStateImplicit;
+}
+
+// Fails with the error, if any, of defining `existing` once more.
+static bool toml_decoder__define(TomlDecoder *self, const TomlValue *existing, TomlKeyDefinition definition, TSNode node) {
+  TomlKeyState state = toml_decoder__key_state(existing);
+  const char *message = toml_keys_define(&state, definition);
+  return !message || toml_decoder__fail(self, node, message);
+}
+
+// Returns the table that `key` names inside `table`, creating it when missing.
+static TomlValue *toml_decoder__descend(TomlDecoder *self, TomlValue *table, TomlString key, TSNode node, bool dotted) {
+  TomlValue *child = toml_table__find(table, key);
+
+  if (!child) {
+    child = toml_value__new(self->arena, TomlValueTypeTable, node);
+    if (!child || !toml_table__put(self->arena, table, key, child)) {
+      toml_decoder__fail(self, node, "out of memory");
+      return NULL;
+    }
+    if (dotted) child->flags |= TomlValueFlagDotted;
+    return child;
+  }
+
+  if (!toml_decoder__define(self, child, dotted ? TomlKeyDefinitionDotted : TomlKeyDefinitionImplicit, node)) return NULL;
+  if (child->type == TomlValueTypeArray) return child->as.array.items[child->as.array.count - 1];
+  return child;
+}
+
+static TomlValue *toml_decoder__value(TomlDecoder *self, TSNode node);
+static bool toml_decoder__pair(TomlDecoder *self, TomlValue *table, TSNode node);
+
+static TomlValue *toml_decoder__scalar(TomlDecoder *self, TSNode node, TomlValueType type) {
+  TomlValue *value = toml_value__new(self->arena, type, node);
+  if (!value) {
+    toml_decoder__fail(self, node, "out of memory");
+    return NULL;
+  }
+
+  const char *text = self->source + value->start_byte;
+  uint32_t length = value->end_byte - value->start_byte;
+  bool ok = true;
+
+  switch (type) {
+    case TomlValueTypeString:
+      ok = toml_decoder__string(self, node, &value->as.string);
+      break;
+    case TomlValueTypeInteger:
+      ok = toml_decode_integer(text, length, &value->as.integer)
+        || toml_decoder__fail(self, node, "integer out of range");
+      break;
+    case TomlValueTypeFloat:
+      ok = toml_decode_float(text, length, &value->as.floating)
+        || toml_decoder__fail(self, node, "invalid float");
+      break;
+    case TomlValueTypeBoolean:
+      value->as.boolean = text[0] == 't';
+      break;
+    default:
+      ok = toml_decode_datetime(text, length, type, &value->as.datetime)
+        || toml_decoder__fail(self, node, "invalid date");
+      break;
+  }
+
+  return ok ? value : NULL;
+}
+
+static TomlValue *toml_decoder__array(TomlDecoder *self, TSNode node) {
+  TomlValue *array = toml_value__new(self->arena, TomlValueTypeArray, node);
+  if (!array) {
+    toml_decoder__fail(self, node, "out of memory");
+    return NULL;
+  }
+  array->flags |= TomlValueFlagInline;
+
+  uint32_t count = ts_node_named_child_count(node);
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode child = ts_node_named_child(node, i);
+    if (toml_syntax_is_comment(&self->symbols, child)) continue;
+    TomlValue *item = toml_decoder__value(self, child);
+    if (!item) return NULL;
+    if (!toml_array__push(self->arena, array, item)) {
+      toml_decoder__fail(self, node, "out of memory");
+      return NULL;
+    }
+  }
+  return array;
+}
+
+static TomlValue *toml_decoder__inline_table(TomlDecoder *self, TSNode node) {
+  TomlValue *table = toml_value__new(self->arena, TomlValueTypeTable, node);
+  if (!table) {
+    toml_decoder__fail(self, node, "out of memory");
+    return NULL;
+  }
+
+  uint32_t count = ts_node_named_child_count(node);
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode child = ts_node_named_child(node, i);
+    if (toml_syntax_is_comment(&self->symbols, child)) continue;
+    if (!toml_decoder__pair(self, table, child)) return NULL;
+  }
+
+  // sealed only once complete, dotted keys inside the braces may still extend it
+  table->flags |= TomlValueFlagInline;
+  return table;
+}
+
+static TomlValue *toml_decoder__value(TomlDecoder *self, TSNode node) {
+  const TomlSyntaxSymbols *symbols = &self->symbols;
+  TSSymbol symbol = ts_node_symbol(node);
+
+  if (symbol == symbols->string) return toml_decoder__scalar(self, node, TomlValueTypeString);
+  if (symbol == symbols->integer) return toml_decoder__scalar(self, node, TomlValueTypeInteger);
+  if (symbol == symbols->float_) return toml_decoder__scalar(self, node, TomlValueTypeFloat);
+  if (symbol == symbols->boolean) return toml_decoder__scalar(self, node, TomlValueTypeBoolean);
+  if (symbol == symbols->offset_date_time) return toml_decoder__scalar(self, node, TomlValueTypeOffsetDateTime);
+  if (symbol == symbols->local_date_time) return toml_decoder__scalar(self, node, TomlValueTypeLocalDateTime);
+  if (symbol == symbols->local_date) return toml_decoder__scalar(self, node, TomlValueTypeLocalDate);
+  if (symbol == symbols->local_time) return toml_decoder__scalar(self, node, TomlValueTypeLocalTime);
+  if (symbol == symbols->array) return toml_decoder__array(self, node);
+  if (symbol == symbols->inline_table) return toml_decoder__inline_table(self, node);
+
+  toml_decoder__fail(self, node, "unexpected node");
+  return NULL;
+}
+
+// Walks the segments of a `key` node, descending into all but the last one.
+static TomlValue *toml_decoder__key(TomlDecoder *self, TomlValue *table, TSNode node, bool dotted, TomlString *name, TSNode *name_node) {
+  uint32_t count = ts_node_named_child_count(node);
+  bool has_name = false;
+
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode segment = ts_node_named_child(node, i);
+    if (toml_syntax_is_comment(&self->symbols, segment)) continue;
+    if (has_name) {
+      table = toml_decoder__descend(self, table, *name, *name_node, dotted);
+      if (!table) return NULL;
+    }
+    if (!toml_decoder__key_segment(self, segment, name)) return NULL;
+    *name_node = segment;
+    has_name = true;
+  }
+
+  return table;
+}
+
+static bool toml_decoder__pair(TomlDecoder *self, TomlValue *table, TSNode node) {
+  TSNode key = ts_node_named_child(node, 0);
+  TSNode value_node = ts_node_next_named_sibling(key);
+  while (!ts_node_is_null(value_node) && toml_syntax_is_comment(&self->symbols, value_node)) {
+    value_node = ts_node_next_named_sibling(value_node);
+  }
+
+  TomlString name;
+  TSNode name_node;
+  table = toml_decoder__key(self, table, key, true, &name, &name_node);
+  if (!table) return false;
+
+  TomlValue *existing = toml_table__find(table, name);
+  if (existing && !toml_decoder__define(self, existing, TomlKeyDefinitionValue, name_node)) return false;
+
+  TomlValue *value = toml_decoder__value(self, value_node);
+  if (!value) return false;
+
+  if (!toml_table__put(self->arena, table, name, value)) {
+    return toml_decoder__fail(self, node, "out of memory");
+  }
+  return true;
+}
+
+// Resolves the `[header]` or `[[header]]` of a section to the table its pairs belong to.
+static TomlValue *toml_decoder__header(TomlDecoder *self, TSNode header, bool is_array) {
+  TSNode key = ts_node_named_child(header, 0);
+  TomlString name;
+  TSNode name_node;
+  TomlValue *parent = toml_decoder__key(self, self->root, key, false, &name, &name_node);
+  if (!parent) return NULL;
+
+  TomlValue *existing = toml_table__find(parent, name);
+
+  if (!is_array) {
+    if (existing) {
+      if (!toml_decoder__define(self, existing, TomlKeyDefinitionHeader, key)) return NULL;
+      existing->flags |= TomlValueFlagDefined;
+      return existing;
+    }
+
+    TomlValue *table = toml_value__new(self->arena, TomlValueTypeTable, key);
+    if (!table || !toml_table__put(self->arena, parent, name, table)) {
+      toml_decoder__fail(self, key, "out of memory");
+      return NULL;
+    }
+    table->flags |= TomlValueFlagDefined;
+    return table;
+  }
+
+  TomlValue *array = existing;
+  if (array && !toml_decoder__define(self, array, TomlKeyDefinitionElement, key)) return NULL;
+
+  if (!array) {
+    array = toml_value__new(self->arena, TomlValueTypeArray, key);
+    if (!array || !toml_table__put(self->arena, parent, name, array)) {
+      toml_decoder__fail(self, key, "out of memory");
+      return NULL;
+    }
+    array->flags |= TomlValueFlagTableArray;
+  }
+
+  TomlValue *table = toml_value__new(self->arena, TomlValueTypeTable, key);
+  if (!table || !toml_array__push(self->arena, array, table)) {
+    toml_decoder__fail(self, key, "out of memory");
+    return NULL;
+  }
+  table->flags |= TomlValueFlagDefined;
+  return table;
+}
+
+static bool toml_decoder__section(TomlDecoder *self, TSNode node, bool is_array) {
+  uint32_t count = ts_node_named_child_count(node);
+  TomlValue *table = toml_decoder__header(self, ts_node_named_child(node, 0), is_array);
+  if (!table) return false;
+
+  for (uint32_t i = 1; i < count; i++) {
+    TSNode child = ts_node_named_child(node, i);
+    if (toml_syntax_is_comment(&self->symbols, child)) continue;
+    if (!toml_decoder__pair(self, table, child)) return false;
+  }
+  return true;
+}
+
+static bool toml_decoder__document(TomlDecoder *self, TSNode node) {
+  const TomlSyntaxSymbols *symbols = &self->symbols;
+  uint32_t count = ts_node_named_child_count(node);
+
+  for (uint32_t i = 0; i < count; i++) {
+    TSNode child = ts_node_named_child(node, i);
+    TSSymbol symbol = ts_node_symbol(child);
+    bool ok = true;
+    if (symbol == symbols->pair) {
+      ok = toml_decoder__pair(self, self->root, child);
+    } else if (symbol == symbols->table) {
+      ok = toml_decoder__section(self, child, false);
+    } else if (symbol == symbols->table_array_element) {
+      ok = toml_decoder__section(self, child, true);
+    }
+    if (!ok) return false;
+  }
+  return true;
+}
+
+/*
+ *  Public
+ */
+
+TomlDocument *toml_document_new(const TSTree *tree, const char *source, TomlError *error) {
+  TSNode root = ts_tree_root_node(tree);
+  TomlDecoder decoder = {
+    .source = source,
+    .error = error,
+  };
+
+  if (ts_node_has_error(root)) {
+    toml_decoder__fail(&decoder, toml_syntax_first_error(root), "syntax error");
+    return NULL;
+  }
+
+  // everything decoded from the document, the document itself included, lives in one arena
+  decoder.arena = toml_arena_new(toml_arena_capacity_for_source(ts_node_end_byte(root)));
+  if (!decoder.arena) {
+    toml_decoder__fail(&decoder, root, "out of memory");
+    return NULL;
+  }
+
+  TomlDocument *self = toml_arena_alloc(decoder.arena, sizeof(TomlDocument));
+  decoder.root = toml_value__new(decoder.arena, TomlValueTypeTable, root);
+  if (!self || !decoder.root) {
+    toml_decoder__fail(&decoder, root, "out of memory");
+    toml_arena_delete(decoder.arena);
+    return NULL;
+  }
+
+  self->arena = decoder.arena;
+  self->root = decoder.root;
+  toml_syntax_init_symbols(&decoder.symbols, ts_tree_language(tree));
+
+  if (!toml_decoder__document(&decoder, root)) {
+    toml_arena_delete(decoder.arena);
+    return NULL;
+  }
+  return self;
+}
+
+void toml_document_delete(TomlDocument *self) {
+  if (self) toml_arena_delete(self->arena);
+}
+
+const TomlValue *toml_document_root(const TomlDocument *self) {
+  return self->root;
+}
+
+const TomlValue *toml_table_get(const TomlValue *self, const char *key, uint32_t length) {
+  TomlString string = {key, length};
+  return toml_table__find(self, string);
+}
+
+TomlValueDecoder *toml_value_decoder_new(const TSLanguage *language, const char *source) {
+  TomlArena *arena = toml_arena_new(toml_arena_capacity_for_source(0));
+  TomlValueDecoder *self = arena ? toml_arena_alloc(arena, sizeof(TomlValueDecoder)) : NULL;
+  if (!self) {
+    toml_arena_delete(arena);
+    return NULL;
+  }
+
+  memset(self, 0, sizeof(TomlValueDecoder));
+  self->decoder.arena = arena;
+  self->decoder.source = source;
+  toml_syntax_init_symbols(&self->decoder.symbols, language);
+  return self;
+}
+
+void toml_value_decoder_delete(TomlValueDecoder *self) {
+  if (self) toml_arena_delete(self->decoder.arena);
+}
+
+void toml_value_decoder_set_source(TomlValueDecoder *self, const char *source) {
+  self->decoder.source = source;
+}
+
+const TomlValue *toml_value_decoder_decode(TomlValueDecoder *self, TSNode node, TomlError *error) {
+  self->decoder.error = error;
+  return toml_decoder__value(&self->decoder, node);
+}
@@ -0,0 +1,207 @@
+#ifndef TREE_SITTER_TOML_VALUE_H_
+#define TREE_SITTER_TOML_VALUE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <tree_sitter/api.h>
+
+/*
+ *  Typed values decoded from a tree produced by `tree_sitter_toml()`.
+ *
+ *  A `TomlDocument` owns every value, table entry and string reachable from
+ *  its root table; nothing points back into the source buffer, which can be
+ *  released as soon as `toml_document_new` returns. All of it is carved out
+ *  of one arena sized from the length of the parsed input (see `arena.h`)
+ *  and released by a single `toml_document_delete`.
+ */
+
+typedef enum {
+  TomlValueTypeString,
+  TomlValueTypeInteger,
+  TomlValueTypeFloat,
+  TomlValueTypeBoolean,
+  TomlValueTypeOffsetDateTime,
+  TomlValueTypeLocalDateTime,
+  TomlValueTypeLocalDate,
+  TomlValueTypeLocalTime,
+  TomlValueTypeArray,
+  TomlValueTypeTable,
+} TomlValueType;
+
+typedef enum {
+  TomlValueFlagDefined = 1 << 0,  // table opened by a `[header]`
+  TomlValueFlagDotted = 1 << 1,   // table created by a dotted key
+  TomlValueFlagInline = 1 << 2,   // inline table or static array, sealed
+  TomlValueFlagTableArray = 1 << 3,  // array created by `[[header]]`
+} TomlValueFlag;
+
+typedef struct {
+  const char *data;
+  uint32_t length;
+} TomlString;
+
+typedef struct {
+  int32_t year;
+  uint8_t month;
+  uint8_t day;
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+  uint32_t nanosecond;
+  int16_t offset_minutes;
+} TomlDatetime;
+
+typedef struct TomlValue TomlValue;
+typedef struct TomlEntry TomlEntry;
+
+struct TomlValue {
+  TomlValueType type;
+  uint8_t flags;
+  uint32_t start_byte;
+  uint32_t end_byte;
+  union {
+    TomlString string;
+    int64_t integer;
+    double floating;
+    bool boolean;
+    TomlDatetime datetime;
+    struct {
+      TomlValue **items;
+      uint32_t count;
+      uint32_t capacity;
+    } array;
+    struct {
+      TomlEntry *entries;
+      uint32_t count;
+      uint32_t capacity;
+      uint32_t *slots;  // hash index of entries + 1, only once a table has grown large
+      uint32_t slot_count;
+    } table;
+  } as;
+};
+
+struct TomlEntry {
+  TomlString key;
+  uint32_t hash;  // of `key`, used by lookups
+  TomlValue *value;
+};
+
+typedef struct {
+  const char *message;
+  uint32_t start_byte;
+  uint32_t end_byte;
+} TomlError;
+
+typedef struct TomlDocument TomlDocument;
+
+/**
+ * Decode the tree of `source` into typed values. Returns NULL and fills in
+ * `error` (when given) if the tree has syntax errors or the document breaks
+ * one of the table/key rules that the grammar cannot express.
+ */
+TomlDocument *toml_document_new(const TSTree *tree, const char *source, TomlError *error);
+
+void toml_document_delete(TomlDocument *self);
+
+const TomlValue *toml_document_root(const TomlDocument *self);
+
+/**
+ * Find the value stored under `key` in a table, or NULL.
+ */
+const TomlValue *toml_table_get(const TomlValue *self, const char *key, uint32_t length);
+
+/*
+ *  On-demand decoding
+ *
+ *  A `TomlValueDecoder` decodes single value nodes of one tree, for callers
+ *  that only need some of a document's values. Everything it decodes lives
+ *  in its own arena until the decoder is deleted.
+ */
+
+typedef struct TomlValueDecoder TomlValueDecoder;
+
+TomlValueDecoder *toml_value_decoder_new(const TSLanguage *language, const char *source);
+
+void toml_value_decoder_delete(TomlValueDecoder *self);
+
+/**
+ * Decode from a new version of the source from now on, such as the text of a
+ * reparse after an edit. Values decoded before are kept.
+ */
+void toml_value_decoder_set_source(TomlValueDecoder *self, const char *source);
+
+/**
+ * Decode a scalar, `array` or `inline_table` node. Returns NULL and fills in
+ * `error` (when given) if the value is out of range, has an invalid escape or
+ * breaks a key rule inside its braces, or memory runs out.
+ */
+const TomlValue *toml_value_decoder_decode(TomlValueDecoder *self, TSNode node, TomlError *error);
+
+/*
+ *  Scalar decoders
+ *
+ *  These take the text of a single node, delimiters and signs included, and
+ *  are what `toml_document_new` uses for each value.
+ */
+
+/**
+ * Decode the text of a `string` or `quoted_key` node into UTF-8, stripping the
+ * delimiters and the newline that may follow an opening `"""` or `'''`.
+ * `output` needs room for `length` bytes since decoding never grows a string.
+ * Returns false for a `\u` or `\U` escape that is not a Unicode scalar value.
+ */
+bool toml_decode_string(const char *text, uint32_t length, char *output, uint32_t *output_length);
+
+/**
+ * Unescape the body of a basic string, without delimiters. `output` needs room
+ * for `length` bytes and may be the same buffer as `input`.
+ */
+bool toml_decode_string_body(const char *input, uint32_t length, char *output, uint32_t *output_length);
+
+/**
+ * Point `result` at the decoded value of a string inside `text` itself,
+ * without copying or allocating. Always succeeds for literal strings and
+ * `'''` strings (after trimming their leading newline); returns false for a
+ * basic string that contains escapes and needs `toml_decode_string`.
+ */
+bool toml_decode_string_view(const char *text, uint32_t length, TomlString *result);
+
+/**
+ * Decode the text of an `integer` node in any of its decimal, `0x`, `0o` or
+ * `0b` forms, underscores included. Returns false if it does not fit an int64.
+ */
+bool toml_decode_integer(const char *text, uint32_t length, int64_t *result);
+
+/**
+ * Decode the text of a `float` node, underscores, `inf` and `nan` included,
+ * into the nearest double. Returns false only for text the grammar would not
+ * produce; values out of range round to zero or infinity like `strtod`.
+ */
+bool toml_decode_float(const char *text, uint32_t length, double *result);
+
+/**
+ * Decode the text of an `offset_date_time`, `local_date_time`, `local_date` or
+ * `local_time` node, where `type` names which one it is. Fields the node does
+ * not have are left at zero and fractional seconds past nanoseconds are
+ * truncated. Returns false for a year that is not four digits long or a day
+ * that does not exist in its month.
+ */
+bool toml_decode_datetime(const char *text, uint32_t length, TomlValueType type, TomlDatetime *result);
+
+/**
+ * Convert decoded date-time fields to microseconds since 1970-01-01T00:00:00Z,
+ * minus the offset. Local date-times and dates are taken as UTC, and a local
+ * time, whose date fields are zero, counts from midnight. Returns false if the
+ * result does not fit an int64.
+ */
+bool toml_datetime_epoch_micros(const TomlDatetime *self, int64_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_TOML_VALUE_H_
@@ -0,0 +1,182 @@
+#include "./test.h"
+#include "value.h"
+#include <float.h>
+
+/*
+ *  The scalar decoders of value.h, on their own.
+ */
+
+static uint64_t test__state = 0x9e3779b97f4a7c15u;
+
+static uint32_t test__random(uint32_t bound) {
+  test__state ^= test__state << 13;
+  test__state ^= test__state >> 7;
+  test__state ^= test__state << 17;
+  return (uint32_t)(test__state % bound);
+}
+
+// Appends a random piece of a basic string body: plain text or an escape.
+static uint32_t test__string_piece(char *output) {
+  static const char *const pieces[] = {
+    "\\n", "\\t", "\\\"", "\\\\", "\\u00e9", "\\U0001F600", "\\u0041", "\\\n   ",
+  };
+  if (test__random(3)) {
+    uint32_t length = 1 + test__random(40);
+    for (uint32_t i = 0; i < length; i++) output[i] = (char)('a' + test__random(26));
+    return length;
+  }
+  const char *piece = pieces[test__random(sizeof(pieces) / sizeof(*pieces))];
+  uint32_t length = (uint32_t)strlen(piece);
+  memcpy(output, piece, length);
+  return length;
+}
+
+static void test__string_in_place(void) {
+  char input[1024];
+  char expected[1024];
+  char buffer[1024];
+  unsigned failures = test_failures;
+
+  for (unsigned round = 0; round < 20000; round++) {
+    uint32_t length = 0;
+    while (length < 900 && test__random(12)) length += test__string_piece(input + length);
+
+    uint32_t expected_length;
+    uint32_t buffer_length;
+    bool ok = toml_decode_string_body(input, length, expected, &expected_length);
+    TEST_CHECK(ok);
+
+    memcpy(buffer, input, length);
+    TEST_CHECK(toml_decode_string_body(buffer, length, buffer, &buffer_length) == ok);
+    TEST_CHECK(buffer_length == expected_length && memcmp(buffer, expected, expected_length) == 0);
+    if (test_failures != failures) {
+      fprintf(stderr, "in-place decoding differs for: %.*s\n", (int)length, input);
+      return;
+    }
+  }
+}
+
+static void test__string(void) {
+  char output[64];
+  uint32_t length;
+
+  TEST_CHECK(toml_decode_string("\"a\\tb\"", 6, output, &length));
+  TEST_CHECK(length == 3 && memcmp(output, "a\tb", 3) == 0);
+  TEST_CHECK(toml_decode_string("\"\"\"\nx\\\n  y\"\"\"", 13, output, &length));
+  TEST_CHECK(length == 2 && memcmp(output, "xy", 2) == 0);
+  TEST_CHECK(!toml_decode_string("\"\\ud800\"", 8, output, &length));
+  TEST_CHECK(!toml_decode_string("\"\\U00110000\"", 12, output, &length));
+}
+
+static uint64_t test__random64(void) {
+  return ((uint64_t)test__random(1u << 31) << 33) ^ ((uint64_t)test__random(1u << 31) << 2) ^ test__random(4);
+}
+
+// Decodes `text` as given and with an underscore after its first digit, and
+// compares both with `strtod`.
+static bool test__float_matches(const char *text) {
+  double expected = strtod(text, NULL);
+  double value;
+  if (!toml_decode_float(text, (uint32_t)strlen(text), &value)) return false;
+  if (memcmp(&value, &expected, sizeof(double)) != 0) return false;
+
+  char underscored[1024];
+  const char *digit = strpbrk(text, "0123456789");
+  size_t prefix = (size_t)(digit - text) + 1;
+  if (digit[1] < '0' || digit[1] > '9') return true;
+  memcpy(underscored, text, prefix);
+  underscored[prefix] = '_';
+  strcpy(underscored + prefix + 1, text + prefix);
+  if (!toml_decode_float(underscored, (uint32_t)strlen(underscored), &value)) return false;
+  return memcmp(&value, &expected, sizeof(double)) == 0;
+}
+
+static void test__float_check(const char *text) {
+  if (!test__float_matches(text)) {
+    fprintf(stderr, "differs from strtod: %s\n", text);
+    test_failures++;
+  }
+}
+
+static void test__float(void) {
+  static const char *const cases[] = {
+    "0.0", "-0.0", "1.0", "3.1415", "1e1000", "-1e1000", "1e-1000", "5e-324", "2.4703282292062327e-324",
+    "2.4703282292062328e-324", "1.7976931348623157e308", "1.7976931348623158e308", "2.2250738585072011e-308",
+    "9007199254740993.0", "9007199254740993.000000000000000000001", "0.1000000000000000055511151231257827",
+    "7.038531e-26", "1.00000000000000011102230246251565404236316680908203125",
+    "1.00000000000000011102230246251565404236316680908203124",
+    "1.00000000000000011102230246251565404236316680908203126",
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) test__float_check(cases[i]);
+
+  char text[1024];
+  for (unsigned round = 0; round < 200000; round++) {
+    uint64_t bits = test__random64();
+    double value;
+    memcpy(&value, &bits, sizeof(double));
+    if (value != value || value - value != 0) continue;
+
+    switch (round % 4) {
+      case 0:
+        // every precision up to the shortest round trip and past it
+        sprintf(text, "%.*e", (int)test__random(20), value);
+        break;
+      case 1:
+        // long random digit strings, most of them truncated to 19 digits
+        {
+          uint32_t length = 0;
+          uint32_t digits = 1 + test__random(60);
+          text[length++] = (char)('1' + test__random(9));
+          for (uint32_t i = 1; i < digits; i++) {
+            if (i == 1) text[length++] = '.';
+            text[length++] = (char)('0' + test__random(10));
+          }
+          sprintf(text + length, "e%d", (int)test__random(660) - 340);
+        }
+        break;
+      default:
+        // halfway between two doubles and the digits around it, exact with a long double
+#if LDBL_MANT_DIG >= 64
+        {
+          double next;
+          uint64_t next_bits = bits + 1;
+          memcpy(&next, &next_bits, sizeof(double));
+          if (next != next || next - next != 0) continue;
+          long double halfway = ((long double)value + (long double)next) / 2;
+          sprintf(text, "%.*Le", round % 4 == 2 ? 780 : 16 + (int)test__random(8), halfway);
+        }
+#else
+        sprintf(text, "%.17e", value);
+#endif
+        break;
+    }
+    test__float_check(text);
+  }
+}
+
+static void test__datetime(void) {
+  TomlDatetime datetime;
+
+  TEST_CHECK(toml_decode_datetime("1979-05-27T07:32:00.123456789123-07:30", 38, TomlValueTypeOffsetDateTime, &datetime));
+  TEST_CHECK(datetime.year == 1979 && datetime.month == 5 && datetime.day == 27);
+  TEST_CHECK(datetime.hour == 7 && datetime.minute == 32 && datetime.second == 0);
+  TEST_CHECK(datetime.nanosecond == 123456789 && datetime.offset_minutes == -450);
+
+  TEST_CHECK(toml_decode_datetime("2000-02-29", 10, TomlValueTypeLocalDate, &datetime));
+  TEST_CHECK(!toml_decode_datetime("1900-02-29", 10, TomlValueTypeLocalDate, &datetime));
+  TEST_CHECK(!toml_decode_datetime("1979-04-31", 10, TomlValueTypeLocalDate, &datetime));
+
+  // the grammar allows a year of any length
+  TEST_CHECK(!toml_decode_datetime("19790-05-27", 11, TomlValueTypeLocalDate, &datetime));
+  TEST_CHECK(!toml_decode_datetime("979-05-27", 9, TomlValueTypeLocalDate, &datetime));
+  TEST_CHECK(!toml_decode_datetime("979-05-27 07:32:00", 18, TomlValueTypeLocalDateTime, &datetime));
+  TEST_CHECK(!toml_decode_datetime("10000-01-01T00:00:00Z", 21, TomlValueTypeOffsetDateTime, &datetime));
+}
+
+int main(void) {
+  test__string();
+  test__string_in_place();
+  test__float();
+  test__datetime();
+  return test_finish("decode");
+}
@@ -0,0 +1,95 @@
+#include "./test.h"
+#include "fold.h"
+
+/*
+ *  Fold ranges of a small document, which must be the nodes of
+ *  `queries/folds.scm` that span more than one row.
+ */
+
+typedef struct {
+  uint32_t start_row;
+  uint32_t end_row;
+  const char *start;  // the text the fold starts with
+} TestFold;
+
+static const char test__source[] =
+  "[table]\n"
+  "a = 1\n"
+  "b = [\n"
+  "  1,\n"
+  "  2,\n"
+  "]\n"
+  "c = { list = [\n"
+  "  1,\n"
+  "] }\n"
+  "s = \"\"\"\n"
+  "text\n"
+  "\"\"\"\n"
+  "one = [1, 2]\n"
+  "d = { x = 1 }\n"
+  "[[elements]]\n"
+  "x = 1\n"
+  "[[elements]]\n"
+  "y = '''\n"
+  "literal\n"
+  "'''\n";
+
+// outer folds before the ones inside them, single-row arrays and inline tables left out
+static const TestFold test__folds[] = {
+  {0, 13, "[table]"},
+  {2, 5, "[\n  1,\n  2,"},
+  {6, 8, "{ list"},
+  {6, 8, "[\n  1,\n]"},
+  {9, 11, "\"\"\"\ntext"},
+  {14, 15, "[[elements]]\nx"},
+  {16, 19, "[[elements]]\ny"},
+  {17, 19, "'''\nliteral"},
+};
+
+#define TEST_FOLD_COUNT (sizeof(test__folds) / sizeof(*test__folds))
+
+static TSPoint test__point(uint32_t byte) {
+  TSPoint point = {0, 0};
+  for (uint32_t i = 0; i < byte; i++) {
+    if (test__source[i] == '\n') {
+      point.row++;
+      point.column = 0;
+    } else {
+      point.column++;
+    }
+  }
+  return point;
+}
+
+int main(void) {
+  TSTree *tree = test_parse(test__source, sizeof(test__source) - 1);
+  TomlFold folds[TEST_FOLD_COUNT + 4];
+  uint32_t count = toml_fold_tree(tree, folds, TEST_FOLD_COUNT + 4);
+  TEST_CHECK(count == TEST_FOLD_COUNT);
+
+  for (uint32_t i = 0; i < count && i < TEST_FOLD_COUNT; i++) {
+    const TestFold *expected = &test__folds[i];
+    const TomlFold *fold = &folds[i];
+    TSPoint start = test__point(fold->start_byte);
+    TSPoint end = test__point(fold->end_byte);
+    bool same = fold->start_row == expected->start_row && fold->end_row == expected->end_row
+      && start.row == fold->start_row
+      && (end.row == fold->end_row || (end.row == fold->end_row + 1 && end.column == 0))
+      && strncmp(test__source + fold->start_byte, expected->start, strlen(expected->start)) == 0;
+    TEST_CHECK(same);
+    if (!same) {
+      fprintf(
+        stderr, "fold %u is rows %u to %u from \"%.12s\", expected rows %u to %u from \"%s\"\n", i,
+        fold->start_row, fold->end_row, test__source + fold->start_byte,
+        expected->start_row, expected->end_row, expected->start
+      );
+    }
+  }
+
+  // too little room still counts every fold
+  TEST_CHECK(toml_fold_tree(tree, folds, 2) == TEST_FOLD_COUNT);
+  TEST_CHECK(toml_fold_tree(tree, NULL, 0) == TEST_FOLD_COUNT);
+
+  ts_tree_delete(tree);
+  return test_finish("fold");
+}
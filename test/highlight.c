@@ -0,0 +1,204 @@
+#include "./test.h"
+#include "highlight.h"
+
+/*
+ *  Highlight spans of a small document, which must be the captures that
+ *  `queries/highlights.scm` gives its nodes, and those of every window of
+ *  it, which must be the spans of the whole tree that overlap the window.
+ */
+
+typedef struct {
+  const char *text;
+  TomlHighlight highlight;
+} TestSpan;
+
+static const char test__source[] =
+  "# settings\n"
+  "title = \"TOML \\\"x\\\"\"\n"
+  "[server.\"http\".v2]\n"
+  "port = 8080 # default\n"
+  "ratio = 0.5\n"
+  "enabled = true\n"
+  "[[peers]]\n"
+  "at = 1979-05-27T07:32:00Z\n"
+  "day = 1979-05-27\n"
+  "ports = [ 8001, 8002 ]\n"
+  "inline = { a = 'b' }\n"
+  "text = \"\"\"\n"
+  "two\n"
+  "[lines]\n"
+  "\"\"\"\n";
+
+static const TestSpan test__spans[] = {
+  {"# settings", TomlHighlightComment},
+  {"title", TomlHighlightProperty},
+  {"=", TomlHighlightOperator},
+  {"\"TOML \\\"x\\\"\"", TomlHighlightString},
+  {"[", TomlHighlightPunctuationBracket},
+  {"server", TomlHighlightProperty},
+  {".", TomlHighlightPunctuationDelimiter},
+  {"\"http\"", TomlHighlightString},
+  {".", TomlHighlightPunctuationDelimiter},
+  {"v2", TomlHighlightProperty},
+  {"]", TomlHighlightPunctuationBracket},
+  {"port", TomlHighlightProperty},
+  {"=", TomlHighlightOperator},
+  {"8080", TomlHighlightNumber},
+  {"# default", TomlHighlightComment},
+  {"ratio", TomlHighlightProperty},
+  {"=", TomlHighlightOperator},
+  {"0.5", TomlHighlightNumber},
+  {"enabled", TomlHighlightProperty},
+  {"=", TomlHighlightOperator},
+  {"true", TomlHighlightConstantBuiltin},
+  {"[[", TomlHighlightPunctuationBracket},
+  {"peers", TomlHighlightProperty},
+  {"]]", TomlHighlightPunctuationBracket},
+  {"at", TomlHighlightProperty},
+  {"=", TomlHighlightOperator},
+  {"1979-05-27T07:32:00Z", TomlHighlightStringSpecial},
+  {"day", TomlHighlightProperty},
+  {"=", TomlHighlightOperator},
+  {"1979-05-27", TomlHighlightStringSpecial},
+  {"ports", TomlHighlightProperty},
+  {"=", TomlHighlightOperator},
+  {"[", TomlHighlightPunctuationBracket},
+  {"8001", TomlHighlightNumber},
+  {",", TomlHighlightPunctuationDelimiter},
+  {"8002", TomlHighlightNumber},
+  {"]", TomlHighlightPunctuationBracket},
+  {"inline", TomlHighlightProperty},
+  {"=", TomlHighlightOperator},
+  {"{", TomlHighlightPunctuationBracket},
+  {"a", TomlHighlightProperty},
+  {"=", TomlHighlightOperator},
+  {"'b'", TomlHighlightString},
+  {"}", TomlHighlightPunctuationBracket},
+  {"text", TomlHighlightProperty},
+  {"=", TomlHighlightOperator},
+  {"\"\"\"\ntwo\n[lines]\n\"\"\"", TomlHighlightString},
+};
+
+#define TEST_SPAN_COUNT (sizeof(test__spans) / sizeof(*test__spans))
+
+static void test__tree(const TSTree *tree) {
+  TomlHighlightSpan spans[TEST_SPAN_COUNT + 8];
+  uint32_t count = toml_highlight_tree(tree, spans, TEST_SPAN_COUNT + 8);
+  TEST_CHECK(count == TEST_SPAN_COUNT);
+
+  for (uint32_t i = 0; i < count && i < TEST_SPAN_COUNT; i++) {
+    const TestSpan *expected = &test__spans[i];
+    uint32_t length = (uint32_t)strlen(expected->text);
+    bool same = spans[i].highlight == expected->highlight
+      && spans[i].end_byte - spans[i].start_byte == length
+      && memcmp(test__source + spans[i].start_byte, expected->text, length) == 0;
+    TEST_CHECK(same);
+    if (!same) {
+      fprintf(
+        stderr, "span %u is %s over \"%.*s\", expected %s over \"%s\"\n", i,
+        toml_highlight_name(spans[i].highlight), (int)(spans[i].end_byte - spans[i].start_byte),
+        test__source + spans[i].start_byte, toml_highlight_name(expected->highlight), expected->text
+      );
+    }
+  }
+
+  // too little room still counts every span
+  TEST_CHECK(toml_highlight_tree(tree, spans, 3) == TEST_SPAN_COUNT);
+  TEST_CHECK(toml_highlight_tree(tree, NULL, 0) == TEST_SPAN_COUNT);
+}
+
+static TSPoint test__point(uint32_t byte) {
+  TSPoint point = {0, 0};
+  for (uint32_t i = 0; i < byte; i++) {
+    if (test__source[i] == '\n') {
+      point.row++;
+      point.column = 0;
+    } else {
+      point.column++;
+    }
+  }
+  return point;
+}
+
+// Whether the window returned exactly the spans of `all` that `overlaps` keeps.
+static bool test__same_window(
+  const TomlHighlightSpan *all, uint32_t all_count, const TomlHighlightSpan *spans, uint32_t count,
+  bool (*overlaps)(const TomlHighlightSpan *, uint32_t, uint32_t), uint32_t start, uint32_t end
+) {
+  uint32_t j = 0;
+  for (uint32_t i = 0; i < all_count; i++) {
+    if (!overlaps(&all[i], start, end)) continue;
+    if (
+      j == count || spans[j].start_byte != all[i].start_byte || spans[j].end_byte != all[i].end_byte
+      || spans[j].highlight != all[i].highlight
+    ) {
+      return false;
+    }
+    j++;
+  }
+  return j == count;
+}
+
+static bool test__overlaps_bytes(const TomlHighlightSpan *span, uint32_t start, uint32_t end) {
+  return span->end_byte > start && span->start_byte < end;
+}
+
+// A span that ends at the start of a row, after a line ending, does not reach into it.
+static bool test__overlaps_rows(const TomlHighlightSpan *span, uint32_t start, uint32_t end) {
+  TSPoint span_start = test__point(span->start_byte);
+  TSPoint span_end = test__point(span->end_byte);
+  bool ends_before = span_end.row < start || (span_end.row == start && span_end.column == 0);
+  return !ends_before && span_start.row < end;
+}
+
+// Every window, including those that start or end inside the multiline string.
+static void test__windows(const TSTree *tree) {
+  enum { length = sizeof(test__source) - 1 };
+  TomlHighlightSpan all[TEST_SPAN_COUNT];
+  TomlHighlightSpan spans[TEST_SPAN_COUNT];
+  uint32_t all_count = toml_highlight_tree(tree, all, TEST_SPAN_COUNT);
+
+  for (uint32_t start = 0; start <= length; start++) {
+    for (uint32_t end = start; end <= length + 1; end++) {
+      uint32_t count = toml_highlight_bytes(tree, start, end, spans, TEST_SPAN_COUNT);
+      bool same = test__same_window(all, all_count, spans, count, test__overlaps_bytes, start, end);
+      TEST_CHECK(same);
+      if (!same) fprintf(stderr, "bytes %u to %u differ\n", start, end);
+    }
+  }
+
+  uint32_t row_count = test__point(length).row + 1;
+  for (uint32_t start = 0; start <= row_count; start++) {
+    for (uint32_t end = start; end <= row_count + 1; end++) {
+      uint32_t count = toml_highlight_rows(tree, start, end, spans, TEST_SPAN_COUNT);
+      bool same = test__same_window(all, all_count, spans, count, test__overlaps_rows, start, end);
+      TEST_CHECK(same);
+      if (!same) fprintf(stderr, "rows %u to %u differ\n", start, end);
+    }
+  }
+
+  // a window inside the multiline string is the string alone
+  const char *two = strstr(test__source, "two");
+  uint32_t two_byte = (uint32_t)(two - test__source);
+  uint32_t count = toml_highlight_bytes(tree, two_byte, two_byte + 3, spans, TEST_SPAN_COUNT);
+  TEST_CHECK(count == 1 && spans[0].highlight == TomlHighlightString && spans[0].start_byte < two_byte);
+  count = toml_highlight_rows(tree, test__point(two_byte).row, test__point(two_byte).row + 1, spans, TEST_SPAN_COUNT);
+  TEST_CHECK(count == 1 && spans[0].highlight == TomlHighlightString && spans[0].start_byte < two_byte);
+}
+
+static void test__names(void) {
+  TEST_CHECK(toml_highlight_name(TomlHighlightNone) == NULL);
+  TEST_CHECK(toml_highlight_name(TomlHighlightCount) == NULL);
+  TEST_CHECK(strcmp(toml_highlight_name(TomlHighlightPunctuationBracket), "punctuation.bracket") == 0);
+  TEST_CHECK(strcmp(toml_highlight_name(TomlHighlightStringSpecial), "string.special") == 0);
+  TEST_CHECK(toml_highlight_for_symbol(UINT16_MAX) == TomlHighlightNone);
+}
+
+int main(void) {
+  TSTree *tree = test_parse(test__source, sizeof(test__source) - 1);
+  test__tree(tree);
+  test__windows(tree);
+  test__names();
+  ts_tree_delete(tree);
+  return test_finish("highlight");
+}
@@ -0,0 +1,153 @@
+#include "./test.h"
+#include "index.h"
+
+/*
+ *  Lookups in a `TomlIndex`, which must find what `toml_table_get` finds in
+ *  the decoded document.
+ */
+
+typedef struct {
+  const char *path;      // written like a TOML key
+  const char *keys[4];   // the same path decoded, up to a NULL
+} TestPath;
+
+static const TestPath test__paths[] = {
+  {"basic", {"basic"}},
+  {"mixed", {"mixed"}},
+  {"point", {"point"}},
+  {"point.y.z", {"point", "y", "z"}},
+  {"server", {"server"}},
+  {"server.http", {"server", "http"}},
+  {" server . http.port ", {"server", "http", "port"}},
+  {"\"server\".'http'.port", {"server", "http", "port"}},
+  {"fruit", {"fruit"}},
+  {"keys.\"tab\\tkey\"", {"keys", "tab\tkey"}},
+  {"keys.'C:\\dir'", {"keys", "C:\\dir"}},
+  {"keys.\"\\u00e9t\\u00e9\".dotted", {"keys", "\xc3\xa9t\xc3\xa9", "dotted"}},
+  {"keys.\"\xc3\xa9t\xc3\xa9\"", {"keys", "\xc3\xa9t\xc3\xa9"}},
+  {"keys.plain.\"quoted.dot\"", {"keys", "plain", "quoted.dot"}},
+
+  // paths that are not there, though most of their segments are keys
+  {"missing", {"missing"}},
+  {"http", {"http"}},
+  {"port", {"port"}},
+  {"server.port", {"server", "port"}},
+  {"server.http.port.x", {"server", "http", "port", "x"}},
+  {"point.z", {"point", "z"}},
+  {"fruit.name", {"fruit", "name"}},
+  {"keys.plain.quoted", {"keys", "plain", "quoted"}},
+  {"keys.\"tab\\\\tkey\"", {"keys", "tab\\tkey"}},
+};
+
+static const TomlValue *test__document_get(const TomlValue *value, const char *const *keys) {
+  for (; *keys && value; keys++) {
+    value = value->type == TomlValueTypeTable ? toml_table_get(value, *keys, (uint32_t)strlen(*keys)) : NULL;
+  }
+  return value;
+}
+
+// Whether an entry is what the document has for the same path.
+static bool test__same_entry(const TomlIndexEntry *entry, const TomlValue *value) {
+  if (!entry || !value) return !entry && !value;
+  if (value->type == TomlValueTypeArray && (value->flags & TomlValueFlagTableArray)) {
+    return entry->kind == TomlIndexKindTableArray && entry->elements.count == value->as.array.count;
+  }
+  if (value->type == TomlValueTypeTable && !(value->flags & TomlValueFlagInline)) {
+    return entry->kind == TomlIndexKindTable;
+  }
+  return ts_node_start_byte(entry->node) == value->start_byte && ts_node_end_byte(entry->node) == value->end_byte;
+}
+
+static void test__lookup(TomlIndex *index, const TomlIndexEntry *base, const TomlValue *table, const TestPath *test) {
+  TomlIndexPath path;
+  bool compiled = toml_index_path(index, test->path, (uint32_t)strlen(test->path), &path);
+  TEST_CHECK(compiled);
+  if (!compiled) return;
+
+  const TomlIndexEntry *entry = base ? toml_index_get_in(index, base, &path) : toml_index_get(index, &path);
+  bool same = test__same_entry(entry, test__document_get(table, test->keys));
+  TEST_CHECK(same);
+  if (!same) fprintf(stderr, "lookup of %s differs\n", test->path);
+}
+
+static void test__fixture(void) {
+  uint32_t length;
+  char *source = test_read_file("test/fixtures/values.toml", &length);
+  TSTree *tree = test_parse(source, length);
+  TomlError error = {0};
+  TomlDocument *document = toml_document_new(tree, source, &error);
+  TomlIndex *index = toml_index_new(tree, source, &error);
+  TEST_CHECK(document != NULL && index != NULL);
+  if (!document || !index) {
+    fprintf(stderr, "%s at %u\n", error.message, error.start_byte);
+    toml_document_delete(document);
+    toml_index_delete(index);
+    ts_tree_delete(tree);
+    free(source);
+    return;
+  }
+
+  const TomlValue *root = toml_document_root(document);
+  for (size_t i = 0; i < sizeof(test__paths) / sizeof(*test__paths); i++) {
+    test__lookup(index, NULL, root, &test__paths[i]);
+  }
+
+  // the elements of an array of tables are found through it, and paths go on from them
+  TomlIndexPath path;
+  const TomlIndexEntry *fruit = toml_index_path(index, "fruit", 5, &path) ? toml_index_get(index, &path) : NULL;
+  const TomlValue *fruits = toml_table_get(root, "fruit", 5);
+  TEST_CHECK(fruit && fruit->kind == TomlIndexKindTableArray && fruits);
+  if (fruit && fruits) {
+    static const TestPath element_paths[] = {
+      {"name", {"name"}},
+      {"color.red", {"color", "red"}},
+      {"fruit.name", {"fruit", "name"}},
+    };
+    for (uint32_t i = 0; i < fruit->elements.count && i < fruits->as.array.count; i++) {
+      for (size_t j = 0; j < sizeof(element_paths) / sizeof(*element_paths); j++) {
+        test__lookup(index, fruit->elements.items[i], fruits->as.array.items[i], &element_paths[j]);
+      }
+      TEST_CHECK(toml_index_child(index, fruit, (TomlAtom)i) == NULL);
+    }
+  }
+
+  // atoms name every decoded key once
+  TomlAtom atom = toml_index_atom(index, "tab\tkey", 7);
+  TEST_CHECK(atom != TOML_ATOM_NONE);
+  TEST_CHECK_STRING(toml_index_atom_name(index, atom), "tab\tkey");
+  TEST_CHECK(toml_index_atom(index, "\"tab\\tkey\"", 10) == TOML_ATOM_NONE);
+
+  // text that is not a key
+  static const char *const invalid[] = {"", "a.", ".a", "a..b", "a b", "\"a", "'a\nb'", "a.\"\\q\""};
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(*invalid); i++) {
+    TEST_CHECK(!toml_index_path(index, invalid[i], (uint32_t)strlen(invalid[i]), &path));
+  }
+
+  toml_index_delete(index);
+  toml_document_delete(document);
+  ts_tree_delete(tree);
+  free(source);
+}
+
+// A key with an invalid escape fails the index as it fails the decoded document.
+static void test__invalid_escape(void) {
+  static const char source[] = "ok = 1\n[t]\n\"a\\qb\".c = 2\n";
+  TSTree *tree = test_parse(source, sizeof(source) - 1);
+  TomlError error = {0};
+  TomlError first = {0};
+  TomlIndex *index = toml_index_new(tree, source, &error);
+  TomlDocument *document = toml_document_new(tree, source, &first);
+  TEST_CHECK(index == NULL && document == NULL);
+  TEST_CHECK(error.message && strcmp(error.message, "invalid escape sequence") == 0);
+  TEST_CHECK(first.message && error.start_byte == first.start_byte && error.end_byte == first.end_byte);
+  TEST_CHECK(error.start_byte == (uint32_t)(strchr(source, '"') - source));
+  toml_index_delete(index);
+  toml_document_delete(document);
+  ts_tree_delete(tree);
+}
+
+int main(void) {
+  test__fixture();
+  test__invalid_escape();
+  return test_finish("index");
+}
@@ -0,0 +1,125 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "./test.h"
+#include "input.h"
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ *  Files read through `toml_file_input`, from a regular file and from a
+ *  pipe, which must parse to the tree of the same text parsed as a string.
+ *  scripts/run-tests.sh builds this test a second time with
+ *  TOML_FILE_INPUT_NO_MMAP, so that regular files are read in chunks.
+ */
+
+static bool test__same_tree(TSNode a, TSNode b) {
+  if (
+    ts_node_symbol(a) != ts_node_symbol(b) || ts_node_start_byte(a) != ts_node_start_byte(b)
+    || ts_node_end_byte(a) != ts_node_end_byte(b) || ts_node_child_count(a) != ts_node_child_count(b)
+  ) {
+    return false;
+  }
+  for (uint32_t i = 0; i < ts_node_child_count(a); i++) {
+    if (!test__same_tree(ts_node_child(a, i), ts_node_child(b, i))) return false;
+  }
+  return true;
+}
+
+// Parses what `fd` holds and checks it against `expected`, parsed from `source`.
+static void test__input(int fd, const char *source, uint32_t length, TSTree *expected, const char *name) {
+  TomlFileInput *input = toml_file_input_new(fd);
+  TEST_CHECK(input != NULL);
+  if (!input) {
+    perror(name);
+    return;
+  }
+  TEST_CHECK(toml_file_input_length(input) == length);
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_toml());
+  TSTree *tree = ts_parser_parse(parser, NULL, toml_file_input(input));
+  bool same = tree && test__same_tree(ts_tree_root_node(tree), ts_tree_root_node(expected));
+  TEST_CHECK(same);
+  if (!same) fprintf(stderr, "tree of %s differs\n", name);
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+
+  // asked for after the parse, so that a chunked file was read in chunks first
+  const char *text = toml_file_input_source(input);
+  TEST_CHECK(text != NULL && memcmp(text, source, length) == 0);
+  toml_file_input_delete(input);
+}
+
+static void test__regular_file(const char *source, uint32_t length, TSTree *expected, const char *name) {
+  FILE *file = tmpfile();
+  if (!file || fwrite(source, 1, length, file) != length || fflush(file) != 0) {
+    perror(name);
+    exit(1);
+  }
+  test__input(fileno(file), source, length, expected, name);
+  fclose(file);
+}
+
+// The text comes from a child process, in as many writes as the pipe needs.
+static void test__pipe(const char *source, uint32_t length, TSTree *expected, const char *name) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    perror(name);
+    exit(1);
+  }
+
+  pid_t child = fork();
+  if (child < 0) {
+    perror(name);
+    exit(1);
+  }
+  if (child == 0) {
+    close(fds[0]);
+    for (uint32_t written = 0; written < length;) {
+      ssize_t result = write(fds[1], source + written, length - written);
+      if (result < 0) _exit(1);
+      written += (uint32_t)result;
+    }
+    _exit(0);
+  }
+
+  close(fds[1]);
+  test__input(fds[0], source, length, expected, name);
+  close(fds[0]);
+  int status;
+  TEST_CHECK(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+static void test__source(const char *source, uint32_t length, const char *name) {
+  TSTree *expected = test_parse(source, length);
+  test__regular_file(source, length, expected, name);
+  test__pipe(source, length, expected, name);
+  ts_tree_delete(expected);
+}
+
+// More than a chunk and more than a pipe holds, with strings across the chunk edges.
+static void test__large_source(void) {
+  enum { line_count = 2000, line_capacity = 160 };
+  char *source = malloc(line_count * line_capacity);
+  if (!source) exit(1);
+  uint32_t length = 0;
+  for (unsigned i = 0; i < line_count; i++) {
+    if (i % 100 == 0) length += (uint32_t)sprintf(source + length, "[table%u]\n", i / 100);
+    length += (uint32_t)sprintf(
+      source + length, "key%u = \"%0*u\" # %u\n", i, 60 + (int)(i % 50), i, i
+    );
+  }
+  test__source(source, length, "a large source");
+  free(source);
+}
+
+int main(void) {
+  uint32_t length;
+  char *source = test_read_file("test/fixtures/values.toml", &length);
+  test__source(source, length, "test/fixtures/values.toml");
+  free(source);
+
+  test__large_source();
+  test__source("", 0, "an empty file");
+  return test_finish("input");
+}
@@ -0,0 +1,95 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "./test.h"
+#include "json.h"
+
+/*
+ *  Transcoding with `toml_json_writer_write`.
+ */
+
+static void test__json(const char *source, const char *expected) {
+  FILE *file = tmpfile();
+  TomlJsonWriter *writer = toml_json_writer_new(fileno(file), 0);
+  TSTree *tree = test_parse(source, (uint32_t)strlen(source));
+
+  TomlError error = {0};
+  TEST_CHECK(toml_json_writer_write(writer, tree, source, &error));
+  TEST_CHECK(toml_json_writer_delete(writer));
+  ts_tree_delete(tree);
+
+  char output[1024];
+  rewind(file);
+  size_t length = fread(output, 1, sizeof(output) - 1, file);
+  output[length] = '\0';
+  fclose(file);
+
+  if (strcmp(output, expected) != 0) {
+    fprintf(stderr, "for %s  expected %s  got %s", source, expected, output);
+    test_failures++;
+  }
+}
+
+// Writes `first`, which must fail, then `second` through the same writer.
+static void test__json_after_failure(size_t buffer_size, const char *first, const char *second, const char *expected) {
+  FILE *file = tmpfile();
+  TomlJsonWriter *writer = toml_json_writer_new(fileno(file), buffer_size);
+  TSTree *trees[2] = {test_parse(first, (uint32_t)strlen(first)), test_parse(second, (uint32_t)strlen(second))};
+
+  TomlError error = {0};
+  TEST_CHECK(!toml_json_writer_write(writer, trees[0], first, &error));
+  TEST_CHECK(error.message && strcmp(error.message, "integer out of range") == 0);
+  TEST_CHECK(toml_json_writer_write(writer, trees[1], second, &error));
+  TEST_CHECK(toml_json_writer_delete(writer));
+  ts_tree_delete(trees[0]);
+  ts_tree_delete(trees[1]);
+
+  char output[1024];
+  rewind(file);
+  size_t length = fread(output, 1, sizeof(output) - 1, file);
+  output[length] = '\0';
+  fclose(file);
+
+  if (strcmp(output, expected) != 0) {
+    fprintf(stderr, "after %s  expected %s  got %s", first, expected, output);
+    test_failures++;
+  }
+}
+
+int main(void) {
+  test__json(
+    "title = \"x\\ty\"\nn = [1, 2.5, inf]\n",
+    "{\"title\":\"x\\ty\",\"n\":[1,2.5,null]}\n"
+  );
+  test__json(
+    "[a.b]\nx = 1\n[a]\ny = true\nb.z = 2\n",
+    "{\"a\":{\"y\":true,\"b\":{\"x\":1,\"z\":2}}}\n"
+  );
+  test__json(
+    "[[t]]\nn = 1\n[t.u]\nm = 2\n[[t]]\nn = 3\n",
+    "{\"t\":[{\"n\":1,\"u\":{\"m\":2}},{\"n\":3}]}\n"
+  );
+
+  // not valid TOML, but the pairs of both sections are written
+  test__json(
+    "[a]\nx = 1\n[b]\ny = 2\n[a]\nz = 3\n",
+    "{\"a\":{\"x\":1,\"z\":3},\"b\":{\"y\":2}}\n"
+  );
+
+  // a failed document leaves nothing behind for the next one
+  test__json_after_failure(
+    0,
+    "[a]\nx = 1\ny = 99999999999999999999\n",
+    "b = 2\n",
+    "{\"b\":2}\n"
+  );
+
+  // unless part of it was already flushed, which then gets a line of its own
+  test__json_after_failure(
+    8,
+    "[a]\nx = 'long enough to flush'\ny = 99999999999999999999\n",
+    "b = 2\n",
+    "{\"a\":{\"x\":\"long enough to flush\",\"y\":\n{\"b\":2}\n"
+  );
+
+  return test_finish("json");
+}
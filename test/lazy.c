@@ -0,0 +1,185 @@
+#include "./test.h"
+#include "lazy.h"
+#include <math.h>
+
+/*
+ *  Values decoded on demand by a `TomlLazyDocument`, which must be those of
+ *  the decoded document and be decoded only once.
+ */
+
+typedef struct {
+  const char *path;      // written like a TOML key
+  const char *keys[4];   // the same path decoded, up to a NULL
+} TestPath;
+
+// Paths to pairs, whose values the lazy document decodes.
+static const TestPath test__values[] = {
+  {"basic", {"basic"}},
+  {"multiline_basic", {"multiline_basic"}},
+  {"hex", {"hex"}},
+  {"both", {"both"}},
+  {"not_a_number", {"not_a_number"}},
+  {"no", {"no"}},
+  {"offset_date_time", {"offset_date_time"}},
+  {"local_time", {"local_time"}},
+  {"mixed", {"mixed"}},
+  {"point", {"point"}},
+  {"point.y.z", {"point", "y", "z"}},
+  {"server.http.port", {"server", "http", "port"}},
+  {"keys.\"tab\\tkey\"", {"keys", "tab\tkey"}},
+  {"keys.'C:\\dir'", {"keys", "C:\\dir"}},
+  {"keys.\"\\u00e9t\\u00e9\".dotted", {"keys", "\xc3\xa9t\xc3\xa9", "dotted"}},
+  {"keys.plain.\"quoted.dot\"", {"keys", "plain", "quoted.dot"}},
+};
+
+// Paths to tables and arrays of tables, which are walked through the index
+// instead, and to nothing.
+static const char *const test__no_values[] = {
+  "server", "server.http", "keys", "keys.plain", "fruit", "missing", "point.z", "fruit.name",
+};
+
+static bool test__same_value(const TomlValue *a, const TomlValue *b) {
+  if (!a || !b) return a == b;
+  if (a->type != b->type || a->flags != b->flags || a->start_byte != b->start_byte || a->end_byte != b->end_byte) {
+    return false;
+  }
+
+  switch (a->type) {
+    case TomlValueTypeString:
+      return a->as.string.length == b->as.string.length
+        && memcmp(a->as.string.data, b->as.string.data, a->as.string.length) == 0;
+    case TomlValueTypeInteger:
+      return a->as.integer == b->as.integer;
+    case TomlValueTypeFloat:
+      return a->as.floating == b->as.floating || (isnan(a->as.floating) && isnan(b->as.floating));
+    case TomlValueTypeBoolean:
+      return a->as.boolean == b->as.boolean;
+    case TomlValueTypeArray:
+      if (a->as.array.count != b->as.array.count) return false;
+      for (uint32_t i = 0; i < a->as.array.count; i++) {
+        if (!test__same_value(a->as.array.items[i], b->as.array.items[i])) return false;
+      }
+      return true;
+    case TomlValueTypeTable:
+      if (a->as.table.count != b->as.table.count) return false;
+      for (uint32_t i = 0; i < a->as.table.count; i++) {
+        const TomlEntry *left = &a->as.table.entries[i];
+        const TomlEntry *right = &b->as.table.entries[i];
+        if (left->key.length != right->key.length || memcmp(left->key.data, right->key.data, left->key.length) != 0) {
+          return false;
+        }
+        if (!test__same_value(left->value, right->value)) return false;
+      }
+      return true;
+    default:
+      return memcmp(&a->as.datetime, &b->as.datetime, sizeof(TomlDatetime)) == 0;
+  }
+}
+
+static const TomlValue *test__document_get(const TomlValue *value, const char *const *keys) {
+  for (; *keys && value; keys++) {
+    value = value->type == TomlValueTypeTable ? toml_table_get(value, *keys, (uint32_t)strlen(*keys)) : NULL;
+  }
+  return value;
+}
+
+static const TomlValue *test__get(TomlLazyDocument *lazy, const char *text) {
+  TomlIndexPath path;
+  TomlError error = {0};
+  TEST_CHECK(toml_index_path(toml_lazy_document_index(lazy), text, (uint32_t)strlen(text), &path));
+  const TomlValue *value = toml_lazy_document_get(lazy, &path, &error);
+  TEST_CHECK(error.message == NULL);
+  return value;
+}
+
+static void test__fixture(void) {
+  uint32_t length;
+  char *source = test_read_file("test/fixtures/values.toml", &length);
+  TSTree *tree = test_parse(source, length);
+  TomlError error = {0};
+  TomlDocument *document = toml_document_new(tree, source, &error);
+  TomlLazyDocument *lazy = toml_lazy_document_new(tree, source, &error);
+  TEST_CHECK(document != NULL && lazy != NULL);
+  if (!document || !lazy) {
+    fprintf(stderr, "%s at %u\n", error.message, error.start_byte);
+    toml_document_delete(document);
+    toml_lazy_document_delete(lazy);
+    ts_tree_delete(tree);
+    free(source);
+    return;
+  }
+
+  const TomlValue *root = toml_document_root(document);
+  const TomlValue *first[sizeof(test__values) / sizeof(*test__values)];
+  for (size_t i = 0; i < sizeof(test__values) / sizeof(*test__values); i++) {
+    first[i] = test__get(lazy, test__values[i].path);
+    bool same = first[i] && test__same_value(first[i], test__document_get(root, test__values[i].keys));
+    TEST_CHECK(same);
+    if (!same) fprintf(stderr, "value of %s differs\n", test__values[i].path);
+  }
+
+  // the second access returns what the first one decoded, whatever came in between
+  for (size_t i = 0; i < sizeof(test__values) / sizeof(*test__values); i++) {
+    TEST_CHECK(test__get(lazy, test__values[i].path) == first[i]);
+  }
+
+  for (size_t i = 0; i < sizeof(test__no_values) / sizeof(*test__no_values); i++) {
+    TEST_CHECK(test__get(lazy, test__no_values[i]) == NULL);
+  }
+
+  // the pairs of the elements of an array of tables are reached through the index
+  TomlIndex *index = toml_lazy_document_index(lazy);
+  TomlIndexPath fruit_path;
+  TomlIndexPath name_path;
+  const TomlIndexEntry *fruit = toml_index_path(index, "fruit", 5, &fruit_path) ? toml_index_get(index, &fruit_path) : NULL;
+  const TomlValue *fruits = toml_table_get(root, "fruit", 5);
+  TEST_CHECK(fruit && fruits && toml_index_path(index, "name", 4, &name_path));
+  if (fruit && fruits) {
+    TEST_CHECK(fruit->elements.count == fruits->as.array.count);
+    for (uint32_t i = 0; i < fruit->elements.count && i < fruits->as.array.count; i++) {
+      const TomlIndexEntry *name = toml_index_get_in(index, fruit->elements.items[i], &name_path);
+      const TomlValue *value = name ? toml_lazy_document_value(lazy, name, NULL) : NULL;
+      TEST_CHECK(value && test__same_value(value, toml_table_get(fruits->as.array.items[i], "name", 4)));
+      TEST_CHECK(value && toml_lazy_document_value(lazy, name, NULL) == value);
+    }
+  }
+
+  toml_lazy_document_delete(lazy);
+  toml_document_delete(document);
+  ts_tree_delete(tree);
+  free(source);
+}
+
+// Enough values for the cache to grow while earlier ones stay where they are.
+static void test__many_values(void) {
+  enum { count = 300 };
+  char *source = malloc(count * 32);
+  uint32_t length = 0;
+  for (int i = 0; i < count; i++) length += (uint32_t)sprintf(source + length, "key%d = %d\n", i, i);
+
+  TSTree *tree = test_parse(source, length);
+  TomlLazyDocument *lazy = toml_lazy_document_new(tree, source, NULL);
+  TEST_CHECK(lazy != NULL);
+  if (lazy) {
+    static const TomlValue *values[count];
+    char key[16];
+    for (int i = 0; i < count; i++) {
+      sprintf(key, "key%d", i);
+      values[i] = test__get(lazy, key);
+      TEST_CHECK(values[i] && values[i]->type == TomlValueTypeInteger && values[i]->as.integer == i);
+    }
+    for (int i = 0; i < count; i++) {
+      sprintf(key, "key%d", i);
+      TEST_CHECK(test__get(lazy, key) == values[i]);
+    }
+    toml_lazy_document_delete(lazy);
+  }
+  ts_tree_delete(tree);
+  free(source);
+}
+
+int main(void) {
+  test__fixture();
+  test__many_values();
+  return test_finish("lazy");
+}
@@ -0,0 +1,315 @@
+#include "./test.h"
+#include "model.h"
+
+/*
+ *  Edits followed through `toml_model_edit` and `toml_model_update`, which
+ *  must leave the model as `toml_model_new` would build it from scratch.
+ */
+
+#define TEST_SOURCE_CAPACITY 8192
+#define TEST_ERROR_CAPACITY 64
+
+static uint64_t test__state = 0x2545f4914f6cdd1du;
+
+static uint32_t test__random(uint32_t bound) {
+  test__state ^= test__state << 13;
+  test__state ^= test__state >> 7;
+  test__state ^= test__state << 17;
+  return (uint32_t)(test__state % bound);
+}
+
+// Lines that reach the same few keys in every way a document can.
+static const char *const test__lines[] = {
+  "a = 1", "b = 'two'", "c = 3.5", "a.b = true", "a.c.d = 4", "b.c = [1, 2]", "x = {y = 1}",
+  "x.z = 2", "y = {a.b = 1, c = {d = 2}}", "arr = [{a = 1}, {b = 2}]", "[a]", "[b]", "[x]",
+  "[a.b]", "[a.c]", "[x.y]", "[[arr]]", "[[a.arr]]", "[arr.c]", "[[x]]", "c = 1979-05-27",
+  "d = \"\\u00e9\"", "# comment", "", "'a' = 5", "\"b\".c = 6", "y.b = 7", "a = {}",
+};
+
+// Characters that splice lines into others, or break them.
+static const char test__characters[] = "=.[]{} ab1\"\n";
+
+// The key paths whose values are compared.
+static const char *const test__keys[] = {"a", "b", "c", "d", "x", "y", "z", "arr"};
+
+#define TEST_KEY_COUNT (sizeof(test__keys) / sizeof(*test__keys))
+
+typedef struct {
+  char text[TEST_SOURCE_CAPACITY];
+  uint32_t length;
+} TestSource;
+
+static TSPoint test__point(const TestSource *source, uint32_t byte) {
+  TSPoint point = {0, 0};
+  for (uint32_t i = 0; i < byte; i++) {
+    if (source->text[i] == '\n') {
+      point.row++;
+      point.column = 0;
+    } else {
+      point.column++;
+    }
+  }
+  return point;
+}
+
+static uint32_t test__line_start(const TestSource *source, uint32_t line) {
+  uint32_t i = 0;
+  while (line > 0 && i < source->length) {
+    if (source->text[i++] == '\n') line--;
+  }
+  return i;
+}
+
+static uint32_t test__line_count(const TestSource *source) {
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < source->length; i++) count += source->text[i] == '\n';
+  return count;
+}
+
+// Replaces the bytes from `start` to `end` with `text`, filling in `edit`.
+static bool test__splice(TestSource *source, uint32_t start, uint32_t end, const char *text, uint32_t length, TSInputEdit *edit) {
+  if (source->length - (end - start) + length >= TEST_SOURCE_CAPACITY) return false;
+  edit->start_byte = start;
+  edit->old_end_byte = end;
+  edit->new_end_byte = start + length;
+  edit->start_point = test__point(source, start);
+  edit->old_end_point = test__point(source, end);
+
+  memmove(source->text + start + length, source->text + end, source->length - end);
+  memcpy(source->text + start, text, length);
+  source->length = source->length - (end - start) + length;
+  source->text[source->length] = '\0';
+  edit->new_end_point = test__point(source, start + length);
+  return true;
+}
+
+typedef enum {
+  TestLinesFew,      // `test__lines`
+  TestLinesKeys,     // many keys, which fill the model's hash tables far enough for entries to collide
+  TestLinesHeaders,  // many sibling headers, and dotted keys that go through the same table
+} TestLines;
+
+// The keys of the sequences of many keys or headers are numbered up to this.
+#define TEST_MANY_KEY_COUNT 400
+
+static uint32_t test__random_line(TestLines lines, char *line) {
+  uint32_t number = test__random(TEST_MANY_KEY_COUNT);
+  switch (lines) {
+    case TestLinesKeys:
+      return (uint32_t)sprintf(line, test__random(2) ? "k%u = %u\n" : "g%u.k = %u\n", number, number);
+    case TestLinesHeaders:
+      switch (test__random(4)) {
+        case 0: return (uint32_t)sprintf(line, "[deps.d%u]\n", number);
+        case 1: return (uint32_t)sprintf(line, "[[deps.d%u]]\n", number);
+        case 2: return (uint32_t)sprintf(line, "server.k%u = %u\n", number, number);
+        default: return (uint32_t)sprintf(line, "v = %u\n", number);
+      }
+    default:
+      return (uint32_t)sprintf(line, "%s\n", test__lines[test__random(sizeof(test__lines) / sizeof(*test__lines))]);
+  }
+}
+
+// Makes one random edit: a line replaced, inserted or removed, or one character typed or deleted.
+static bool test__random_edit(TestSource *source, TestLines lines, TSInputEdit *edit) {
+  char line[64];
+  uint32_t length = test__random_line(lines, line);
+  uint32_t line_count = test__line_count(source);
+  uint32_t at = test__random(line_count + 1);
+  uint32_t start = test__line_start(source, at);
+  uint32_t end = test__line_start(source, at + 1);
+
+  switch (test__random(5)) {
+    case 0:
+      if (at < line_count) return test__splice(source, start, end, line, length, edit);
+      return test__splice(source, start, start, line, length, edit);
+    case 1:
+      return test__splice(source, start, start, line, length, edit);
+    case 2:
+      return test__splice(source, start, end, "", 0, edit);
+    case 3: {
+      uint32_t byte = test__random(source->length + 1);
+      char c = test__characters[test__random(sizeof(test__characters) - 1)];
+      return test__splice(source, byte, byte, &c, 1, edit);
+    }
+    default: {
+      if (!source->length) return false;
+      uint32_t byte = test__random(source->length);
+      return test__splice(source, byte, byte + 1, "", 0, edit);
+    }
+  }
+}
+
+static bool test__same_value(const TomlValue *a, const TomlValue *b) {
+  if (!a || !b) return a == b;
+  if (a->type != b->type || a->start_byte != b->start_byte || a->end_byte != b->end_byte) return false;
+
+  switch (a->type) {
+    case TomlValueTypeString:
+      return a->as.string.length == b->as.string.length
+        && memcmp(a->as.string.data, b->as.string.data, a->as.string.length) == 0;
+    case TomlValueTypeInteger:
+      return a->as.integer == b->as.integer;
+    case TomlValueTypeFloat:
+      return memcmp(&a->as.floating, &b->as.floating, sizeof(double)) == 0;
+    case TomlValueTypeBoolean:
+      return a->as.boolean == b->as.boolean;
+    case TomlValueTypeArray:
+      if (a->as.array.count != b->as.array.count) return false;
+      for (uint32_t i = 0; i < a->as.array.count; i++) {
+        if (!test__same_value(a->as.array.items[i], b->as.array.items[i])) return false;
+      }
+      return true;
+    case TomlValueTypeTable:
+      if (a->as.table.count != b->as.table.count) return false;
+      for (uint32_t i = 0; i < a->as.table.count; i++) {
+        const TomlEntry *left = &a->as.table.entries[i];
+        const TomlEntry *right = &b->as.table.entries[i];
+        if (left->key.length != right->key.length || memcmp(left->key.data, right->key.data, left->key.length) != 0) {
+          return false;
+        }
+        if (!test__same_value(left->value, right->value)) return false;
+      }
+      return true;
+    default:
+      return memcmp(&a->as.datetime, &b->as.datetime, sizeof(TomlDatetime)) == 0;
+  }
+}
+
+static bool test__same_get(TomlModel *model, TomlModel *fresh, const TomlString *keys, uint32_t depth) {
+  TomlError error = {0};
+  TomlError expected_error = {0};
+  const TomlValue *value = toml_model_get(model, keys, depth, &error);
+  if (!test__same_value(value, toml_model_get(fresh, keys, depth, &expected_error))) return false;
+  if (error.message != expected_error.message) return false;
+  // a value is decoded once and then kept
+  return !value || toml_model_get(model, keys, depth, NULL) == value;
+}
+
+// Compares the errors and the values of every path that the lines can make.
+static bool test__same_model(TomlModel *model, TomlModel *fresh, TestLines lines) {
+  TomlError errors[TEST_ERROR_CAPACITY];
+  TomlError expected[TEST_ERROR_CAPACITY];
+  uint32_t count = toml_model_errors(model, errors, TEST_ERROR_CAPACITY);
+  if (count != toml_model_errors(fresh, expected, TEST_ERROR_CAPACITY)) return false;
+  for (uint32_t i = 0; i < count && i < TEST_ERROR_CAPACITY; i++) {
+    if (
+      strcmp(errors[i].message, expected[i].message) != 0
+      || errors[i].start_byte != expected[i].start_byte
+      || errors[i].end_byte != expected[i].end_byte
+    ) {
+      return false;
+    }
+  }
+
+  if (lines == TestLinesHeaders) {
+    for (uint32_t number = 0; number < TEST_MANY_KEY_COUNT; number++) {
+      char names[2][16];
+      TomlString keys[3] = {
+        {"deps", 4},
+        {names[0], (uint32_t)sprintf(names[0], "d%u", number)},
+        {"v", 1},
+      };
+      if (!test__same_get(model, fresh, keys, 2) || !test__same_get(model, fresh, keys, 3)) return false;
+      keys[0] = (TomlString) {"server", 6};
+      keys[1] = (TomlString) {names[1], (uint32_t)sprintf(names[1], "k%u", number)};
+      if (!test__same_get(model, fresh, keys, 2)) return false;
+    }
+    return true;
+  }
+
+  if (lines == TestLinesKeys) {
+    for (uint32_t number = 0; number < TEST_MANY_KEY_COUNT; number++) {
+      char names[2][16];
+      TomlString keys[2] = {
+        {names[0], (uint32_t)sprintf(names[0], "k%u", number)},
+        {names[1], (uint32_t)sprintf(names[1], "k")},
+      };
+      if (!test__same_get(model, fresh, keys, 1)) return false;
+      keys[0].length = (uint32_t)sprintf(names[0], "g%u", number);
+      if (!test__same_get(model, fresh, keys, 2)) return false;
+    }
+    return true;
+  }
+
+  for (uint32_t path = 0; path < TEST_KEY_COUNT * TEST_KEY_COUNT * TEST_KEY_COUNT; path++) {
+    TomlString keys[3];
+    for (uint32_t i = 0, rest = path; i < 3; i++, rest /= TEST_KEY_COUNT) {
+      const char *key = test__keys[rest % TEST_KEY_COUNT];
+      keys[i] = (TomlString) {key, (uint32_t)strlen(key)};
+    }
+    for (uint32_t depth = 1; depth <= 3; depth++) {
+      if (!test__same_get(model, fresh, keys, depth)) return false;
+    }
+  }
+  return true;
+}
+
+static void test__edits(unsigned sequence, unsigned steps, TestLines lines) {
+  static TestSource source;
+  source.length = 0;
+  for (uint32_t i = 0, count = lines != TestLinesFew ? 150 : 1 + test__random(8); i < count; i++) {
+    source.length += test__random_line(lines, source.text + source.length);
+  }
+
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_toml());
+  TSTree *tree = ts_parser_parse_string(parser, NULL, source.text, source.length);
+  TomlModel *model = toml_model_new(tree, source.text);
+  TEST_CHECK(model != NULL);
+  if (!model) return;
+
+  // the model keeps pointing into the source of the last update, so the text is edited in a copy
+  static TestSource sources[2];
+  unsigned current = 0;
+  sources[current] = source;
+
+  for (unsigned step = 0; step < steps; step++) {
+    TestSource *next = &sources[current ^ 1];
+    *next = sources[current];
+
+    // one or more edits per reparse, as when several keystrokes come in between
+    for (uint32_t i = 0, edits = 1 + (test__random(4) == 0); i < edits; i++) {
+      TSInputEdit edit;
+      if (!test__random_edit(next, lines, &edit)) continue;
+      ts_tree_edit(tree, &edit);
+      toml_model_edit(model, &edit);
+    }
+
+    TSTree *new_tree = ts_parser_parse_string(parser, tree, next->text, next->length);
+    uint32_t range_count;
+    TSRange *ranges = ts_tree_get_changed_ranges(tree, new_tree, &range_count);
+    bool updated = toml_model_update(model, new_tree, next->text, ranges, range_count);
+    free(ranges);
+    ts_tree_delete(tree);
+    tree = new_tree;
+    current ^= 1;
+
+    TEST_CHECK(updated);
+    TomlModel *fresh = toml_model_new(tree, next->text);
+    bool same = updated && fresh && test__same_model(model, fresh, lines);
+    toml_model_delete(fresh);
+    TEST_CHECK(same);
+
+    // and it finds errors exactly when decoding the whole document does
+    TomlError first = {0};
+    TomlDocument *document = toml_document_new(tree, next->text, &first);
+    toml_document_delete(document);
+    same = same && !toml_model_errors(model, NULL, 0) == (document != NULL);
+    TEST_CHECK(same);
+    if (!same) {
+      fprintf(stderr, "sequence %u differs after step %u:\n%s\n", sequence, step, next->text);
+      break;
+    }
+  }
+
+  toml_model_delete(model);
+  ts_tree_delete(tree);
+  ts_parser_delete(parser);
+}
+
+int main(void) {
+  for (unsigned sequence = 0; sequence < 40; sequence++) test__edits(sequence, 25, TestLinesFew);
+  for (unsigned sequence = 40; sequence < 44; sequence++) test__edits(sequence, 25, TestLinesKeys);
+  for (unsigned sequence = 44; sequence < 48; sequence++) test__edits(sequence, 25, TestLinesHeaders);
+  return test_finish("model");
+}
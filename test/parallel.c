@@ -0,0 +1,119 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "./test.h"
+#include "json.h"
+#include "parallel.h"
+
+/*
+ *  Documents parsed in pieces with `toml_parallel_parse`, which must
+ *  transcode to the same JSON as when they are parsed whole.
+ */
+
+#define TEST_SECTION_COUNT 40
+
+typedef struct {
+  char *data;
+  uint32_t length;
+  uint32_t capacity;
+} TestText;
+
+static void test__append(TestText *self, const char *format, unsigned number) {
+  char line[256];
+  uint32_t length = (uint32_t)snprintf(line, sizeof(line), format, number, number, number);
+  if (self->length + length + 1 > self->capacity) {
+    self->capacity = (self->length + length + 1) * 2;
+    self->data = realloc(self->data, self->capacity);
+    if (!self->data) exit(1);
+  }
+  memcpy(self->data + self->length, line, length + 1);
+  self->length += length;
+}
+
+// Writes the trees as JSON and returns what was written.
+static char *test__json(const TSTree *const *trees, uint32_t count, const char *source, uint32_t *length) {
+  FILE *file = tmpfile();
+  TomlJsonWriter *writer = toml_json_writer_new(fileno(file), 0);
+  TomlError error = {0};
+  bool ok = toml_json_writer_write_trees(writer, trees, count, source, &error);
+  TEST_CHECK(ok);
+  if (!ok) fprintf(stderr, "%s at byte %u\n", error.message, error.start_byte);
+  TEST_CHECK(toml_json_writer_delete(writer));
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  rewind(file);
+  char *output = malloc((size_t)size + 1);
+  if (!output || fread(output, 1, (size_t)size, file) != (size_t)size) exit(1);
+  output[size] = '\0';
+  fclose(file);
+  *length = (uint32_t)size;
+  return output;
+}
+
+static void test__document(const char *name, const TestText *text) {
+  TSTree *tree = test_parse(text->data, text->length);
+  uint32_t expected_length;
+  char *expected = test__json((const TSTree *const *)&tree, 1, text->data, &expected_length);
+  ts_tree_delete(tree);
+
+  static const uint32_t thread_counts[] = {1, 2, 4, 7};
+  for (size_t i = 0; i < sizeof(thread_counts) / sizeof(*thread_counts); i++) {
+    TomlParallelTrees trees = {0};
+    TEST_CHECK(toml_parallel_parse(tree_sitter_toml(), text->data, text->length, thread_counts[i], &trees));
+    // every document has enough headers for as many pieces as threads
+    TEST_CHECK(trees.count == thread_counts[i]);
+
+    uint32_t length;
+    char *output = test__json((const TSTree *const *)trees.trees, trees.count, text->data, &length);
+    bool same = length == expected_length && memcmp(output, expected, length) == 0;
+    TEST_CHECK(same);
+    if (!same) fprintf(stderr, "%s differs on %u threads\n", name, thread_counts[i]);
+    free(output);
+    toml_parallel_trees_delete(&trees);
+  }
+  free(expected);
+}
+
+// Arrays of tables whose elements, and the tables under them, land in different pieces.
+static void test__table_arrays(void) {
+  TestText text = {0};
+  test__append(&text, "title = \"products\"\n", 0);
+  for (unsigned i = 0; i < TEST_SECTION_COUNT; i++) {
+    test__append(&text, "[[products]]\nname = \"p%u\"\nsku = %u\n", i);
+    test__append(&text, "[products.size]\nwidth = %u\n", i);
+    if (i % 3 == 0) test__append(&text, "[[products.parts]]\nid = %u\n", i);
+  }
+  test__document("arrays of tables", &text);
+  free(text.data);
+}
+
+// Tables whose parts are spread over the document, which the JSON stitches together.
+static void test__spread_tables(void) {
+  TestText text = {0};
+  for (unsigned i = 0; i < TEST_SECTION_COUNT; i++) test__append(&text, "[t%u]\nx.y = %u\n", i);
+  for (unsigned i = 0; i < TEST_SECTION_COUNT; i++) test__append(&text, "[t%u.x.z]\nw = %u\n", i);
+  for (unsigned i = 0; i < TEST_SECTION_COUNT; i++) test__append(&text, "[t%u.u]\nv = %u\n", i);
+  test__document("spread tables", &text);
+  free(text.data);
+}
+
+// Lines that look like headers inside strings and arrays, which must not start a piece.
+static void test__false_headers(void) {
+  TestText text = {0};
+  for (unsigned i = 0; i < TEST_SECTION_COUNT; i++) {
+    test__append(&text, "[s%u]\n", i);
+    test__append(&text, "basic = \"\"\"\n[fake%u]\n[[fake%u]]\nx = %u\n\"\"\"\n", i);
+    test__append(&text, "literal = '''\n[fake%u] # '' \n[[fake%u]]\n''' # [x%u]\n", i);
+    test__append(&text, "matrix = [\n[%u, 1],\n[[%u]],\n{a = %u},\n]\n", i);
+    test__append(&text, "# [comment%u] with \"\"\" and '''\nquoted = \"[%u]\"\n", i);
+  }
+  test__document("false headers", &text);
+  free(text.data);
+}
+
+int main(void) {
+  test__table_arrays();
+  test__spread_tables();
+  test__false_headers();
+  return test_finish("parallel");
+}
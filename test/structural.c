@@ -0,0 +1,221 @@
+#include "./test.h"
+#include "../bench/corpus.h"
+#include "structural.h"
+
+/*
+ *  The structural index from every kernel the CPU supports, against a
+ *  reference that walks the source one byte at a time.
+ */
+
+#define TEST_POSITION_CAPACITY 4096
+
+typedef struct {
+  uint32_t *contents;
+  uint32_t size;
+  uint32_t capacity;
+} TestPositions;
+
+static void test__push(TestPositions *self, uint32_t position) {
+  if (self->size == self->capacity) {
+    self->capacity = self->capacity ? self->capacity * 2 : 256;
+    self->contents = realloc(self->contents, self->capacity * sizeof(uint32_t));
+    if (!self->contents) exit(1);
+  }
+  self->contents[self->size++] = position;
+}
+
+static uint32_t test__run(const char *source, uint32_t length, uint32_t at, char quote, uint32_t max) {
+  uint32_t run = 0;
+  while (run < max && at + run < length && source[at + run] == quote) run++;
+  return run;
+}
+
+// The structural bytes as structural.h describes them, found byte by byte.
+static void test__reference(const char *source, uint32_t length, TestPositions *result) {
+  enum { Plain, Basic, Literal, MultilineBasic, MultilineLiteral, Comment } state = Plain;
+  uint32_t at = 0;
+  while (at < length) {
+    char c = source[at];
+    switch (state) {
+      case Plain:
+        if (strchr("[]{}=,\n", c)) {
+          test__push(result, at);
+        } else if (c == '#') {
+          test__push(result, at);
+          state = Comment;
+        } else if (c == '"' || c == '\'') {
+          test__push(result, at);
+          if (test__run(source, length, at, c, 3) == 3) {
+            state = c == '"' ? MultilineBasic : MultilineLiteral;
+            at += 2;
+          } else {
+            state = c == '"' ? Basic : Literal;
+          }
+        }
+        at++;
+        break;
+
+      case Basic:
+      case Literal:
+        if (c == '\\' && state == Basic) {
+          at += 2;
+        } else if (c == '\n') {
+          state = Plain;  // the newline is structural again
+        } else {
+          if (c == (state == Basic ? '"' : '\'')) {
+            test__push(result, at);
+            state = Plain;
+          }
+          at++;
+        }
+        break;
+
+      case MultilineBasic:
+      case MultilineLiteral: {
+        char quote = state == MultilineBasic ? '"' : '\'';
+        if (c == '\\' && state == MultilineBasic) {
+          at += 2;
+        } else if (c == quote) {
+          uint32_t run = test__run(source, length, at, quote, 5);
+          if (run >= 3) {
+            test__push(result, at + run - 3);
+            state = Plain;
+          }
+          at += run;
+        } else {
+          at++;
+        }
+        break;
+      }
+
+      case Comment:
+        if (c == '\n') {
+          state = Plain;
+        } else {
+          at++;
+        }
+        break;
+    }
+  }
+}
+
+static void test__index(const char *source, uint32_t length, TomlStructuralKernel kernel, uint32_t capacity, TestPositions *result) {
+  static uint32_t positions[TEST_POSITION_CAPACITY];
+  TomlStructuralScanner scanner;
+  uint32_t count;
+  toml_structural_scanner_init(&scanner, source, length, kernel);
+  while ((count = toml_structural_next(&scanner, positions, capacity))) {
+    for (uint32_t i = 0; i < count; i++) test__push(result, positions[i]);
+  }
+}
+
+static bool test__same(const TestPositions *a, const TestPositions *b) {
+  return a->size == b->size && (!a->size || memcmp(a->contents, b->contents, a->size * sizeof(uint32_t)) == 0);
+}
+
+// the smallest capacity scans one block per call
+static const uint32_t test__capacities[] = {64, 127, TEST_POSITION_CAPACITY};
+
+// Checks every supported kernel, with small and large capacities,
+// against the scalar kernel and the reference.
+static void test__source(const char *source, uint32_t length, const char *name) {
+  TestPositions expected = {0};
+  TestPositions scalar = {0};
+  test__reference(source, length, &expected);
+  test__index(source, length, TomlStructuralKernelScalar, 64, &scalar);
+  TEST_CHECK(test__same(&scalar, &expected));
+  if (!test__same(&scalar, &expected)) fprintf(stderr, "scalar differs from the reference on %s\n", name);
+
+  for (unsigned kernel = 0; kernel < TomlStructuralKernelCount; kernel++) {
+    if (!toml_structural_kernel_supported((TomlStructuralKernel)kernel)) continue;
+    for (size_t i = 0; i < sizeof(test__capacities) / sizeof(*test__capacities); i++) {
+      uint32_t capacity = test__capacities[i];
+      TestPositions positions = {0};
+      test__index(source, length, (TomlStructuralKernel)kernel, capacity, &positions);
+      bool same = test__same(&positions, &scalar);
+      TEST_CHECK(same);
+      if (!same) {
+        fprintf(
+          stderr, "%s with capacity %u differs from scalar on %s\n",
+          toml_structural_kernel_name((TomlStructuralKernel)kernel), capacity, name
+        );
+      }
+      free(positions.contents);
+    }
+  }
+
+  free(expected.contents);
+  free(scalar.contents);
+}
+
+// Runs that decide the state, placed at every offset around the first block edge.
+static const char *const test__snippets[] = {
+  "a = \"x\\\\\\\\\\\"y\" = 1\n",
+  "a = \"\\\"\\\\\"\n",
+  "s = \"\"\"ab\"\"\"\"\n",
+  "s = \"\"\"ab\"\"\"\"\"\n",
+  "s = '''ab''''\n",
+  "s = '''ab'''''\n",
+  "s = \"\"\"\"\"\"\n",
+  "s = ''''''\n",
+  "s = \"\"\"a\\\"\"\"b\"\"\"\n",
+  "s = \"\"\"\n[x]\n#\\\n\"\"\"\n",
+  "s = '''\n[x] # '' \n'''\n",
+  "t = \"a#b\" # c \"d\n",
+  "t = 'a#b' # c 'd\n",
+  "t = \"unterminated\n[x]\n",
+  "x = 1\r\n[y]\r\nz = [1, {a = 2}]\r\n",
+  "\"\"\"\\\\\"\"\"\n",
+};
+
+static void test__block_edges(void) {
+  char source[256];
+  char name[64];
+  for (size_t i = 0; i < sizeof(test__snippets) / sizeof(*test__snippets); i++) {
+    uint32_t snippet_length = (uint32_t)strlen(test__snippets[i]);
+    for (uint32_t pad = 40; pad <= 70; pad++) {
+      memset(source, 'a', pad);
+      memcpy(source + pad, test__snippets[i], snippet_length);
+      // the same snippet again, so that it also starts after a block edge
+      memcpy(source + pad + snippet_length, test__snippets[i], snippet_length);
+      snprintf(name, sizeof(name), "snippet %zu after %u bytes", i, pad);
+      test__source(source, pad + 2 * snippet_length, name);
+    }
+  }
+}
+
+// Sources made only of the bytes that change the state.
+static void test__random_sources(void) {
+  static const char alphabet[] = "\"\"\"'''\\\\##\n\r[]{}=, a";
+  uint64_t state = 0x9e3779b97f4a7c15u;
+  char source[512];
+  char name[32];
+  for (unsigned i = 0; i < 2000; i++) {
+    uint32_t length = i % sizeof(source);
+    for (uint32_t j = 0; j < length; j++) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      source[j] = alphabet[state % (sizeof(alphabet) - 1)];
+    }
+    snprintf(name, sizeof(name), "random source %u", i);
+    test__source(source, length, name);
+  }
+}
+
+static void test__corpora(void) {
+  for (unsigned shape = 0; shape < BenchShapeCount; shape++) {
+    BenchBuffer buffer = {0};
+    TEST_CHECK(bench_generate((BenchShape)shape, 256 * 1024, 1, &buffer));
+    test__source(buffer.data, (uint32_t)buffer.length, bench_shape_name((BenchShape)shape));
+    bench_buffer_delete(&buffer);
+  }
+}
+
+int main(void) {
+  test__source("", 0, "the empty source");
+  test__block_edges();
+  test__random_sources();
+  test__corpora();
+  return test_finish("structural");
+}
@@ -0,0 +1,76 @@
+#ifndef TREE_SITTER_TOML_TEST_TEST_H_
+#define TREE_SITTER_TOML_TEST_TEST_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tree_sitter/api.h>
+
+/*
+ *  Checks shared by the C tests in test/.
+ *
+ *  Each test is its own program, run from the root of the repository by
+ *  scripts/run-tests.sh. A failed check is reported and counted, and the
+ *  test keeps going so that one run shows every failure.
+ */
+
+const TSLanguage *tree_sitter_toml(void);
+
+static unsigned test_failures;
+
+#define TEST_CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      test_failures++; \
+    } \
+  } while (0)
+
+#define TEST_CHECK_STRING(string, expected) \
+  TEST_CHECK((string).length == sizeof(expected) - 1 && memcmp((string).data, expected, sizeof(expected) - 1) == 0)
+
+// Reads a whole file into a NUL-terminated buffer, or exits.
+static inline char *test_read_file(const char *path, uint32_t *length) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    perror(path);
+    exit(1);
+  }
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  char *data = malloc((size_t)size + 1);
+  if (!data || fread(data, 1, (size_t)size, file) != (size_t)size) {
+    perror(path);
+    exit(1);
+  }
+  fclose(file);
+
+  data[size] = '\0';
+  *length = (uint32_t)size;
+  return data;
+}
+
+static inline TSTree *test_parse(const char *source, uint32_t length) {
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, tree_sitter_toml());
+  TSTree *tree = ts_parser_parse_string(parser, NULL, source, length);
+  ts_parser_delete(parser);
+  return tree;
+}
+
+// Reports the result of the test and returns its exit status.
+static inline int test_finish(const char *name) {
+  if (test_failures) {
+    fprintf(stderr, "%s: %u checks failed\n", name, test_failures);
+    return 1;
+  }
+  printf("%s: ok\n", name);
+  return 0;
+}
+
+#endif  // TREE_SITTER_TOML_TEST_TEST_H_
@@ -0,0 +1,86 @@
+#include "./test.h"
+#include "validate.h"
+
+/*
+ *  Semantic errors found by `toml_validator_check`, which must agree with
+ *  the first error of `toml_document_new`.
+ */
+
+typedef struct {
+  const char *source;
+  const char *message;
+  const char *at;  // the text the error covers, found from the end of the source
+} TestCase;
+
+static const TestCase test__cases[] = {
+  {"a = 1\nb = 2\na = 3\n", "duplicate key", "a"},
+  {"[x]\n\"a\" = 1\n'a' = 2\n", "duplicate key", "'a'"},
+  {"[a]\nb = 1\n[a]\nc = 1\n", "table redefined", "a"},
+  {"a.b = 1\n[a]\n", "table redefined", "a"},
+  {"[a.b]\n[a]\n[a]\n", "table redefined", "a"},
+  {"a = {b = 1}\na.c = 2\n", "cannot extend an inline table", "a"},
+  {"a = {b = {c = 1}}\n[a.b]\n", "cannot extend an inline table", "a"},
+  {"a = {b = {c = 1}, b.d = 2}\n", "cannot extend an inline table", "b"},
+  {"[a]\nx.y = 1\n[a.x]\n", "table redefined", "a.x"},
+  {"a = 1\n[[a]]\n", "cannot append to a value that is not an array of tables", "a"},
+  {"[x]\n\"a\\qb\".c = 1\n", "invalid escape sequence", "\"a\\qb\""},
+  {"[a]\nb.c = 1\n[a.b.d]\n", NULL, NULL},
+  {"[[a]]\nb = 1\n[[a]]\nb = 2\n[a.c]\n", NULL, NULL},
+  {"a = {b.c = 1, b.d = 2}\n", NULL, NULL},
+};
+
+static void test__case(TomlValidator *validator, const TestCase *test) {
+  unsigned failures = test_failures;
+  uint32_t length = (uint32_t)strlen(test->source);
+  TSTree *tree = test_parse(test->source, length);
+  TomlError errors[4];
+  uint32_t count = toml_validator_check(validator, tree, test->source, errors, 4);
+
+  TomlError first = {0};
+  TomlDocument *document = toml_document_new(tree, test->source, &first);
+  toml_document_delete(document);
+  ts_tree_delete(tree);
+
+  if (!test->message) {
+    TEST_CHECK(count == 0 && document != NULL);
+    if (count) fprintf(stderr, "unexpected %s in: %s\n", errors[0].message, test->source);
+    return;
+  }
+
+  const char *at = test->source + length;
+  uint32_t at_length = (uint32_t)strlen(test->at);
+  while (at > test->source && strncmp(--at, test->at, at_length) != 0) {}
+
+  TEST_CHECK(count == 1);
+  TEST_CHECK(count && strcmp(errors[0].message, test->message) == 0);
+  TEST_CHECK(count && errors[0].start_byte == (uint32_t)(at - test->source));
+  TEST_CHECK(count && errors[0].end_byte == errors[0].start_byte + at_length);
+  TEST_CHECK(!document && first.message && strcmp(first.message, test->message) == 0);
+  TEST_CHECK(first.start_byte == errors[0].start_byte && first.end_byte == errors[0].end_byte);
+  if (test_failures != failures) fprintf(stderr, "in: %s\n", test->source);
+}
+
+// Every error is found, and those past the capacity are only counted.
+static void test__several(TomlValidator *validator) {
+  const char *source = "a = 1\na = 2\nb = {c = 1}\nb.d = 1\na = 3\n[t]\n[t]\n";
+  TSTree *tree = test_parse(source, (uint32_t)strlen(source));
+  TomlError errors[3];
+
+  TEST_CHECK(toml_validator_check(validator, tree, source, errors, 3) == 4);
+  TEST_CHECK(strcmp(errors[0].message, "duplicate key") == 0 && errors[0].start_byte == 6);
+  TEST_CHECK(strcmp(errors[1].message, "cannot extend an inline table") == 0 && errors[1].start_byte == 24);
+  TEST_CHECK(strcmp(errors[2].message, "duplicate key") == 0 && errors[2].start_byte == 32);
+  TEST_CHECK(toml_validator_check(validator, tree, source, NULL, 0) == 4);
+  ts_tree_delete(tree);
+}
+
+int main(void) {
+  // one validator for every case, so that its memory is reused between documents
+  TomlValidator *validator = toml_validator_new();
+  for (size_t i = 0; i < sizeof(test__cases) / sizeof(*test__cases); i++) {
+    test__case(validator, &test__cases[i]);
+  }
+  test__several(validator);
+  toml_validator_delete(validator);
+  return test_finish("validate");
+}
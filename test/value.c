@@ -0,0 +1,165 @@
+#include "./test.h"
+#include "value.h"
+#include <math.h>
+
+/*
+ *  Decoding a document into typed values with `toml_document_new`.
+ */
+
+static const TomlValue *test__get(const TomlValue *table, const char *key) {
+  const TomlValue *value = table ? toml_table_get(table, key, (uint32_t)strlen(key)) : NULL;
+  if (!value) fprintf(stderr, "missing key: %s\n", key);
+  return value;
+}
+
+static const TomlValue *test__get_type(const TomlValue *table, const char *key, TomlValueType type) {
+  const TomlValue *value = test__get(table, key);
+  TEST_CHECK(value && value->type == type);
+  return value && value->type == type ? value : NULL;
+}
+
+static void test__datetime(const TomlDatetime *self, int32_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second, uint32_t nanosecond, int16_t offset_minutes) {
+  TEST_CHECK(self->year == year && self->month == month && self->day == day);
+  TEST_CHECK(self->hour == hour && self->minute == minute && self->second == second);
+  TEST_CHECK(self->nanosecond == nanosecond && self->offset_minutes == offset_minutes);
+}
+
+static void test__fixture(void) {
+  uint32_t length;
+  char *source = test_read_file("test/fixtures/values.toml", &length);
+  TSTree *tree = test_parse(source, length);
+
+  TomlError error = {0};
+  TomlDocument *document = toml_document_new(tree, source, &error);
+  TEST_CHECK(document != NULL);
+  if (!document) {
+    fprintf(stderr, "%s at %u\n", error.message, error.start_byte);
+    ts_tree_delete(tree);
+    free(source);
+    return;
+  }
+
+  // nothing may point into the source once the document is built
+  memset(source, 0, length);
+  const TomlValue *root = toml_document_root(document);
+  const TomlValue *value;
+
+  if ((value = test__get_type(root, "basic", TomlValueTypeString))) {
+    TEST_CHECK_STRING(value->as.string, "tab\tquote\" \xc3\xa9 \xf0\x9f\x98\x80");
+  }
+  if ((value = test__get_type(root, "literal", TomlValueTypeString))) {
+    TEST_CHECK_STRING(value->as.string, "C:\\Users\\toml");
+  }
+  if ((value = test__get_type(root, "multiline_basic", TomlValueTypeString))) {
+    TEST_CHECK_STRING(value->as.string, "one two");
+  }
+  if ((value = test__get_type(root, "multiline_literal", TomlValueTypeString))) {
+    TEST_CHECK_STRING(value->as.string, "raw \\n");
+  }
+
+  if ((value = test__get_type(root, "decimal", TomlValueTypeInteger))) TEST_CHECK(value->as.integer == 1000);
+  if ((value = test__get_type(root, "negative", TomlValueTypeInteger))) TEST_CHECK(value->as.integer == -17);
+  if ((value = test__get_type(root, "hex", TomlValueTypeInteger))) TEST_CHECK(value->as.integer == 0xdeadbeef);
+  if ((value = test__get_type(root, "octal", TomlValueTypeInteger))) TEST_CHECK(value->as.integer == 0755);
+  if ((value = test__get_type(root, "binary", TomlValueTypeInteger))) TEST_CHECK(value->as.integer == 13);
+
+  if ((value = test__get_type(root, "fraction", TomlValueTypeFloat))) TEST_CHECK(value->as.floating == 3.1415);
+  if ((value = test__get_type(root, "exponent", TomlValueTypeFloat))) TEST_CHECK(value->as.floating == -2e-3);
+  if ((value = test__get_type(root, "both", TomlValueTypeFloat))) TEST_CHECK(value->as.floating == 6.626070e-34);
+  if ((value = test__get_type(root, "infinity", TomlValueTypeFloat))) TEST_CHECK(value->as.floating == -INFINITY);
+  if ((value = test__get_type(root, "not_a_number", TomlValueTypeFloat))) TEST_CHECK(isnan(value->as.floating));
+
+  if ((value = test__get_type(root, "yes", TomlValueTypeBoolean))) TEST_CHECK(value->as.boolean);
+  if ((value = test__get_type(root, "no", TomlValueTypeBoolean))) TEST_CHECK(!value->as.boolean);
+
+  if ((value = test__get_type(root, "offset_date_time", TomlValueTypeOffsetDateTime))) {
+    test__datetime(&value->as.datetime, 1979, 5, 27, 7, 32, 0, 999999000, -7 * 60);
+  }
+  if ((value = test__get_type(root, "local_date_time", TomlValueTypeLocalDateTime))) {
+    test__datetime(&value->as.datetime, 1979, 5, 27, 0, 32, 0, 0, 0);
+  }
+  if ((value = test__get_type(root, "local_date", TomlValueTypeLocalDate))) {
+    test__datetime(&value->as.datetime, 1979, 5, 27, 0, 0, 0, 0, 0);
+  }
+  if ((value = test__get_type(root, "local_time", TomlValueTypeLocalTime))) {
+    test__datetime(&value->as.datetime, 0, 0, 0, 7, 32, 0, 500000000, 0);
+  }
+
+  if ((value = test__get_type(root, "mixed", TomlValueTypeArray))) {
+    TEST_CHECK(value->as.array.count == 4);
+    if (value->as.array.count == 4) {
+      TomlValue **items = value->as.array.items;
+      TEST_CHECK(items[0]->type == TomlValueTypeInteger && items[0]->as.integer == 1);
+      TEST_CHECK(items[1]->type == TomlValueTypeString);
+      TEST_CHECK(items[2]->type == TomlValueTypeArray && items[2]->as.array.count == 1);
+      TEST_CHECK(test__get_type(items[3], "four", TomlValueTypeInteger) != NULL);
+    }
+  }
+  if ((value = test__get_type(root, "point", TomlValueTypeTable))) {
+    TEST_CHECK(value->flags & TomlValueFlagInline);
+    TEST_CHECK(test__get_type(value, "x", TomlValueTypeInteger) != NULL);
+    value = test__get_type(test__get_type(value, "y", TomlValueTypeTable), "z", TomlValueTypeInteger);
+    TEST_CHECK(value && value->as.integer == 2);
+  }
+
+  value = test__get_type(test__get_type(root, "server", TomlValueTypeTable), "http", TomlValueTypeTable);
+  TEST_CHECK(value && (value->flags & TomlValueFlagDefined));
+  value = test__get_type(value, "port", TomlValueTypeInteger);
+  TEST_CHECK(value && value->as.integer == 8080);
+
+  if ((value = test__get_type(root, "fruit", TomlValueTypeArray))) {
+    TEST_CHECK((value->flags & TomlValueFlagTableArray) && value->as.array.count == 2);
+    if (value->as.array.count == 2) {
+      const TomlValue *name = test__get_type(value->as.array.items[1], "name", TomlValueTypeString);
+      if (name) TEST_CHECK_STRING(name->as.string, "banana");
+    }
+  }
+
+  TEST_CHECK(toml_table_get(root, "missing", 7) == NULL);
+
+  toml_document_delete(document);
+  ts_tree_delete(tree);
+  free(source);
+}
+
+// Enough keys in one table for lookups to go through its hash index.
+static void test__large_table(void) {
+  enum { count = 500 };
+  char *source = malloc(count * 32);
+  uint32_t length = 0;
+  for (int i = 0; i < count; i++) {
+    length += (uint32_t)sprintf(source + length, "key%d = %d\n", i, i);
+  }
+
+  TSTree *tree = test_parse(source, length);
+  TomlDocument *document = toml_document_new(tree, source, NULL);
+  TEST_CHECK(document != NULL);
+  if (document) {
+    const TomlValue *root = toml_document_root(document);
+    TEST_CHECK(root->as.table.count == count);
+    for (int i = 0; i < count; i++) {
+      char key[16];
+      const TomlValue *value = toml_table_get(root, key, (uint32_t)sprintf(key, "key%d", i));
+      TEST_CHECK(value && value->as.integer == i);
+    }
+    TEST_CHECK(toml_table_get(root, "key", 3) == NULL);
+    TEST_CHECK(toml_table_get(root, "key500", 6) == NULL);
+    toml_document_delete(document);
+  }
+  ts_tree_delete(tree);
+
+  // a duplicate far into the table is still found
+  length += (uint32_t)sprintf(source + length, "key321 = 0\n");
+  tree = test_parse(source, length);
+  TomlError error = {0};
+  TEST_CHECK(toml_document_new(tree, source, &error) == NULL);
+  TEST_CHECK(error.message && strcmp(error.message, "duplicate key") == 0);
+  ts_tree_delete(tree);
+  free(source);
+}
+
+int main(void) {
+  test__fixture();
+  test__large_table();
+  return test_finish("value");
+}